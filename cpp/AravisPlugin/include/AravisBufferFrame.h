@@ -0,0 +1,54 @@
+/**
+ * @file AravisBufferFrame.h
+ * @brief Frame object that wraps an ArvBuffer without copying the image data
+ * @date 2026-10-15
+ * Adapted from odin-data, SharedBufferFrame.h
+ */
+
+#ifndef FRAMEPROCESSOR_ARAVISBUFFERFRAME_H_
+#define FRAMEPROCESSOR_ARAVISBUFFERFRAME_H_
+
+#include <boost/function.hpp>
+
+#include "Frame.h"
+
+extern "C" {
+    #include "arv.h"
+}
+
+namespace FrameProcessor
+{
+
+/** @brief Zero-copy frame backed by an ArvBuffer
+ *
+ * The frame points straight into the image data of the buffer it was built
+ * from. The buffer is handed back through the release callback when the frame
+ * is destroyed, i.e. when the last downstream shared_ptr goes out of scope.
+ */
+class AravisBufferFrame : public Frame
+{
+
+public:
+
+    typedef boost::function<void (ArvStream*, ArvBuffer*)> ReleaseCallback;
+
+    AravisBufferFrame(const FrameMetaData& meta_data, ArvStream *stream, ArvBuffer *buffer, const void *data_src,
+                      size_t nbytes, ReleaseCallback release, const int& image_offset = 0);
+    ~AravisBufferFrame();
+
+    void *get_data_ptr() const;
+
+private:
+
+    /** The buffer can only be returned once, so the frame is not copyable */
+    AravisBufferFrame(const AravisBufferFrame& frame);
+    AravisBufferFrame& operator=(const AravisBufferFrame& frame);
+
+    ArvStream *stream_;                                 ///< Stream the buffer was popped from
+    ArvBuffer *buffer_;                                 ///< Buffer owned by this frame
+    void *data_ptr_;                                    ///< Pointer to the image data inside buffer_
+    ReleaseCallback release_;                           ///< Returns buffer_ to stream_
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_ARAVISBUFFERFRAME_H_*/
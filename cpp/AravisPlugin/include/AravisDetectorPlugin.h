@@ -14,9 +14,13 @@
 #define GET_CONFIG_ALL 4
 
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/thread.hpp>
 
 #include <map>
+#include <deque>
+#include <atomic>
 #include <sys/stat.h>
 #include <log4cxx/logger.h>
 #include <log4cxx/basicconfigurator.h>
@@ -28,6 +32,20 @@ using namespace log4cxx::helpers;
 
 #include "FrameProcessorPlugin.h"
 #include "DataBlockFrame.h"
+#include "AravisBufferFrame.h"
+#include "SpscQueue.h"
+#include "BufferArena.h"
+#include "PixelUnpack.h"
+#include "RawFileSource.h"
+#include "LatencyHistogram.h"
+#include "Seqlock.h"
+#include "FeatureTable.h"
+#include "CameraCache.h"
+#include "ClockMapper.h"
+#include "FrameCompressor.h"
+#include "FrameCorrection.h"
+#include "FrameReduction.h"
+#include "ImageStatistics.h"
 #include "ClassLoader.h"
 #include <fstream>
 
@@ -50,7 +68,13 @@ public:
     void status(OdinData::IpcMessage& status);
     bool reset_statistics();
     void status_task();
+    void dispatch_task();
+    void virtual_task();
     void callback_access(ArvStream *stream_temp); 
+    void control_lost();
+    void discovery_task();
+    void recover_camera();
+    void command_task();
 
     int get_version_major();
     int get_version_minor();
@@ -73,12 +97,49 @@ public:
     static const double      DEFAULT_FRAME_RATE;    ///< Frame rate in hertz
     static const unsigned int DEFAULT_FRAME_COUNT;   ///< Frame count
     static const int         DEFAULT_EMPTY_BUFF;    ///< Number of empty buffers used to initialize the stream 
+    static const bool        DEFAULT_ZERO_COPY;     ///< Wrap buffers in frames instead of copying them
+    static const int         DEFAULT_ZERO_COPY_RESERVE; ///< Buffers kept in the stream while in zero copy mode
+    static const bool        DEFAULT_FILL_MISSING;  ///< Push placeholder frames for missing camera frame ids
+    static const int         DEFAULT_CLOCK_WINDOW;  ///< Frames the camera to host clock fit is averaged over
+    static const size_t      DEFAULT_BUFFER_LOG_INTERVAL; ///< Time between summaries of failed buffers in miliseconds
+    static const int         DEFAULT_COMPRESSION_THREADS; ///< Threads compressing frames in the plugin, 0 to not compress
+    static const std::string DEFAULT_COMPRESSION_CODEC;   ///< Blosc compressor used in the plugin
+    static const std::string DEFAULT_COMPRESSION_SHUFFLE; ///< Blosc shuffle used in the plugin
+    static const int         DEFAULT_COMPRESSION_LEVEL;   ///< Blosc compression level used in the plugin
+    static const std::string DEFAULT_DARK_FILE;     ///< Dark frame subtracted from every frame, empty for none
+    static const std::string DEFAULT_GAIN_FILE;     ///< Gain map applied to every frame, empty for none
+    static const unsigned int DEFAULT_BINNING;      ///< Pixels binned together along each axis
+    static const int         DEFAULT_DECIMATION;    ///< Keep one frame in this many
+    static const bool        DEFAULT_IMAGE_STATISTICS; ///< Measure the intensity distribution of every frame
+    static const unsigned int DEFAULT_HISTOGRAM_BINS;///< Bins of the per frame histogram
+    static const int         DEFAULT_BATCH_SIZE;    ///< Images stacked into one frame, 1 for a frame per image
+    static const size_t      DEFAULT_BATCH_TIMEOUT; ///< Age at which a batch that is not full is pushed, in miliseconds
+    static const int         DEFAULT_QUEUE_DEPTH;   ///< Buffers held between the stream callback and the dispatch thread
+    static const std::string DEFAULT_QUEUE_OVERFLOW;///< What the stream callback does when the dispatch queue is full
+    static const bool        DEFAULT_BUFFER_ARENA;  ///< Back the stream buffers with one persistent mapped region
+    static const bool        DEFAULT_HUGEPAGES;     ///< Map the buffer arena on hugepages
+    static const bool        DEFAULT_LOCK_BUFFERS;  ///< Lock the buffer arena into RAM
+    static const bool        DEFAULT_ADAPTIVE_BUFF; ///< Grow the buffer pool under underrun pressure
+    static const int         DEFAULT_BUFF_LOW_WATERMARK; ///< Free buffers below which the pool grows
+    static const size_t      DEFAULT_BUFF_MEMORY_LIMIT_MB; ///< Ceiling on the memory used by stream buffers
+    static const size_t      DEFAULT_BUFF_IDLE_MS;  ///< Time without pressure before extra buffers are freed
+    static const std::string DEFAULT_VIRTUAL_SOURCE;///< Raw file replayed instead of a camera, empty for none
+    static const int         DEFAULT_VIRTUAL_WIDTH; ///< Width of the replayed frames in pixels
+    static const int         DEFAULT_VIRTUAL_HEIGHT;///< Height of the replayed frames in pixels
+    static const double      DEFAULT_VIRTUAL_FRAME_RATE; ///< Replay rate in hertz, 0 for as fast as possible
+    static const size_t      DEFAULT_DISCOVERY_INTERVAL; ///< Minimum time between background device discoveries in miliseconds
+    static const size_t      DEFAULT_PARAMETER_RESYNC;   ///< Time between re-reads of the cached camera parameters in miliseconds, 0 for never
+    static const bool        DEFAULT_ASYNC_COMMANDS;     ///< Run camera operations on the command thread
+    static const std::string DEFAULT_CAMERA_CACHE;       ///< Directory of cached camera states, empty to disable fast reconnect
+    static const bool        DEFAULT_AUTO_RECOVER;       ///< Reconnect and resume streaming when the camera is lost
 
     /** Flags*/
     static const std::string START_STREAM;          ///< starts continuos mode acquisition   
     static const std::string STOP_STREAM;           ///< stops continuos mode acquisition
     static const std::string LIST_DEVICES;          ///< list available devices
     static const std::string ACQUIRE_BUFFER;        ///< acquire an image buffer from the camera
+    static const std::string CAPTURE_DARK;          ///< average the next n frames into the dark frame
+    static const std::string SAVE_DARK;             ///< write the dark frame in use to a file
 
     /** Config names*/
     static const std::string READ_CONFIG;           ///< returns config values for the current connected camera
@@ -87,10 +148,59 @@ public:
     static const std::string CONFIG_FRAME_RATE;     ///< set frame rate in hz
     static const std::string CONFIG_FRAME_COUNT;    ///< set frame count
     static const std::string CONFIG_PIXEL_FORMAT;   ///< set pixel encoding Mono8/ 12bit/ etc
+    static const std::string CONFIG_IMAGE_WIDTH;    ///< set the camera image width in pixels
+    static const std::string CONFIG_IMAGE_HEIGHT;   ///< set the camera image height in pixels
     static const std::string CONFIG_ACQUISITION_MODE;///< set the camera acquisition mode: "Continuous", "SingleFrame","MultiFrame"
     static const std::string CONFIG_CALLBACK;       ///< Choose weather to activate the Aravis callback mechanism for frame acquisition
     static const std::string CONFIG_STATUS_FREQ;    ///< set the status polling frequency in miliseconds
+    static const std::string CONFIG_DISCOVERY_INTERVAL; ///< set the minimum time between background device discoveries in miliseconds
+    static const std::string CONFIG_PARAMETER_RESYNC;   ///< set the time between re-reads of the cached camera parameters in miliseconds
+    static const std::string CONFIG_ASYNC_COMMANDS; ///< run camera operations on the command thread and reply straight away
+    static const std::string CONFIG_FEATURES;       ///< object of GenICam feature names to values to write, or null to read
+    static const std::string CONFIG_CAMERA_CACHE;   ///< directory of cached camera states used to reconnect quickly
+    static const std::string CONFIG_AUTO_RECOVER;   ///< reconnect to the same camera and resume streaming when it is lost
     static const std::string CONFIG_EMPTY_BUFF;     ///< number of empty buffers in a stream object 
+    static const std::string CONFIG_ZERO_COPY;      ///< hand buffers downstream without copying them
+    static const std::string CONFIG_ZERO_COPY_RESERVE; ///< minimum number of buffers left to the camera in zero copy mode
+    static const std::string CONFIG_FILL_MISSING;   ///< push a blank placeholder frame for each missing camera frame id
+    static const std::string CONFIG_CLOCK_WINDOW;   ///< number of frames the camera to host clock fit is averaged over
+    static const std::string CONFIG_BUFFER_LOG_INTERVAL; ///< minimum time between summaries of failed buffers in miliseconds
+    static const std::string CONFIG_COMPRESSION_THREADS; ///< number of threads compressing frames in the plugin, 0 to not compress
+    static const std::string CONFIG_COMPRESSION_CODEC;   ///< Blosc compressor: "blosclz", "lz4", "lz4hc", "zlib", "zstd"
+    static const std::string CONFIG_COMPRESSION_SHUFFLE; ///< Blosc shuffle: "none", "byte", "bit"
+    static const std::string CONFIG_COMPRESSION_LEVEL;   ///< Blosc compression level, 0 to 9
+    static const std::string CONFIG_DARK_FILE;      ///< raw float32 dark frame subtracted from every frame, empty for none
+    static const std::string CONFIG_GAIN_FILE;      ///< raw float32 gain map every frame is multiplied by, empty for none
+    static const std::string CONFIG_ROI_X;          ///< first column of the region of interest cropped in the plugin
+    static const std::string CONFIG_ROI_Y;          ///< first row of the region of interest
+    static const std::string CONFIG_ROI_WIDTH;      ///< columns of the region of interest, 0 for up to the edge
+    static const std::string CONFIG_ROI_HEIGHT;     ///< rows of the region of interest, 0 for up to the edge
+    static const std::string CONFIG_BINNING_X;      ///< columns binned into one pixel in the plugin
+    static const std::string CONFIG_BINNING_Y;      ///< rows binned into one pixel in the plugin
+    static const std::string CONFIG_BINNING_MODE;   ///< binned pixels are the "sum" or the "mean" of their block
+    static const std::string CONFIG_DECIMATION;     ///< push one frame in every n, 1 to push them all
+    static const std::string CONFIG_IMAGE_STATISTICS; ///< add the intensity, range, centroid, rms width and histogram of each frame to its parameters
+    static const std::string CONFIG_HISTOGRAM_BINS; ///< bins of the per frame histogram, 0 or a power of two up to 256
+    static const std::string CONFIG_BATCH_SIZE;     ///< images stacked into one batch x height x width frame, 1 to not batch
+    static const std::string CONFIG_BATCH_TIMEOUT;  ///< time after its first image a batch is pushed even if not full, in miliseconds, 0 to wait
+    static const std::string CONFIG_QUEUE_DEPTH;    ///< capacity of the dispatch queue, applied on the next stream start
+    static const std::string CONFIG_QUEUE_OVERFLOW; ///< dispatch queue overflow policy: "block", "drop_oldest", "drop_newest"
+    static const std::string CONFIG_BUFFER_ARENA;   ///< allocate stream buffers from a persistent arena
+    static const std::string CONFIG_HUGEPAGES;      ///< map the buffer arena on hugepages
+    static const std::string CONFIG_LOCK_BUFFERS;   ///< lock the buffer arena into RAM
+    static const std::string CONFIG_ADAPTIVE_BUFF;  ///< grow and shrink the buffer pool automatically
+    static const std::string CONFIG_BUFF_LOW_WATERMARK; ///< grow the pool when fewer free buffers than this are left
+    static const std::string CONFIG_BUFF_MEMORY_LIMIT;  ///< maximum memory used by stream buffers in megabytes
+    static const std::string CONFIG_BUFF_IDLE_MS;   ///< time without pressure before extra buffers are freed
+    static const std::string CONFIG_VIRTUAL_SOURCE; ///< raw file streamed by start instead of a camera, empty to use the camera
+    static const std::string CONFIG_VIRTUAL_WIDTH;  ///< width of the frames in the virtual source
+    static const std::string CONFIG_VIRTUAL_HEIGHT; ///< height of the frames in the virtual source
+    static const std::string CONFIG_VIRTUAL_FRAME_RATE; ///< virtual source rate in hz, 0 for as fast as possible
+
+    /** Dispatch queue overflow policies */
+    static const std::string QUEUE_OVERFLOW_BLOCK;      ///< wait for the dispatch thread to make room
+    static const std::string QUEUE_OVERFLOW_DROP_OLDEST;///< return the oldest queued buffer to the stream
+    static const std::string QUEUE_OVERFLOW_DROP_NEWEST;///< return the incoming buffer to the stream
     static const std::string CONFIG_CAMERA_ID;      ///< camera's manufacturer id
     static const std::string CONFIG_CAMERA_SERIAL;  ///< camera's serial number
     static const std::string CONFIG_CAMERA_MODEL;   ///< camera's model
@@ -101,9 +211,159 @@ public:
     static const std::string COMPRESSION_TYPE;      ///< compression type used
     static const std::string TEMP_FILES_PATH;       ///< a location to store temporary files like camera xml
 
+    /** Frame parameters */
+    static const std::string PARAM_SYSTEM_TIMESTAMP;///< host time the image was received, in nanoseconds since the epoch
+    static const std::string PARAM_CAMERA_TIMESTAMP;///< camera time the image was taken, in camera clock nanoseconds
+    static const std::string PARAM_FRAME_ID;        ///< frame id given by the camera
+    static const std::string PARAM_MISSING_FRAME;   ///< present on placeholder frames standing in for a missing camera frame
+    static const std::string PARAM_UTC_TIMESTAMP;   ///< camera time the image was taken mapped onto the host clock, in nanoseconds since the epoch
+    static const std::string PARAM_STATS_SUM;       ///< total of all pixels of the frame
+    static const std::string PARAM_STATS_MIN;       ///< smallest pixel of the frame
+    static const std::string PARAM_STATS_MAX;       ///< largest pixel of the frame
+    static const std::string PARAM_STATS_CENTROID_X;///< intensity weighted mean column
+    static const std::string PARAM_STATS_CENTROID_Y;///< intensity weighted mean row
+    static const std::string PARAM_STATS_RMS_X;     ///< intensity weighted rms width along the rows, in columns
+    static const std::string PARAM_STATS_RMS_Y;     ///< intensity weighted rms width along the columns, in rows
+    static const std::string PARAM_STATS_HISTOGRAM; ///< pixel counts of the histogram bins, a std::vector<uint32_t>
+    static const std::string PARAM_BATCH_IMAGES;    ///< images in a batch frame, the slots after them are blank
+    static const std::string PARAM_BATCH_FRAME_IDS; ///< camera frame id of each image of a batch frame, a std::vector<uint64_t>
+    static const std::string PARAM_BATCH_SYSTEM_TIMESTAMPS; ///< system timestamp of each image of a batch frame, 0 for placeholders
+    static const std::string PARAM_BATCH_CAMERA_TIMESTAMPS; ///< camera timestamp of each image of a batch frame
+    static const std::string PARAM_BATCH_UTC_TIMESTAMPS;    ///< utc timestamp of each image of a batch frame, 0 until the clock fit is ready
+
 
 private:
 
+    enum QueueOverflowPolicy { QUEUE_BLOCK, QUEUE_DROP_OLDEST, QUEUE_DROP_NEWEST };
+
+    /** Work run by the command thread, the only thread that talks to the camera */
+    enum CommandKind { COMMAND_CONFIG, COMMAND_REQUEST_CONFIG, COMMAND_POLL, COMMAND_AUTO_STOP };
+
+    /** Intervals of a frame's path measured by the latency histograms, see latency_ */
+    enum LatencyStage { LATENCY_ARAVIS, LATENCY_QUEUE, LATENCY_BUILD, LATENCY_PUSH, LATENCY_TOTAL, LATENCY_JITTER, N_LATENCY_STAGES };
+
+    /** Buffer outcomes counted by buffer_is_valid, one per ArvBufferStatus plus a buffer that is not a buffer and anything unexpected */
+    enum BufferOutcome { BUFFER_SUCCESS, BUFFER_EMPTY, BUFFER_UNKNOWN, BUFFER_CLEARED, BUFFER_TIMEOUT, BUFFER_MISSING_PACKETS,
+                         BUFFER_WRONG_PACKET_ID, BUFFER_SIZE_MISMATCH, BUFFER_FILLING, BUFFER_ABORTED, BUFFER_PAYLOAD_NOT_SUPPORTED,
+                         BUFFER_OTHER, N_BUFFER_OUTCOMES };
+
+    /** Frame counters, published by the thread pushing frames for status() */
+    struct FrameStats
+    {
+        long long frames_made;
+        unsigned long long image_height;
+        unsigned long long image_width;
+        long unsigned int zero_copy_frames;
+        long unsigned int copied_frames;
+        long unsigned int unpacked_frames;
+        long unsigned int corrected_frames;
+        long unsigned int correction_mismatches;
+        unsigned int dark_capture_frames;
+        long unsigned int reduced_frames;
+        long unsigned int decimated_frames;
+        long unsigned int measured_frames;
+        long unsigned int batches_made;
+        long unsigned int partial_batches;
+        long unsigned int frame_gaps;
+        long unsigned int missing_frames;
+        long unsigned int longest_frame_gap;
+        long unsigned int frame_id_wraps;
+        long unsigned int frame_id_resets;
+        long unsigned int placeholder_frames;
+        long unsigned int recovery_dropped_frames;
+        long unsigned int virtual_frames;
+        long unsigned int virtual_late_frames;
+        ClockMapper::Estimate clock;
+    };
+
+    /** Camera values and stream statistics, published by the command thread for status() */
+    struct CameraStats
+    {
+        double exposure_time_us;
+        double frame_rate_hz;
+        size_t payload;
+        int input_buffers;
+        int output_buffers;
+        long unsigned int completed_buffers;
+        long unsigned int failed_buffers;
+        long unsigned int underrun_buffers;
+        long unsigned int liveness_failures;
+        long unsigned int parameter_resyncs;
+        long unsigned int config_restarts;
+        long unsigned int fast_reconnects;
+        long unsigned int recoveries;
+        long unsigned int recovery_attempts;
+        long unsigned int last_recovery_gap_ms;
+        int empty_buffers;                              ///< buffers given to the stream at start, before the adaptive pool adds any
+        size_t arena_bytes;                             ///< bytes mapped by the buffer arena
+        bool arena_hugepages;
+        bool arena_locked;
+        long unsigned int arena_reuses;
+        long unsigned int pool_grows;
+        long unsigned int pool_shrinks;
+        long unsigned int pool_limit_hits;
+    };
+
+    /** Names and modes of the connected camera, copied by the command thread for status() and requestConfiguration() */
+    struct CameraSettings
+    {
+        std::string id;
+        std::string serial;
+        std::string address;
+        std::string model;
+        std::string pixel_format;
+        std::string acquisition_mode;
+    };
+
+    /** Image statistics averaged over the last complete window, published by the thread pushing frames for status() */
+    struct ImageSummary
+    {
+        long unsigned int frames;                       ///< frames measured in the window, 0 before the first window ends
+        double mean_sum;
+        double mean_centroid_x;
+        double mean_centroid_y;
+        double mean_rms_x;
+        double mean_rms_y;
+        uint32_t min;                                   ///< smallest pixel of any frame in the window
+        uint32_t max;                                   ///< largest pixel of any frame in the window
+        unsigned int histogram_bins;
+        uint64_t histogram[ImageStatistics::MAX_HISTOGRAM_BINS];///< pixel counts of all the frames in the window
+    };
+
+    /** A buffer waiting for the dispatch thread */
+    struct QueuedBuffer
+    {
+        ArvBuffer *buffer;                              ///< completed buffer popped from the stream
+        uint64_t callback_time;                         ///< host time the stream callback started, in ns
+    };
+
+    /** Work waiting for the command thread, a configuration is kept encoded as IpcMessage cannot be copied */
+    struct CameraCommand
+    {
+        CommandKind kind;                               ///< a configuration, a configuration request, a status poll or a stop at frame_count
+        uint64_t id;                                    ///< id returned in the configure reply, 0 for the others
+        std::string config;                             ///< encoded configuration message
+        OdinData::IpcMessage *reply;                    ///< reply of a caller waiting for the command, NULL if queued
+        bool *done;                                     ///< set once the command has run, NULL if nobody waits for it
+    };
+
+    /** An image to turn into a frame, from a stream buffer or the virtual source */
+    struct ImageView
+    {
+        const void *data;                               ///< start of the image data
+        size_t size;                                    ///< size of the image data in bytes
+        unsigned long long height;                      ///< image height in pixels
+        unsigned long long width;                       ///< image width in pixels
+        ArvBuffer *buffer;                              ///< buffer holding the image, NULL if it cannot be retained
+        uint64_t system_timestamp;                      ///< host time the image was received in ns, 0 if unknown
+        uint64_t camera_timestamp;                      ///< camera time the image was taken in ns, 0 if unknown
+        uint64_t frame_id;                              ///< frame id given by the camera, 0 if unknown
+        uint64_t callback_time;                         ///< host time the stream callback started in ns, 0 if there was none
+    };
+
+    /** Builds a frame from an image, specialised for one pixel layout. Sets retained if the frame owns the buffer */
+    typedef boost::shared_ptr<Frame> (AravisDetectorPlugin::*FrameBuilder)(const ImageView& image, bool& retained);
+
     /*********************************
     **       Plugin Functions       **
     **********************************/
@@ -114,64 +374,178 @@ private:
     void log_warning(std::string msg);
 
     void get_config(int32_t get_option);
+    void publish_frame_stats();
+    void publish_camera_stats();
+    void publish_camera_settings();
+    void consume_frame_reset();
+    void consume_camera_reset();
 
     void set_file_name(std::string file_id,  OdinData::IpcMessage& reply);
     void set_file_path(std::string new_file_path, OdinData::IpcMessage& reply);
     void set_dataset_name(std::string data_set_name,  OdinData::IpcMessage& reply);
     void set_compression_type(std::string compression_type,  OdinData::IpcMessage& reply);
+    void set_dark_file(std::string dark_file,  OdinData::IpcMessage& reply);
+    void set_gain_file(std::string gain_file,  OdinData::IpcMessage& reply);
+    void capture_dark(int n_frames,  OdinData::IpcMessage& reply);
+    void save_dark(std::string path,  OdinData::IpcMessage& reply);
+    bool update_correction(const std::vector<float>& dark, const std::vector<float>& gain, std::string& error);
+    void set_roi(int x, int y, int width, int height,  OdinData::IpcMessage& reply);
+    void set_binning(int bin_x, int bin_y, std::string mode,  OdinData::IpcMessage& reply);
+    void set_decimation(int decimation,  OdinData::IpcMessage& reply);
+    void set_image_statistics(bool measure_images,  OdinData::IpcMessage& reply);
+    void set_histogram_bins(int histogram_bins,  OdinData::IpcMessage& reply);
+    void set_batch_size(int batch_size,  OdinData::IpcMessage& reply);
+    void set_batch_timeout(int batch_timeout_ms,  OdinData::IpcMessage& reply);
+    void set_compression_threads(int n_threads,  OdinData::IpcMessage& reply);
+    void set_compression_codec(std::string codec,  OdinData::IpcMessage& reply);
+    void set_compression_shuffle(std::string shuffle,  OdinData::IpcMessage& reply);
+    void set_compression_level(int level,  OdinData::IpcMessage& reply);
+    bool start_compression(OdinData::IpcMessage& reply);
     void set_status_poll_frequency(size_t new_frequency,  OdinData::IpcMessage& reply);
+    void set_discovery_interval(size_t interval_ms,  OdinData::IpcMessage& reply);
+    void set_parameter_resync(size_t resync_ms,  OdinData::IpcMessage& reply);
+    void set_async_commands(bool async_commands,  OdinData::IpcMessage& reply);
+    void set_camera_cache_path(std::string cache_path,  OdinData::IpcMessage& reply);
+    void set_auto_recover(bool auto_recover,  OdinData::IpcMessage& reply);
+    bool parameter_resync_due();
     
     /*********************************
     **       Camera Functions       **
     **********************************/
 
     void connect_aravis_camera(std::string ip, OdinData::IpcMessage& reply); 
-    void check_connection();
+    void check_connection(bool read_serial);
+    void release_camera();
     void find_aravis_cameras(OdinData::IpcMessage& reply);
+    unsigned int update_device_list();
+    void request_discovery();
+    bool recovery_due();
+    bool find_device_by_serial(const std::string& serial, std::string& address);
     void get_camera_serial();
     void get_camera_id();
+    void init_camera_state();
+    bool restore_camera_state(OdinData::IpcMessage& reply);
+    void capture_camera_state(CameraState& state);
+    void replay_camera_state(const CameraState& state, OdinData::IpcMessage& reply);
+    void save_camera_state();
 
-    void set_acquisition_mode(std::string acq_mode, OdinData::IpcMessage& reply);
+    bool set_acquisition_mode(std::string acq_mode, OdinData::IpcMessage& reply);
     void get_acquisition_mode();
 
-    void set_exposure(double exposure_time_us, OdinData::IpcMessage& reply);
+    bool set_exposure(double exposure_time_us, OdinData::IpcMessage& reply);
     void get_exposure_bounds();
     void get_exposure();
 
-    void set_frame_rate(double frame_rate_hz, OdinData::IpcMessage& reply);
+    bool set_frame_rate(double frame_rate_hz, OdinData::IpcMessage& reply);
     void get_frame_rate_bounds();
     void get_frame_rate();
 
-    void set_pixel_format(std::string pixel_format,OdinData::IpcMessage& reply);
+    bool set_pixel_format(std::string pixel_format,OdinData::IpcMessage& reply);
     void get_available_pixel_formats();
+    void set_pixel_format_list(const std::vector<std::string>& formats);
     void get_pixel_format();
 
+    bool set_image_width(int width, OdinData::IpcMessage& reply);
+    bool set_image_height(int height, OdinData::IpcMessage& reply);
+    void get_image_size();
+
     void get_frame_size();
 
+    void apply_camera_config(OdinData::IpcMessage& config, OdinData::IpcMessage& reply, bool force = false);
+    bool check_camera_values(OdinData::IpcMessage& config, std::string& invalid);
+
+    void set_features(OdinData::IpcMessage& config, OdinData::IpcMessage& reply);
+    bool write_feature(int index, const std::string& name, const FeatureTable::Input& input, OdinData::IpcMessage& reply);
+    static bool is_modelled_feature(const std::string& name);
+    void refresh_camera_model();
+    void read_features();
+    void report_features(OdinData::IpcMessage& msg, bool with_bounds);
+
+    /**********************************
+    **        Command thread         **
+    ***********************************/
+
+    void apply_configuration(OdinData::IpcMessage& config, OdinData::IpcMessage& reply);
+    bool is_camera_command(OdinData::IpcMessage& config);
+    bool commands_pending();
+    void queue_command(OdinData::IpcMessage& config, OdinData::IpcMessage& reply);
+    void run_command(CommandKind kind, OdinData::IpcMessage *config, OdinData::IpcMessage& reply);
+    void report_configuration(OdinData::IpcMessage& reply);
+    void queue_task(CommandKind kind);
+    void poll_camera();
+    size_t n_queued_configs();
+
     /**********************************
     **    Stream/buffer functions    **
     ***********************************/
 
-    void start_stream(OdinData::IpcMessage& reply);
+    void start_stream(OdinData::IpcMessage& reply, bool resume = false);
     void stop_stream(OdinData::IpcMessage& reply);
     void auto_stop_stream();
 
     void set_frame_count(unsigned int frame_count, OdinData::IpcMessage& reply);
     void set_empty_buffers(int n_empty_buffers, OdinData::IpcMessage& reply);
+    void set_zero_copy(bool zero_copy, OdinData::IpcMessage& reply);
+    void set_zero_copy_reserve(int n_reserve, OdinData::IpcMessage& reply);
+    void set_fill_missing(bool fill_missing, OdinData::IpcMessage& reply);
+    void set_clock_window(int clock_window, OdinData::IpcMessage& reply);
+    void set_buffer_log_interval(size_t interval_ms, OdinData::IpcMessage& reply);
+    void set_queue_depth(int queue_depth, OdinData::IpcMessage& reply);
+    void set_queue_overflow(std::string policy, OdinData::IpcMessage& reply);
+    void set_buffer_arena(bool use_arena, OdinData::IpcMessage& reply);
+    void set_hugepages(bool use_hugepages, OdinData::IpcMessage& reply);
+    void set_lock_buffers(bool lock_buffers, OdinData::IpcMessage& reply);
+    bool prepare_buffer_arena(OdinData::IpcMessage& reply);
+    void set_adaptive_buffers(bool adaptive, OdinData::IpcMessage& reply);
+    void set_buffer_low_watermark(int low_watermark, OdinData::IpcMessage& reply);
+    void set_buffer_memory_limit(size_t limit_mb, OdinData::IpcMessage& reply);
+    void set_buffer_idle_time(size_t idle_ms, OdinData::IpcMessage& reply);
+    void adapt_buffer_pool();
+    void requeue_buffer(ArvStream *stream, ArvBuffer *buffer);
+
+    void start_dispatch_thread();
+    void stop_dispatch_thread();
+    void wait_for_buffer();
+    void enqueue_buffer(ArvStream *stream, const QueuedBuffer& queued);
+
+    void set_virtual_source(std::string path, OdinData::IpcMessage& reply);
+    void set_virtual_width(int width, OdinData::IpcMessage& reply);
+    void set_virtual_height(int height, OdinData::IpcMessage& reply);
+    void set_virtual_frame_rate(double frame_rate_hz, OdinData::IpcMessage& reply);
+    void start_virtual_stream(OdinData::IpcMessage& reply);
+    void stop_virtual_stream();
 
 
     void acquire_n_buffer(unsigned int n_buffers, OdinData::IpcMessage& reply);
     void acquire_buffer();
     bool buffer_is_valid(ArvBuffer *buffer);
-    void process_buffer(ArvBuffer *buffer);
+    bool process_buffer(ArvBuffer *buffer, uint64_t callback_time = 0);
+    bool process_image(const ImageView& image);
+    void push_frame(boost::shared_ptr<Frame> frame);
+    const FrameCorrection::Maps *correction_maps(size_t n_pixels);
+    void add_to_dark(const void *pixels, size_t n_pixels);
+    bool keep_frame();
+    void measure_image(const void *image, FrameMetaData *metadata, uint64_t now);
+    void *add_to_batch(uint64_t frame_id, uint64_t system_timestamp, uint64_t camera_timestamp, uint64_t utc_timestamp);
+    void flush_batch();
+    void flush_stale_batch();
+    uint64_t check_frame_id(uint64_t frame_id);
+    void push_placeholder_frames(uint64_t previous_id, uint64_t n_missing);
+    void record_latency(const ImageView& image, uint64_t dispatch_time, uint64_t built_time, uint64_t pushed_time);
+    void release_buffer(ArvStream *stream, ArvBuffer *buffer);
+
+    template <class Layout> boost::shared_ptr<Frame> build_frame(const ImageView& image, bool& retained);
+    void set_image_parameters(FrameMetaData& metadata, const ImageView& image, uint64_t utc_timestamp);
+    template <class Layout> void use_frame_builder();
+    void select_frame_builder(const std::string& pixel_format);
+    void set_frame_dimensions(unsigned long long height, unsigned long long width);
     
     void get_stream_state();
+    void log_buffer_summary(bool stream_ended = false);
     
     void save_genicam_xml(std::string filepath);
 
 
-    DataType pixel_format_to_datatype(std::string pixel_form);
-
 
     /*********************************
     **        Plugin states         **
@@ -180,8 +554,8 @@ private:
     LoggerPtr logger_;                                  ///< Pointer to logger object for displaying info in terminal
     boost::thread *thread_;                             ///< Pointer to status thread
     bool working_;                                      ///< Is the status thread working?
-    bool streaming_;                                    ///< Is the camera streaming data?
-    bool camera_connected_;                             ///< is the camera connected?
+    std::atomic<bool> streaming_;                       ///< Is the camera streaming data?
+    std::atomic<bool> camera_connected_;                ///< is the camera connected?
     
     size_t status_freq_ms_ {DEFAULT_STATUS_FREQ};        ///< delay between config queries in milliseconds  
     std::string temp_file_path_{DEFAULT_FILE_PATH};     ///< temporary file path for  
@@ -191,13 +565,40 @@ private:
     **       Camera parameters      **
     **********************************/
 
-    ArvCamera *camera_;                                 ///< Pointer to ArvCamera object
+    ArvCamera *camera_ {NULL};                          ///< Pointer to ArvCamera object
     int connected_devices_ {0};
     std::map<std::string, std::pair<std::string, std::string>> available_cameras_;  ///< camera index (camera id, ip address)
+    boost::mutex device_list_mutex_;                    ///< guards the Aravis device list, connected_devices_ and available_cameras_
+    std::atomic<bool> control_lost_ {false};            ///< set by Aravis when the camera stops answering heartbeats
+    gulong control_lost_handler_ {0};                   ///< id of the control-lost handler on the device of camera_, 0 if none
+    size_t discovery_interval_ms_ {DEFAULT_DISCOVERY_INTERVAL};///< minimum time between background discoveries
+    boost::thread *discovery_thread_ {NULL};            ///< Pointer to the last background discovery thread
+    std::atomic<bool> discovering_ {false};             ///< Is a background discovery running?
+    boost::posix_time::ptime last_discovery_;           ///< start of the last background discovery
+    size_t parameter_resync_ms_ {DEFAULT_PARAMETER_RESYNC};///< time between re-reads of the cached camera parameters
+    boost::posix_time::ptime last_resync_;              ///< last time the camera parameters were read from the camera
+    long unsigned int n_parameter_resyncs_ {0};         ///< n of periodic re-reads of the camera parameters
+    std::atomic<long unsigned int> n_discoveries_ {0};  ///< n of discoveries run, in the background or by recovery attempts
+    long unsigned int n_liveness_failures_ {0};         ///< n of times the connected camera failed the liveness check
+    bool auto_recover_ {DEFAULT_AUTO_RECOVER};          ///< reconnect and resume streaming when the camera is lost?
+    std::atomic<bool> recovering_ {false};              ///< Is the lost camera being looked for?
+    bool recovery_resume_stream_ {false};               ///< was the camera streaming when it was lost?
+    CameraState recovery_state_;                        ///< camera state when it was lost, applied again on recovery
+    boost::posix_time::ptime camera_lost_time_;         ///< when the camera was found missing
+    boost::posix_time::ptime last_recovery_attempt_;    ///< when the last recovery attempt was queued
+    long unsigned int n_recoveries_ {0};                ///< n of times the lost camera was recovered
+    long unsigned int n_recovery_attempts_ {0};         ///< n of recovery attempts, successful or not
+    long unsigned int last_recovery_gap_ms_ {0};        ///< time between losing and recovering the camera, last recovery
+    long unsigned int n_recovery_dropped_frames_ {0};   ///< n of camera frames lost with the camera, counted by the thread making frames
+    uint64_t lost_frame_id_ {0};                        ///< camera frame id of the last frame before the camera was lost
+    long unsigned int lost_frames_estimate_ {0};        ///< frames the camera would have sent while lost, at its frame rate
+    bool resumed_stream_ {false};                       ///< has a recovered stream not had its first frame yet?
     std::string camera_id_ {DEFAULT_CAMERA_ID};         ///< camera device id
     std::string camera_serial_ {DEFAULT_CAMERA_SERIAL}; ///< camera serial number
     std::string camera_address_ {DEFAULT_CAMERA_IP};    ///< camera address
     std::string camera_model_{DEFAULT_CAMERA_MODEL};    ///< camera model
+    boost::mutex camera_settings_mutex_;                ///< guards camera_settings_
+    CameraSettings camera_settings_;                    ///< copy of the names and modes above for the other threads
 
     double exposure_time_us_ {DEFAULT_EXPOSURE_TIME};   ///< current exposure time in microseconds
     double min_exposure_time_ {};                       ///< minimum exposure time in microseconds
@@ -209,13 +610,44 @@ private:
 
     unsigned int n_pixel_formats_ {};                   ///< total number of pixel formats
     std::string available_pixel_formats_ {};            ///< a set of available pixel formats in string form
+    std::vector<std::string> pixel_formats_;            ///< the available pixel formats, used to validate a configuration
     std::string pixel_format_ {DEFAULT_PIXEL_FORMAT};   ///< current pixel format
 
     std::string acquisition_mode_ {DEFAULT_AQUISIT_MODE};///< string describing current camera mode: "Continuous", "SingleFrame","MultiFrame"
 
     size_t payload_ {};                                 ///< frame size in bytes
+    int camera_width_px_ {};                            ///< image width set on the camera in pixels
+    int camera_height_px_ {};                           ///< image height set on the camera in pixels
+    int max_width_px_ {};                               ///< largest image width the camera allows now, 0 if unknown
+    int max_height_px_ {};                              ///< largest image height the camera allows now, 0 if unknown
+    long unsigned int n_config_restarts_ {0};           ///< n of stream restarts caused by a configuration changing the payload
+
+    /*********************************
+    **        Command thread        **
+    **********************************/
+
+    bool async_commands_ {DEFAULT_ASYNC_COMMANDS};      ///< run camera operations on the command thread?
+    boost::thread *command_thread_ {NULL};              ///< Pointer to the thread running camera operations
+    boost::mutex command_mutex_;                        ///< guards the command queue and the command results below
+    boost::condition_variable command_cond_;            ///< signals a new command or the end of the thread
+    boost::condition_variable command_done_cond_;       ///< signals a completed command to the callers waiting for one
+    std::atomic<bool> poll_queued_ {false};             ///< Is a status poll waiting on the command thread?
+    bool commands_running_ {true};                      ///< keep the command thread running?
+    std::deque<CameraCommand> commands_;                ///< commands waiting for the command thread
+    uint64_t last_queued_command_ {0};                  ///< id of the last command queued
+    uint64_t running_command_ {0};                      ///< id of the command being run, 0 when idle
+    uint64_t last_completed_command_ {0};               ///< id of the last command run
+    uint64_t last_failed_command_ {0};                  ///< id of the last command that reported an error
+    std::string last_command_error_;                    ///< error reported by last_failed_command_
+
+    FeatureTable feature_table_;                        ///< GenICam features accessed through the features config
+    std::map<std::string, FeatureTable::Input> applied_features_;///< features written through the features config, replayed on reconnect
+
+    std::string camera_cache_path_ {DEFAULT_CAMERA_CACHE};///< directory of cached camera states, empty when disabled
+    long unsigned int n_fast_reconnects_ {0};           ///< n of connections restored from the camera cache
 
     unsigned int frame_count_ {DEFAULT_FRAME_COUNT};    ///< current frame count in MultiFrame mode
+    std::atomic<bool> auto_stop_requested_ {false};     ///< has the stream reached frame_count_ and its stop been queued?
 
 
 
@@ -223,10 +655,15 @@ private:
     **   Stream/buffer parameters    **
     ***********************************/
 
-    ArvStream *stream_;                                 ///< Pointer to ArvStream object. For continuos frame acquisition
+    ArvStream *stream_ {NULL};                          ///< Pointer to ArvStream object. For continuos frame acquisition
 
-    DataType data_type_;                                ///< currently used data_type
+    DataType data_type_ {raw_unknown};                  ///< currently used data_type
     CompressionType compression_type_;                  ///< currently used compression type
+    int n_compression_threads_ {DEFAULT_COMPRESSION_THREADS};///< threads compressing frames in the plugin, 0 if frames leave uncompressed
+    std::string compression_codec_ {DEFAULT_COMPRESSION_CODEC};///< Blosc compressor used in the plugin
+    std::string compression_shuffle_ {DEFAULT_COMPRESSION_SHUFFLE};///< Blosc shuffle used in the plugin
+    int compression_level_ {DEFAULT_COMPRESSION_LEVEL}; ///< Blosc compression level used in the plugin
+    FrameCompressor frame_compressor_;                  ///< compresses frames between the frame builders and push(), running while streaming
 
     std::string data_set_name_ {DEFAULT_DATASET};       ///< name of the data set the plugin is writing to
     std::string file_id_  {DEFAULT_FILE_NAME};          ///< name of the file the plugin is writing to 
@@ -241,9 +678,159 @@ private:
     long unsigned int n_failed_buff_ {0};               ///< n of failed buffers
     long unsigned int n_underrun_buff_ {0};             ///< n of buffers overwritten (stream ran out of empty buffers)
 
+    bool zero_copy_ {DEFAULT_ZERO_COPY};                ///< are buffers wrapped in frames instead of copied?
+    int n_zero_copy_reserve_ {DEFAULT_ZERO_COPY_RESERVE};///< buffers that must stay with the stream in zero copy mode
+    bool stream_zero_copy_ {false};                     ///< zero_copy_ latched at stream start, read by the thread making frames
+    int zero_copy_limit_ {0};                           ///< buffers of the stream that can be held downstream, beyond the adaptive ones
+    std::atomic<int> n_buffers_in_flight_ {0};          ///< n of buffers currently held by downstream frames
+    long unsigned int n_zero_copy_frames_ {0};          ///< n of frames handed downstream without a copy
+    long unsigned int n_copied_frames_ {0};             ///< n of frames copied out of their buffer
+    long unsigned int n_unpacked_frames_ {0};           ///< n of frames unpacked from a packed pixel format
+
+    std::atomic<bool> fill_missing_ {DEFAULT_FILL_MISSING};///< push placeholder frames for missing camera frame ids? set by configure while frames are made
+    uint64_t last_frame_id_ {0};                        ///< camera frame id of the previous image, 0 before the first
+    size_t last_frame_bytes_ {0};                       ///< size of the previous frame's data, the size of placeholders
+    long unsigned int n_frame_gaps_ {0};                ///< n of jumps in the camera frame ids
+    long unsigned int n_missing_frames_ {0};            ///< n of camera frame ids skipped in those jumps
+    long unsigned int longest_frame_gap_ {0};           ///< most frame ids skipped in one jump
+    long unsigned int n_frame_id_wraps_ {0};            ///< n of times the 16 bit GigE Vision frame id wrapped around
+    long unsigned int n_frame_id_resets_ {0};           ///< n of times the camera restarted its frame ids
+    long unsigned int n_placeholder_frames_ {0};        ///< n of placeholder frames pushed for missing frames
+
+    int clock_window_ {DEFAULT_CLOCK_WINDOW};           ///< frames the clock fit is averaged over, applied on the next stream start
+    ClockMapper clock_mapper_;                          ///< fit of the camera clock against the host clock, kept across streams
+
+    PixelUnpack::Format unpack_format_ {PixelUnpack::MONO12_P};///< packed pixel format of the current stream
+    PixelUnpack::Kernel unpack_kernel_ {NULL};          ///< unpacks unpack_format_, NULL if the format is not packed
+
+    std::string dark_file_ {DEFAULT_DARK_FILE};         ///< file the dark frame was loaded from
+    std::string gain_file_ {DEFAULT_GAIN_FILE};         ///< file the gain map was loaded from
+    boost::mutex correction_mutex_;                     ///< guards the maps below, set by configs and dark captures
+    std::vector<float> dark_map_;                       ///< dark frame in use, loaded or captured, empty for none
+    std::vector<float> gain_map_;                       ///< gain map in use, empty for none
+    boost::shared_ptr<const FrameCorrection::Maps> pending_correction_;///< maps built from dark_map_ and gain_map_, empty for no correction
+    std::atomic<bool> correction_changed_ {false};      ///< has pending_correction_ changed since the dispatch thread took it?
+    std::atomic<size_t> correction_pixels_ {0};         ///< size of pending_correction_, for status
+    boost::shared_ptr<const FrameCorrection::Maps> correction_maps_;///< maps applied by the thread making frames
+    FrameCorrection::Kernel correction_kernel_ {NULL};  ///< corrects the pixels of the current stream, NULL if they cannot be corrected
+    bool correction_mismatch_logged_ {false};           ///< was a frame of the wrong size for the maps logged?
+    long unsigned int n_corrected_frames_ {0};          ///< n of frames dark and flat corrected
+    long unsigned int n_correction_mismatches_ {0};     ///< n of frames left uncorrected because their size did not match the maps
+    std::atomic<unsigned int> dark_capture_request_ {0};///< frames to average into a new dark frame, taken by the thread making frames
+    unsigned int dark_capture_target_ {0};              ///< frames in the dark capture under way, 0 if none
+    unsigned int dark_capture_frames_ {0};              ///< frames added to the dark capture so far
+    std::vector<uint32_t> dark_sum_;                    ///< sum of the captured frames, per pixel
+
+    FrameReduction::Settings reduction_settings_ {0, 0, 0, 0, DEFAULT_BINNING, DEFAULT_BINNING, FrameReduction::BIN_SUM};///< region of interest and binning, applied on the next stream start
+    FrameReduction frame_reduction_;                    ///< crops and bins the frames of the current stream
+    bool reduce_frames_ {false};                        ///< are frames of the current size reduced?
+    std::vector<uint8_t> reduction_scratch_;            ///< full frame unpacked or corrected before it is reduced
+    long unsigned int n_reduced_frames_ {0};            ///< n of frames cropped or binned
+    std::atomic<int> decimation_ {DEFAULT_DECIMATION};  ///< one frame in decimation_ is pushed, set by configure while frames are made
+    uint64_t decimation_phase_ {0};                     ///< frames seen by keep_frame() since the stream started
+    long unsigned int n_decimated_frames_ {0};          ///< n of camera frames dropped by decimation
+
+    bool measure_images_ {DEFAULT_IMAGE_STATISTICS};    ///< are image statistics wanted? applied on the next stream start
+    unsigned int histogram_bins_ {DEFAULT_HISTOGRAM_BINS};///< histogram size, applied on the next stream start
+    ImageStatistics image_statistics_;                  ///< measures the frames of the current stream
+    bool measure_stream_ {false};                       ///< can the frames of the current stream be measured?
+    bool measure_frames_ {false};                       ///< are frames of the current size measured?
+    long unsigned int n_measured_frames_ {0};           ///< n of frames whose statistics were added to their parameters
+    ImageSummary image_window_ {};                      ///< totals of the statistics window under way
+    uint64_t image_window_start_ {0};                   ///< start of the statistics window under way, in ns
+
+    int batch_size_ {DEFAULT_BATCH_SIZE};               ///< images per batch frame, applied on the next stream start
+    std::atomic<size_t> batch_timeout_ms_ {DEFAULT_BATCH_TIMEOUT};///< age at which a batch is pushed before it is full, 0 to wait
+    unsigned int stream_batch_size_ {1};                ///< images per batch frame in the current stream, 1 if not batching
+    FrameMetaData batch_metadata_;                      ///< meta data of the batch frames of the current size, batch x height x width
+    boost::shared_ptr<DataBlockFrame> batch_frame_;     ///< batch being filled, empty between batches
+    unsigned int batch_images_ {0};                     ///< images written into batch_frame_
+    uint64_t batch_start_ {0};                          ///< host time batch_frame_ was started, in ns
+    std::vector<uint64_t> batch_frame_ids_;             ///< camera frame id of each image in batch_frame_
+    std::vector<uint64_t> batch_system_timestamps_;     ///< system timestamp of each image in batch_frame_
+    std::vector<uint64_t> batch_camera_timestamps_;     ///< camera timestamp of each image in batch_frame_
+    std::vector<uint64_t> batch_utc_timestamps_;        ///< utc timestamp of each image in batch_frame_
+    long unsigned int n_batches_made_ {0};              ///< n of batch frames pushed in this stream, their frame numbers
+    long unsigned int n_partial_batches_ {0};           ///< n of batch frames pushed before they were full
+
+    boost::thread *dispatch_thread_ {NULL};             ///< Pointer to the thread pushing frames downstream
+    std::atomic<bool> dispatching_ {false};             ///< Is the dispatch thread running?
+    boost::mutex dispatch_wait_mutex_;                  ///< held by the dispatch thread from checking the queue to sleeping on it
+    boost::condition_variable dispatch_wait_cond_;      ///< wakes the dispatch thread when a buffer is queued or it is stopped
+    std::atomic<bool> dispatch_waiting_ {false};        ///< is the dispatch thread asleep on an empty queue, or about to be?
+    boost::scoped_ptr<SpscQueue<QueuedBuffer>> dispatch_queue_;///< buffers waiting for the dispatch thread
+    int queue_depth_ {DEFAULT_QUEUE_DEPTH};             ///< capacity of dispatch_queue_
+    QueueOverflowPolicy queue_overflow_ {QUEUE_BLOCK};  ///< what to do when dispatch_queue_ is full
+    std::string queue_overflow_name_ {DEFAULT_QUEUE_OVERFLOW};///< queue_overflow_ in string form
+    QueueOverflowPolicy stream_queue_overflow_ {QUEUE_BLOCK};///< queue_overflow_ latched at stream start, read by the stream thread
+    std::atomic<int> n_callbacks_active_ {0};           ///< n of stream callbacks that may still queue a buffer
+    std::atomic<long unsigned int> n_queue_size_ {0};   ///< buffers queued, as last seen by the stream or dispatch thread
+    std::atomic<long unsigned int> n_queue_high_water_ {0};///< largest number of buffers queued at once
+    std::atomic<long unsigned int> n_queue_blocked_ {0};///< n of buffers the stream thread had to wait to queue
+    std::atomic<long unsigned int> n_queue_dropped_oldest_ {0};///< n of queued buffers discarded to make room
+    std::atomic<long unsigned int> n_queue_dropped_newest_ {0};///< n of incoming buffers discarded because the queue was full
+
+    BufferArena buffer_arena_;                          ///< persistent memory backing the stream buffers
+    bool use_buffer_arena_ {DEFAULT_BUFFER_ARENA};      ///< are stream buffers taken from buffer_arena_?
+    bool use_hugepages_ {DEFAULT_HUGEPAGES};            ///< should buffer_arena_ be mapped on hugepages?
+    bool lock_buffers_ {DEFAULT_LOCK_BUFFERS};          ///< should buffer_arena_ be locked into RAM?
+    long unsigned int n_arena_reuses_ {0};              ///< n of stream starts that reused buffer_arena_
+
+    bool adaptive_buffers_ {DEFAULT_ADAPTIVE_BUFF};     ///< is the pool grown and shrunk automatically?
+    int buffer_low_watermark_ {DEFAULT_BUFF_LOW_WATERMARK};///< free buffers below which the pool grows
+    size_t buffer_memory_limit_mb_ {DEFAULT_BUFF_MEMORY_LIMIT_MB};///< ceiling on memory used by stream buffers
+    size_t buffer_idle_ms_ {DEFAULT_BUFF_IDLE_MS};      ///< time without pressure before extra buffers are freed
+    std::atomic<int> n_extra_buffers_ {0};              ///< n of buffers added to the stream on top of n_empty_buffers_
+    std::atomic<int> n_buffers_to_shrink_ {0};          ///< n of extra buffers to free as they come back from the camera
+    long unsigned int last_underrun_count_ {0};         ///< n_underrun_buff_ at the previous pool check
+    boost::posix_time::ptime last_pool_pressure_;       ///< last time the pool was short of buffers
+    long unsigned int n_pool_grows_ {0};                ///< n of times buffers were added to the pool
+    long unsigned int n_pool_shrinks_ {0};              ///< n of times the pool was shrunk back
+    long unsigned int n_pool_limit_hits_ {0};           ///< n of times the memory ceiling stopped the pool growing
+
     unsigned long long image_height_px_{0};             ///< image height in pixels
     unsigned long long image_width_px_{0};              ///< image width in pixels
+    unsigned int image_channels_ {1};                   ///< values per pixel, a third dimension when above 1
     std::vector<unsigned long long> frame_dimensions_;  ///< image dimensions for frame creation
+    FrameMetaData frame_metadata_;                      ///< meta data shared by every frame of the stream, only the frame number changes
+    FrameBuilder frame_builder_ {NULL};                 ///< frame builder for the pixel format of the current stream
+    size_t bytes_per_pixel_ {0};                        ///< unpacked size of one pixel of the current stream, 0 if unknown
+
+    std::string virtual_source_ {DEFAULT_VIRTUAL_SOURCE};///< raw file streamed instead of a camera, empty to use the camera
+    int virtual_width_ {DEFAULT_VIRTUAL_WIDTH};         ///< width of the frames in virtual_source_
+    int virtual_height_ {DEFAULT_VIRTUAL_HEIGHT};       ///< height of the frames in virtual_source_
+    double virtual_frame_rate_hz_ {DEFAULT_VIRTUAL_FRAME_RATE};///< replay rate, 0 for as fast as possible
+    RawFileSource virtual_file_;                        ///< mapping of virtual_source_ while it streams
+    boost::thread *virtual_thread_ {NULL};              ///< Pointer to the thread replaying virtual_file_
+    std::atomic<bool> virtual_streaming_ {false};       ///< Is the virtual source streaming?
+    long unsigned int n_virtual_frames_ {0};            ///< n of frames read from virtual_source_
+    long unsigned int n_virtual_late_frames_ {0};       ///< n of virtual frames that missed their slot at the requested rate
+
+    /** Latency of each stage of a frame's path, in ns:
+     * - aravis: host receive (system timestamp) to stream callback
+     * - queue: stream callback to dispatch thread
+     * - build: dispatch thread to frame ready
+     * - push: push() to downstream plugins until it returns
+     * - total: host receive until push() returns
+     * - jitter: difference between the camera and host intervals since the previous frame
+     */
+    LatencyHistogram latency_[N_LATENCY_STAGES];
+    uint64_t last_camera_timestamp_ {0};                ///< camera timestamp of the previous frame, for jitter
+    uint64_t last_system_timestamp_ {0};                ///< system timestamp of the previous frame, for jitter
+    uint64_t fps_window_start_ {0};                     ///< start of the current frame rate window, in ns
+    uint64_t fps_window_frames_ {0};                    ///< frames pushed in the current frame rate window
+    std::atomic<double> rolling_fps_ {0};               ///< frames pushed per second over the last complete window
+
+    std::atomic<uint64_t> buffer_outcomes_[N_BUFFER_OUTCOMES] {};///< n of buffers of each outcome, counted on the stream thread
+    uint64_t logged_buffer_outcomes_[N_BUFFER_OUTCOMES] {};///< buffer_outcomes_ at the last summary, only used by the status thread
+    size_t buffer_log_interval_ms_ {DEFAULT_BUFFER_LOG_INTERVAL};///< minimum time between summaries of failed buffers
+    boost::posix_time::ptime last_buffer_log_;          ///< time of the last summary, or of the first poll after it
+
+    Seqlock<FrameStats> frame_stats_;                   ///< snapshot of the frame counters read by status()
+    Seqlock<CameraStats> camera_stats_;                 ///< snapshot of the camera values and stream statistics read by status()
+    Seqlock<ImageSummary> image_summary_;               ///< image statistics of the last complete window read by status()
+    std::atomic<bool> frame_reset_requested_ {false};   ///< zero the frame counters, taken by the thread making frames
+    std::atomic<bool> camera_reset_requested_ {false};  ///< zero the stream statistics, taken by the command thread
 
 };
 
@@ -0,0 +1,65 @@
+/**
+ * @file BufferArena.h
+ * @brief Pre-allocated memory region that backs the stream buffers
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_BUFFERARENA_H_
+#define FRAMEPROCESSOR_BUFFERARENA_H_
+
+#include <string>
+#include <vector>
+
+extern "C" {
+    #include "arv.h"
+}
+
+namespace FrameProcessor
+{
+
+struct ArenaRegion;
+
+/** @brief A single mmap'd region cut into payload sized, page aligned ArvBuffers
+ *
+ * The region is mapped once, optionally on hugepages and locked into RAM, and
+ * pre-faulted so the first frames after a start do not stall on page faults. The
+ * arena keeps a reference to every buffer so they survive the stream they were
+ * pushed to and can be reused by the next one.
+ *
+ * Each buffer also holds a reference to the region, so the memory is only unmapped
+ * once the arena and every buffer (including any still held by downstream frames)
+ * have been released.
+ */
+class BufferArena
+{
+
+public:
+
+    BufferArena();
+    ~BufferArena();
+
+    bool allocate(size_t payload, size_t n_buffers, bool use_hugepages, bool lock_memory, std::string& error);
+    bool matches(size_t payload, size_t n_buffers, bool use_hugepages, bool lock_memory) const;
+    void release();
+
+    const std::vector<ArvBuffer*>& buffers() const;
+    size_t mapped_bytes() const;
+    bool on_hugepages() const;
+    bool locked() const;
+
+    static const size_t HUGEPAGE_SIZE;                  ///< Size of the hugepages requested with MAP_HUGETLB
+
+private:
+
+    BufferArena(const BufferArena&);
+    BufferArena& operator=(const BufferArena&);
+
+    ArenaRegion *region_;                               ///< Mapped memory, shared with the buffers
+    std::vector<ArvBuffer*> buffers_;                   ///< One buffer per slot of the region
+    size_t payload_;                                    ///< Size of each buffer in bytes
+    bool hugepages_requested_;                          ///< Were hugepages asked for at allocation?
+    bool lock_requested_;                               ///< Was locking asked for at allocation?
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_BUFFERARENA_H_*/
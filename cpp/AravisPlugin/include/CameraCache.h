@@ -0,0 +1,62 @@
+/**
+ * @file CameraCache.h
+ * @brief On disk cache of each camera's description and last applied configuration
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_CAMERACACHE_H_
+#define FRAMEPROCESSOR_CAMERACACHE_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FeatureTable.h"
+
+namespace FrameProcessor
+{
+
+/** @brief What the plugin knows about a camera, enough to reconnect without reading it back */
+struct CameraState
+{
+    std::string serial;                                 ///< device serial number, the cache key
+    std::string model;                                  ///< model name
+    std::string id;                                     ///< device id
+    double min_exposure_time {0};                       ///< exposure time bounds in microseconds
+    double max_exposure_time {0};
+    double exposure_time_us {0};                        ///< last applied exposure time in microseconds
+    double min_frame_rate {0};                          ///< frame rate bounds in hertz
+    double max_frame_rate {0};
+    double frame_rate_hz {0};                           ///< last applied frame rate in hertz
+    std::vector<std::string> pixel_formats;             ///< pixel formats the camera offers
+    std::string pixel_format;                           ///< last applied pixel format
+    std::string acquisition_mode;                       ///< last applied acquisition mode
+    int width {0};                                      ///< last applied image width in pixels
+    int height {0};                                     ///< last applied image height in pixels
+    size_t payload {0};                                 ///< payload of the last applied configuration in bytes
+    std::vector<std::pair<std::string, FeatureTable::Input>> features; ///< features written through the features config
+};
+
+/** @brief Directory of camera states, one text file per serial number
+ *
+ * Each file holds one "key<TAB>value" line per field, so it can be read and edited
+ * by hand. Files are written to a temporary name and renamed into place, so a crash
+ * never leaves a partial state behind.
+ */
+class CameraCache
+{
+
+public:
+
+    static bool load(const std::string& directory, const std::string& serial, CameraState& state, std::string& error);
+    static bool save(const std::string& directory, const CameraState& state, std::string& error);
+    static bool save_xml(const std::string& directory, const std::string& serial, const char *xml, size_t length, std::string& error);
+
+private:
+
+    static std::string state_path(const std::string& directory, const std::string& serial);
+    static bool make_directory(const std::string& directory, std::string& error);
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_CAMERACACHE_H_*/
@@ -0,0 +1,96 @@
+/**
+ * @file ClockMapper.h
+ * @brief Online estimate of the camera clock's offset and drift against the host clock
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_CLOCKMAPPER_H_
+#define FRAMEPROCESSOR_CLOCKMAPPER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace FrameProcessor
+{
+
+/** @brief Maps camera timestamps onto the host wall clock
+ *
+ * Every frame gives a pair of timestamps: the camera's tick counter when the image
+ * was taken and the host clock when the buffer was received. The host time also
+ * holds the transfer and interrupt delay, so it is the camera time, plus an offset
+ * that slowly drifts, plus a delay that is only ever added. The mapper fits the 
+ * lower envelope of the pairs, the ones delayed least: the pairs are split into 
+ * blocks, and a line is fitted through the quickest pair of each block with 
+ * exponentially weighted least squares over about the last window frames. A camera
+ * time mapped through that line is the host time the image was taken plus the 
+ * smallest transfer delay, rather than the mean one.
+ *
+ * Blocks whose quickest pair is still much later than the fit are skipped; a window
+ * of them in a row means the host clock was stepped, and starts a new fit.
+ *
+ * Times are kept relative to the first pair of the fit so the doubles only hold
+ * small numbers. A camera clock that goes back or jumps by more than a second
+ * starts a new fit. Not thread safe: one thread adds and maps.
+ */
+class ClockMapper
+{
+
+public:
+
+    /** State of the fit, for status */
+    struct Estimate
+    {
+        bool ready;                                     ///< enough pairs to map camera times?
+        int64_t offset_ns;                              ///< host time minus camera time at the last pair
+        double drift_ppm;                               ///< host clock rate relative to the camera clock, in parts per million
+        double jitter_ns;                               ///< weighted rms of the residuals of the block minima fitted
+        double max_residual_ns;                         ///< largest residual of a block minimum fitted since the last reset
+        uint64_t samples;                               ///< pairs added since the last reset
+        uint64_t outliers;                              ///< blocks skipped as late since the last reset
+        uint64_t resets;                                ///< fits restarted because the camera clock jumped
+    };
+
+    ClockMapper();
+
+    void set_window(size_t window);
+    void add(uint64_t camera_ns, uint64_t system_ns);
+    uint64_t map(uint64_t camera_ns) const;
+    Estimate estimate() const;
+    void reset();
+
+private:
+
+    static const uint64_t MIN_MINIMA = 8;               ///< block minima needed before mapping
+    static const size_t WINDOW_BLOCKS = 16;             ///< blocks in a window, each giving the fit its quickest pair
+    static const int64_t RESET_NS = 1000000000;         ///< residual treated as a camera clock jump
+    static const int64_t MIN_OUTLIER_NS = 100000;       ///< residuals below this are never skipped
+
+    void restart(uint64_t camera_ns, uint64_t system_ns);
+    double predict(double x) const;
+    void fit(double x, double y);
+
+    double weight_;                                     ///< weight lost by the older minima at each new one, block_size_/window
+    size_t block_size_;                                 ///< pairs in a block
+    uint64_t camera0_;                                  ///< camera time of the first pair of the fit
+    uint64_t system0_;                                  ///< host time of the first pair of the fit
+    uint64_t last_camera_;                              ///< camera time of the last pair
+    double sum_weights_;                                ///< sum of the weights of the pairs used
+    double mean_x_;                                     ///< weighted mean camera time, in seconds from camera0_
+    double mean_y_;                                     ///< weighted mean offset from the first pair, in ns
+    double var_x_;                                      ///< weighted variance of the camera times
+    double cov_xy_;                                     ///< weighted covariance of camera times and offsets
+    double mean_r2_;                                    ///< weighted mean squared residual
+    double max_residual_;                               ///< largest residual of a pair used
+    double last_x_;                                     ///< camera time of the last pair, in seconds from camera0_
+    size_t block_pairs_;                                ///< pairs added to the block under way
+    double block_x_;                                    ///< camera time of the quickest pair of the block under way
+    double block_y_;                                    ///< offset of the quickest pair of the block under way
+    uint64_t samples_;
+    uint64_t minima_;                                   ///< block minima fitted
+    uint64_t outliers_;
+    uint64_t consecutive_outliers_;                     ///< blocks skipped in a row, a step in the host clock if it reaches the window
+    uint64_t resets_;
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_CLOCKMAPPER_H_*/
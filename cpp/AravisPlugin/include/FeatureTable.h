@@ -0,0 +1,99 @@
+/**
+ * @file FeatureTable.h
+ * @brief Cached GenICam feature nodes, resolved once per camera connection
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_FEATURETABLE_H_
+#define FRAMEPROCESSOR_FEATURETABLE_H_
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <boost/thread.hpp>
+
+extern "C" {
+    #include "arv.h"
+}
+
+namespace FrameProcessor
+{
+
+/** @brief Flat table of GenICam features accessed by name
+ *
+ * The first access to a feature looks its node up in the GenICam tree and keeps the
+ * handle along with the feature's type and bounds, so later reads and writes go
+ * straight to the node. Handles belong to the device they were resolved on and are
+ * dropped with reset() when the camera changes.
+ *
+ * Reads and writes talk to the camera outside the table's lock, so snapshot() never
+ * waits on the camera for long. A lookup holds the lock from the search to the insert,
+ * so a feature is only added once. Reads and writes of one feature must still come 
+ * from one thread at a time; the plugin makes them all on its command thread.
+ */
+class FeatureTable
+{
+
+public:
+
+    enum Type { FEATURE_INTEGER, FEATURE_FLOAT, FEATURE_BOOLEAN, FEATURE_ENUMERATION, FEATURE_STRING, FEATURE_COMMAND };
+
+    /** A value to write, as it came in the configuration */
+    struct Input
+    {
+        enum Kind { INPUT_INTEGER, INPUT_NUMBER, INPUT_BOOLEAN, INPUT_TEXT };
+        Kind kind;                                      ///< which of the values below is set
+        int64_t integer;                                ///< value of an INPUT_INTEGER
+        double number;                                  ///< value of an INPUT_NUMBER
+        bool boolean;                                   ///< value of an INPUT_BOOLEAN
+        std::string text;                               ///< value of an INPUT_TEXT
+    };
+
+    /** The cached state of a feature */
+    struct Value
+    {
+        std::string name;                               ///< GenICam feature name
+        Type type;                                      ///< GenICam node type
+        bool known;                                     ///< has the value been read from the camera?
+        int64_t integer;                                ///< value of an integer feature
+        double number;                                  ///< value of a float feature
+        bool boolean;                                   ///< value of a boolean feature
+        std::string text;                               ///< value of an enumeration or string feature
+        double min;                                     ///< lower bound of a numeric feature
+        double max;                                     ///< upper bound of a numeric feature
+    };
+
+    FeatureTable();
+
+    void reset(ArvDevice *device);
+    int resolve(const std::string& name, std::string& error);
+    bool read(int index, std::string& error);
+    bool write(int index, const Input& input, std::string& error);
+
+    size_t size() const;
+    bool type(int index, Type& type) const;
+    void snapshot(std::vector<Value>& values) const;
+
+    static const char *type_name(Type type);
+
+private:
+
+    /** A resolved feature, its node handle and cached state */
+    struct Entry
+    {
+        ArvGcNode *node;                                ///< node in the GenICam tree of device_
+        Value value;                                    ///< cached state, guarded by mutex_
+    };
+
+    FeatureTable(const FeatureTable&);
+    FeatureTable& operator=(const FeatureTable&);
+
+    ArvDevice *device_;                                 ///< device the nodes were resolved on
+    std::vector<Entry> entries_;                        ///< resolved features in order of first use
+    std::unordered_map<std::string, int> index_;        ///< feature name to position in entries_
+    mutable boost::mutex mutex_;                        ///< guards entries_ and index_
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_FEATURETABLE_H_*/
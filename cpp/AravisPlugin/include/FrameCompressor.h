@@ -0,0 +1,109 @@
+/**
+ * @file FrameCompressor.h
+ * @brief Pool of threads compressing frames with Blosc, delivering them in order
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_FRAMECOMPRESSOR_H_
+#define FRAMEPROCESSOR_FRAMECOMPRESSOR_H_
+
+#include <cstdint>
+#include <map>
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+
+#include "Frame.h"
+#include "LatencyHistogram.h"
+
+namespace FrameProcessor
+{
+
+/** @brief Compresses frames on a pool of worker threads
+ *
+ * Each frame's image is compressed with Blosc (a codec such as lz4 behind a byte or
+ * bit shuffle) into a new frame holding one HDF5 chunk, marked with the blosc
+ * compression type so the file writer can write it as is. Frames are handed to the
+ * sink in the order they were submitted, whichever worker finishes first; a frame
+ * that fails to compress is handed on uncompressed.
+ *
+ * submit() blocks while two frames per worker are in flight, so a slow pool pushes
+ * back on the thread submitting. Only one thread may submit, and the sink is only
+ * ever called by one thread at a time.
+ *
+ * Needs the plugin to be built with Blosc; available() tells if it was.
+ */
+class FrameCompressor
+{
+
+public:
+
+    typedef boost::function<void(boost::shared_ptr<Frame>)> Sink;
+
+    /** Totals since the last reset */
+    struct Stats
+    {
+        uint64_t frames;                                ///< frames compressed
+        uint64_t bytes_in;                              ///< image bytes of those frames
+        uint64_t bytes_out;                             ///< compressed bytes of those frames
+        uint64_t failures;                              ///< frames handed on uncompressed
+    };
+
+    FrameCompressor();
+    ~FrameCompressor();
+
+    static bool available();
+    static bool check_settings(const std::string& codec, const std::string& shuffle, int level, std::string& error);
+
+    bool start(unsigned int n_threads, const std::string& codec, const std::string& shuffle, int level, Sink sink, std::string& error);
+    void stop();
+    bool running() const;
+
+    void submit(boost::shared_ptr<Frame> frame);
+
+    Stats stats() const;
+    size_t in_flight() const;
+    const LatencyHistogram& compress_time() const;
+    void reset_statistics();
+
+private:
+
+    /** A frame waiting for a worker */
+    struct Job
+    {
+        uint64_t sequence;                              ///< position in submission order
+        boost::shared_ptr<Frame> frame;                 ///< frame to compress
+    };
+
+    FrameCompressor(const FrameCompressor&);
+    FrameCompressor& operator=(const FrameCompressor&);
+
+    void worker_task();
+    boost::shared_ptr<Frame> compress(const boost::shared_ptr<Frame>& frame, bool& compressed);
+    void deliver(uint64_t sequence, boost::shared_ptr<Frame> frame);
+
+    std::vector<boost::thread*> workers_;               ///< worker threads, empty when stopped
+    Sink sink_;                                         ///< receives frames in submission order
+    std::string codec_;                                 ///< Blosc compressor name
+    int shuffle_;                                       ///< Blosc shuffle mode
+    int level_;                                         ///< Blosc compression level
+
+    mutable boost::mutex mutex_;                        ///< guards everything below
+    boost::condition_variable jobs_cond_;               ///< signals a new job or the end of the workers
+    boost::condition_variable done_cond_;               ///< signals a frame handed to the sink
+    bool stopping_;                                     ///< are the workers to exit?
+    std::deque<Job> jobs_;                              ///< frames waiting for a worker
+    std::map<uint64_t, boost::shared_ptr<Frame> > done_;///< compressed frames waiting for the ones before them
+    uint64_t next_sequence_;                            ///< sequence of the next submitted frame
+    uint64_t next_output_;                              ///< sequence of the next frame for the sink
+    bool delivering_;                                   ///< is a thread handing frames to the sink?
+    size_t max_in_flight_;                              ///< frames submitted but not yet delivered, at most
+    Stats stats_;
+    LatencyHistogram compress_time_;                    ///< time to compress each frame, in ns, recorded under mutex_
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_FRAMECOMPRESSOR_H_*/
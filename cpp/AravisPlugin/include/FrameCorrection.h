@@ -0,0 +1,57 @@
+/**
+ * @file FrameCorrection.h
+ * @brief Kernels applying dark frame subtraction and flat field correction to 8 and 16 bit pixels
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_FRAMECORRECTION_H_
+#define FRAMEPROCESSOR_FRAMECORRECTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PixelUnpack.h"
+
+namespace FrameProcessor
+{
+
+/** @brief Computes (raw - dark) * gain for every pixel of a frame
+ *
+ * The dark frame and the gain map hold one float per pixel. Results are rounded to
+ * the nearest integer and saturated to the range of the pixel type, so pixels
+ * darker than the dark frame become 0 and bright ones stop at 255 or 65535.
+ *
+ * Each depth has a scalar kernel and, on x86, SSE4.1 and AVX2 kernels chosen at run
+ * time with PixelUnpack::best_isa(). The kernels read the source buffer and write
+ * the final frame, so correcting replaces the copy out of the ArvBuffer. src and
+ * dst may be the same buffer.
+ */
+class FrameCorrection
+{
+
+public:
+
+    enum Depth { DEPTH_8, DEPTH_16 };
+
+    /** Corrects n_pixels pixels of the given depth from src into dst */
+    typedef void (*Kernel)(const void *src, void *dst, const float *dark, const float *gain, size_t n_pixels);
+
+    /** Dark frame and gain map of one frame size */
+    struct Maps
+    {
+        std::vector<float> dark;                        ///< value subtracted from each pixel
+        std::vector<float> gain;                        ///< factor applied to each pixel after the dark
+    };
+
+    static Kernel kernel(Depth depth, PixelUnpack::Isa isa);
+    static Kernel kernel(Depth depth);
+
+    static bool load_map(const std::string& path, std::vector<float>& map, std::string& error);
+    static bool save_map(const std::string& path, const std::vector<float>& map, std::string& error);
+    static bool make_maps(const std::vector<float>& dark, const std::vector<float>& gain, Maps& maps, std::string& error);
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_FRAMECORRECTION_H_*/
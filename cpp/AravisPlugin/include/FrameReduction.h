@@ -0,0 +1,87 @@
+/**
+ * @file FrameReduction.h
+ * @brief Crops a region of interest out of 8 and 16 bit frames and bins its pixels
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_FRAMEREDUCTION_H_
+#define FRAMEPROCESSOR_FRAMEREDUCTION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "PixelUnpack.h"
+
+namespace FrameProcessor
+{
+
+/** @brief Makes a smaller image from a region of interest of a frame
+ *
+ * The region is cut out of the source image and every bin_x by bin_y block of it
+ * becomes one pixel, the sum or the rounded mean of the block. Rows and columns
+ * left over at the edge of the region that do not fill a whole block are dropped.
+ * Means keep the source depth; sums widen to 16 bits for 8 bit sources when they
+ * fit, otherwise to 32 bits, so they never overflow.
+ *
+ * The image is processed one output row at a time: the bin_y source rows of the
+ * row are added into a row of 32 bit sums, which stays in the L1 cache, with a
+ * scalar, SSE4.1 or AVX2 kernel chosen at run time, then the bin_x neighbours of
+ * each sum are added and written out. Each source row is read once, straight from
+ * the source buffer. Without binning the rows of the region are only copied.
+ *
+ * Not thread safe: one thread fits and reduces.
+ */
+class FrameReduction
+{
+
+public:
+
+    enum Mode { BIN_SUM, BIN_MEAN };
+
+    /** Region of interest and binning */
+    struct Settings
+    {
+        size_t x;                                       ///< first column of the region
+        size_t y;                                       ///< first row of the region
+        size_t width;                                   ///< columns in the region, 0 for up to the right edge
+        size_t height;                                  ///< rows in the region, 0 for up to the bottom edge
+        unsigned int bin_x;                             ///< columns added into one pixel
+        unsigned int bin_y;                             ///< rows added into one pixel
+        Mode mode;                                      ///< sum or mean of each block
+    };
+
+    FrameReduction();
+
+    static bool mode_from_string(const std::string& name, Mode& mode);
+    static const char *mode_name(Mode mode);
+
+    void configure(const Settings& settings, size_t bytes_per_pixel, PixelUnpack::Isa isa);
+    void configure(const Settings& settings, size_t bytes_per_pixel);
+    bool active() const;
+    bool fit(size_t height, size_t width, std::string& error);
+
+    size_t height() const;
+    size_t width() const;
+    size_t bytes_per_pixel() const;
+    size_t frame_bytes() const;
+
+    void reduce(const void *src, void *dst);
+
+private:
+
+    typedef void (*RowKernel)(const void *src, uint32_t *sums, size_t n_pixels);
+
+    Settings settings_;
+    size_t in_bytes_;                                   ///< bytes per source pixel, 1 or 2
+    size_t out_bytes_;                                  ///< bytes per reduced pixel, 1, 2 or 4
+    RowKernel add_row_;                                 ///< adds a source row into sums_
+    size_t src_width_;                                  ///< columns of the source image fitted
+    size_t out_height_;                                 ///< rows of the reduced image
+    size_t out_width_;                                  ///< columns of the reduced image
+    std::vector<uint32_t> sums_;                        ///< sums of the source rows of one output row
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_FRAMEREDUCTION_H_*/
@@ -0,0 +1,82 @@
+/**
+ * @file ImageStatistics.h
+ * @brief Total intensity, range, centroid, rms width and histogram of a frame in one pass
+ * @date 2026-10-16
+ */
+
+#ifndef FRAMEPROCESSOR_IMAGESTATISTICS_H_
+#define FRAMEPROCESSOR_IMAGESTATISTICS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "PixelUnpack.h"
+
+namespace FrameProcessor
+{
+
+/** @brief Measures the intensity distribution of 8 and 16 bit single channel images
+ *
+ * One pass over the image, a row at a time, adds each row into per column sums and
+ * into the row's total and keeps the smallest and largest pixel, with a scalar,
+ * SSE4.1 or AVX2 kernel chosen at run time; the histogram is then filled from the
+ * same row while it is still in L1. The centroid and rms width along each axis come
+ * from the column and row totals afterwards, so no pixel is multiplied by its
+ * coordinates. The histogram has a power of two number of bins spread evenly over
+ * the range of the pixel type.
+ *
+ * Images may be up to MAX_HEIGHT rows high, so the 32 bit column sums cannot overflow.
+ * Not thread safe: one thread configures and measures.
+ */
+class ImageStatistics
+{
+
+public:
+
+    static const unsigned int MAX_HISTOGRAM_BINS = 256;
+    static const size_t MAX_HEIGHT = 65536;             ///< most rows measure() takes
+
+    /** Statistics of one image */
+    struct Result
+    {
+        uint64_t sum;                                   ///< total of all pixels
+        uint32_t min;                                   ///< smallest pixel
+        uint32_t max;                                   ///< largest pixel
+        double centroid_x;                              ///< intensity weighted mean column, 0 for a blank image
+        double centroid_y;                              ///< intensity weighted mean row, 0 for a blank image
+        double rms_x;                                   ///< intensity weighted rms distance from centroid_x, in columns
+        double rms_y;                                   ///< intensity weighted rms distance from centroid_y, in rows
+    };
+
+    ImageStatistics();
+
+    static bool valid_histogram_bins(unsigned int histogram_bins);
+
+    bool configure(size_t bytes_per_pixel, unsigned int histogram_bins, PixelUnpack::Isa isa);
+    bool configure(size_t bytes_per_pixel, unsigned int histogram_bins);
+    void measure(const void *image, size_t height, size_t width, Result& result);
+    const std::vector<uint32_t>& histogram() const;
+
+    /** Totals of one row, filled in by a row kernel */
+    struct RowTotals
+    {
+        uint64_t sum;
+        uint32_t min;
+        uint32_t max;
+    };
+
+private:
+
+    typedef void (*RowKernel)(const void *row, size_t n_pixels, uint32_t *column_sums, RowTotals& totals);
+
+    size_t bytes_per_pixel_;                            ///< 1 or 2
+    unsigned int histogram_shift_;                      ///< pixel bits dropped to get a histogram bin
+    RowKernel scan_row_;                                ///< sums and range of one row
+    std::vector<uint32_t> column_sums_;                 ///< sum of each column of the image being measured
+    std::vector<uint32_t> histogram_;                   ///< histogram of the last image measured, empty if disabled
+    std::vector<uint32_t> partial_histograms_;          ///< four interleaved histograms, so consecutive pixels rarely bump the same counter
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_IMAGESTATISTICS_H_*/
@@ -0,0 +1,60 @@
+/**
+ * @file LatencyHistogram.h
+ * @brief Fixed size log-linear histogram for per-frame latencies
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_LATENCYHISTOGRAM_H_
+#define FRAMEPROCESSOR_LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace FrameProcessor
+{
+
+/** @brief HDR style histogram of nanosecond latencies
+ *
+ * Values below 16 ns get a bucket each, above that every power of two is split into
+ * 16 buckets, so any recorded value is reported to within about 6%. Values from 
+ * 2^40 ns (about 18 minutes) up share the last bucket.
+ *
+ * Recording is a couple of relaxed atomic operations with no allocation, so it can
+ * be done for every frame. There must be a single recording thread; any thread may 
+ * read. A reset while recording may lose the samples recorded during it.
+ */
+class LatencyHistogram
+{
+
+public:
+
+    LatencyHistogram();
+
+    void record(uint64_t value_ns);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t max() const;
+    uint64_t percentile(double fraction) const;
+
+private:
+
+    static const int SUB_BUCKET_BITS = 4;
+    static const size_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_BITS = 40;
+    static const size_t N_BUCKETS = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    static size_t bucket_of(uint64_t value_ns);
+    static uint64_t value_of(size_t bucket);
+
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+    std::atomic<uint64_t> buckets_[N_BUCKETS];          ///< Number of samples in each bucket
+    std::atomic<uint64_t> count_;                       ///< Total number of samples
+    std::atomic<uint64_t> max_;                         ///< Largest sample
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_LATENCYHISTOGRAM_H_*/
@@ -0,0 +1,49 @@
+/**
+ * @file PixelUnpack.h
+ * @brief Kernels that unpack Mono10/Mono12 packed pixel formats into 16 bit pixels
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_PIXELUNPACK_H_
+#define FRAMEPROCESSOR_PIXELUNPACK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace FrameProcessor
+{
+
+/** @brief Unpacks packed monochrome pixel formats into one uint16_t per pixel
+ *
+ * Supported formats:
+ * - Mono10p / Mono12p (GenICam PFNC): pixels are packed back to back, least significant bit first
+ * - Mono10Packed / Mono12Packed (GigE Vision): two pixels in three bytes, the
+ *   low bits of both pixels share the middle byte
+ *
+ * Each format has a scalar kernel and, on x86, SSE4.1 and AVX2 kernels chosen at
+ * run time. The kernels read straight from the source buffer and write the final
+ * frame, so unpacking replaces the copy out of the ArvBuffer.
+ */
+class PixelUnpack
+{
+
+public:
+
+    enum Format { MONO10_P, MONO12_P, MONO10_PACKED, MONO12_PACKED };
+    enum Isa { ISA_SCALAR, ISA_SSE41, ISA_AVX2 };
+
+    /** Unpacks n_pixels pixels from src into dst */
+    typedef void (*Kernel)(const uint8_t *src, uint16_t *dst, size_t n_pixels);
+
+    static bool format_from_string(const std::string& pixel_format, Format& format);
+    static size_t packed_bytes(Format format, size_t n_pixels);
+
+    static Isa best_isa();
+    static const char *isa_name(Isa isa);
+    static Kernel kernel(Format format, Isa isa);
+    static Kernel kernel(Format format);
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_PIXELUNPACK_H_*/
@@ -0,0 +1,49 @@
+/**
+ * @file RawFileSource.h
+ * @brief Memory mapped file of raw frames replayed by the virtual camera
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_RAWFILESOURCE_H_
+#define FRAMEPROCESSOR_RAWFILESOURCE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace FrameProcessor
+{
+
+/** @brief A read only mapping of a file holding back to back frames
+ *
+ * The file has no header: frame i starts at i * frame_bytes. Any trailing partial
+ * frame is ignored. The mapping is pre-faulted so replay does not measure disk reads.
+ */
+class RawFileSource
+{
+
+public:
+
+    RawFileSource();
+    ~RawFileSource();
+
+    bool open(const std::string& path, size_t frame_bytes, std::string& error);
+    void close();
+
+    bool is_open() const;
+    size_t n_frames() const;
+    size_t frame_bytes() const;
+    const void *frame(size_t index) const;
+
+private:
+
+    RawFileSource(const RawFileSource&);
+    RawFileSource& operator=(const RawFileSource&);
+
+    void *base_;                                        ///< Start of the mapping, NULL when closed
+    size_t size_;                                       ///< Length of the mapping in bytes
+    size_t frame_bytes_;                                ///< Size of each frame in bytes
+    size_t n_frames_;                                   ///< Number of whole frames in the file
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_RAWFILESOURCE_H_*/
@@ -0,0 +1,90 @@
+/**
+ * @file Seqlock.h
+ * @brief Publishes a small struct of statistics to readers that must never block the writer
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_SEQLOCK_H_
+#define FRAMEPROCESSOR_SEQLOCK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace FrameProcessor
+{
+
+/** @brief Sequence lock around a trivially copyable value
+ *
+ * A writer bumps the sequence to an odd number, stores the value and bumps it back
+ * to even. A reader copies the value and retries if the sequence was odd or changed
+ * meanwhile, so it always gets a consistent snapshot without taking a lock and
+ * without ever making the writer wait.
+ *
+ * The value is kept in relaxed atomic words rather than plain memory, so the copy a
+ * reader discards is not a data race. Writers are serialised by a mutex, which is
+ * uncontended when, as intended, one thread does nearly all the writing. The whole 
+ * object is cache line aligned so it shares no line with the writer's other data.
+ */
+template <typename T>
+class alignas(64) Seqlock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock values must be trivially copyable");
+
+public:
+
+    Seqlock() : sequence_(0)
+    {
+        store(T());
+    }
+
+    /** @brief Publishes a new value */
+    void write(const T& value)
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        size_t sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        store(value);
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /** @brief Returns the last published value */
+    T read() const
+    {
+        uint64_t words[N_WORDS];
+        size_t before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < N_WORDS; i++)
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+
+    static const size_t N_WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    void store(const T& value)
+    {
+        uint64_t words[N_WORDS] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (size_t i = 0; i < N_WORDS; i++)
+            words_[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    std::atomic<size_t> sequence_;                      ///< odd while a write is in progress
+    std::atomic<uint64_t> words_[N_WORDS];              ///< the value, one 64 bit word at a time
+    std::mutex write_mutex_;                            ///< serialises writers
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_SEQLOCK_H_*/
@@ -0,0 +1,109 @@
+/**
+ * @file SpscQueue.h
+ * @brief Bounded lock-free queue between the Aravis stream thread and the frame dispatch thread
+ * @date 2026-10-15
+ */
+
+#ifndef FRAMEPROCESSOR_SPSCQUEUE_H_
+#define FRAMEPROCESSOR_SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace FrameProcessor
+{
+
+/** @brief Bounded single producer, single consumer ring buffer
+ *
+ * Only one thread may push. Popping is normally done by the consumer, but the
+ * producer may also pop to discard the oldest entry when the queue is full, so
+ * the head index is claimed with a compare and swap. Each slot carries a sequence
+ * number saying whether it is ready to be read or written, so an item is only 
+ * copied by the thread that claimed it and items can be small structs rather than
+ * just pointers. They must be trivially copyable.
+ */
+template <typename T>
+class SpscQueue
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SpscQueue items must be trivially copyable");
+
+public:
+
+    /** @param capacity maximum number of items held by the queue */
+    explicit SpscQueue(size_t capacity) :
+        capacity_(capacity),
+        slots_(capacity),
+        head_(0),
+        tail_(0)
+    {
+        for (size_t i = 0; i < capacity_; i++)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    /** @brief Adds an item to the back of the queue. Producer only.
+     * @return false if the queue is full
+     */
+    bool try_push(const T& item)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[tail % capacity_];
+        if (slot.sequence.load(std::memory_order_acquire) != tail) return false;
+        slot.item = item;
+        slot.sequence.store(tail + 1, std::memory_order_release);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Removes the item at the front of the queue
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& item)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots_[head % capacity_];
+            size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence != head + 1) {
+                // not yet written, or already claimed by the other popping thread
+                if (sequence < head + 1) return false;
+                head = head_.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                item = slot.item;
+                slot.sequence.store(head + capacity_, std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    /** @brief Number of items currently queued (approximate while other threads are active) */
+    size_t size() const
+    {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    /** @brief Maximum number of items the queue can hold */
+    size_t capacity() const { return capacity_; }
+
+private:
+
+    /** A queued item and the position it may next be written (== position) or read (== position + 1) at */
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    const size_t capacity_;                             ///< number of slots
+    std::vector<Slot> slots_;                           ///< ring buffer storage
+    alignas(64) std::atomic<size_t> head_;              ///< position of the next item to pop, on its own cache line
+    alignas(64) std::atomic<size_t> tail_;              ///< position of the next item to push, on its own cache line
+};
+
+} // namespace
+#endif /* FRAMEPROCESSOR_SPSCQUEUE_H_*/
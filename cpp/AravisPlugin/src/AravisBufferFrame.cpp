@@ -0,0 +1,48 @@
+/**
+ * @file AravisBufferFrame.cpp
+ * @brief Frame object that wraps an ArvBuffer without copying the image data
+ * @date 2026-10-15
+ *
+ * Adapted from odin-data, SharedBufferFrame.cpp
+ */
+
+#include "AravisBufferFrame.h"
+
+namespace FrameProcessor
+{
+
+/** @brief Wrap an ArvBuffer in a frame
+ *
+ * @param meta_data frame meta data
+ * @param stream the stream the buffer was popped from
+ * @param buffer the buffer the frame takes ownership of
+ * @param data_src pointer to the image data inside buffer
+ * @param nbytes size of the image data in bytes
+ * @param release called with stream and buffer once the frame is destroyed
+ * @param image_offset offset of the image inside the data block
+ */
+AravisBufferFrame::AravisBufferFrame(const FrameMetaData& meta_data, ArvStream *stream, ArvBuffer *buffer, const void *data_src,
+                                     size_t nbytes, ReleaseCallback release, const int& image_offset) :
+  Frame(meta_data, nbytes, image_offset),
+  stream_(stream),
+  buffer_(buffer),
+  data_ptr_(const_cast<void*>(data_src)),
+  release_(release)
+{
+}
+
+/** @brief Hands the buffer back so the camera can fill it again */
+AravisBufferFrame::~AravisBufferFrame()
+{
+  if(buffer_ != NULL && release_){
+    release_(stream_, buffer_);
+  }
+}
+
+/** @brief Pointer to the image data inside the ArvBuffer */
+void *AravisBufferFrame::get_data_ptr() const
+{
+  return data_ptr_;
+}
+
+} // namespace FrameProcessor
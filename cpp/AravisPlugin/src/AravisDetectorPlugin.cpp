@@ -13,6 +13,12 @@
 #include "version.h"
 #include "logging.h"
 #include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <boost/bind/bind.hpp>
+#include <time.h>
 
 /** @brief destructs GError objects
  * 
@@ -55,6 +61,41 @@ namespace FrameProcessor
   const std::string AravisDetectorPlugin::DEFAULT_AQUISIT_MODE  = "Continuous";
   const size_t      AravisDetectorPlugin::DEFAULT_STATUS_FREQ   = 1000;
   const int         AravisDetectorPlugin::DEFAULT_EMPTY_BUFF    = 50;
+  const bool        AravisDetectorPlugin::DEFAULT_ZERO_COPY     = false;
+  const int         AravisDetectorPlugin::DEFAULT_ZERO_COPY_RESERVE = 10;
+  const bool        AravisDetectorPlugin::DEFAULT_FILL_MISSING  = false;
+  const int         AravisDetectorPlugin::DEFAULT_CLOCK_WINDOW  = 1000;
+  const size_t      AravisDetectorPlugin::DEFAULT_BUFFER_LOG_INTERVAL = 1000;
+  const int         AravisDetectorPlugin::DEFAULT_COMPRESSION_THREADS = 0;
+  const std::string AravisDetectorPlugin::DEFAULT_COMPRESSION_CODEC = "lz4";
+  const std::string AravisDetectorPlugin::DEFAULT_COMPRESSION_SHUFFLE = "bit";
+  const int         AravisDetectorPlugin::DEFAULT_COMPRESSION_LEVEL = 5;
+  const std::string AravisDetectorPlugin::DEFAULT_DARK_FILE = "";
+  const std::string AravisDetectorPlugin::DEFAULT_GAIN_FILE = "";
+  const unsigned int AravisDetectorPlugin::DEFAULT_BINNING = 1;
+  const int         AravisDetectorPlugin::DEFAULT_DECIMATION = 1;
+  const bool        AravisDetectorPlugin::DEFAULT_IMAGE_STATISTICS = false;
+  const unsigned int AravisDetectorPlugin::DEFAULT_HISTOGRAM_BINS = 16;
+  const int         AravisDetectorPlugin::DEFAULT_BATCH_SIZE = 1;
+  const size_t      AravisDetectorPlugin::DEFAULT_BATCH_TIMEOUT = 100;
+  const int         AravisDetectorPlugin::DEFAULT_QUEUE_DEPTH   = 32;
+  const std::string AravisDetectorPlugin::DEFAULT_QUEUE_OVERFLOW= "block";
+  const bool        AravisDetectorPlugin::DEFAULT_BUFFER_ARENA  = false;
+  const bool        AravisDetectorPlugin::DEFAULT_HUGEPAGES     = false;
+  const bool        AravisDetectorPlugin::DEFAULT_LOCK_BUFFERS  = false;
+  const bool        AravisDetectorPlugin::DEFAULT_ADAPTIVE_BUFF = false;
+  const int         AravisDetectorPlugin::DEFAULT_BUFF_LOW_WATERMARK = 10;
+  const size_t      AravisDetectorPlugin::DEFAULT_BUFF_MEMORY_LIMIT_MB = 4096;
+  const size_t      AravisDetectorPlugin::DEFAULT_BUFF_IDLE_MS  = 30000;
+  const std::string AravisDetectorPlugin::DEFAULT_VIRTUAL_SOURCE= "";
+  const int         AravisDetectorPlugin::DEFAULT_VIRTUAL_WIDTH = 640;
+  const int         AravisDetectorPlugin::DEFAULT_VIRTUAL_HEIGHT= 480;
+  const double      AravisDetectorPlugin::DEFAULT_VIRTUAL_FRAME_RATE = 0;
+  const size_t      AravisDetectorPlugin::DEFAULT_DISCOVERY_INTERVAL = 10000;
+  const size_t      AravisDetectorPlugin::DEFAULT_PARAMETER_RESYNC = 0;
+  const bool        AravisDetectorPlugin::DEFAULT_ASYNC_COMMANDS = true;
+  const std::string AravisDetectorPlugin::DEFAULT_CAMERA_CACHE = "";
+  const bool        AravisDetectorPlugin::DEFAULT_AUTO_RECOVER = false;
 
   const std::string AravisDetectorPlugin::DEFAULT_FILE_PATH     = "/";
   const std::string AravisDetectorPlugin::DEFAULT_DATASET       = "data";
@@ -67,6 +108,8 @@ namespace FrameProcessor
   const std::string AravisDetectorPlugin::STOP_STREAM         = "stop";
   const std::string AravisDetectorPlugin::LIST_DEVICES        = "list_devices";
   const std::string AravisDetectorPlugin::ACQUIRE_BUFFER      = "frames";
+  const std::string AravisDetectorPlugin::CAPTURE_DARK        = "capture_dark";
+  const std::string AravisDetectorPlugin::SAVE_DARK           = "save_dark";
 
   /** Camera name*/
   const std::string AravisDetectorPlugin::CONFIG_CAMERA_IP    = "ip_address";
@@ -79,9 +122,58 @@ namespace FrameProcessor
   const std::string AravisDetectorPlugin::CONFIG_FRAME_RATE   = "frame_rate";
   const std::string AravisDetectorPlugin::CONFIG_FRAME_COUNT  = "frame_count";
   const std::string AravisDetectorPlugin::CONFIG_PIXEL_FORMAT = "pixel_format";
+  const std::string AravisDetectorPlugin::CONFIG_IMAGE_WIDTH  = "image_width";
+  const std::string AravisDetectorPlugin::CONFIG_IMAGE_HEIGHT = "image_height";
   const std::string AravisDetectorPlugin::CONFIG_ACQUISITION_MODE = "acquisition_mode";
   const std::string AravisDetectorPlugin::CONFIG_STATUS_FREQ  = "status_frequency_ms";
+  const std::string AravisDetectorPlugin::CONFIG_DISCOVERY_INTERVAL = "discovery_interval_ms";
+  const std::string AravisDetectorPlugin::CONFIG_PARAMETER_RESYNC = "parameter_resync_ms";
+  const std::string AravisDetectorPlugin::CONFIG_ASYNC_COMMANDS = "async_commands";
+  const std::string AravisDetectorPlugin::CONFIG_FEATURES = "features";
+  const std::string AravisDetectorPlugin::CONFIG_CAMERA_CACHE = "camera_cache_path";
+  const std::string AravisDetectorPlugin::CONFIG_AUTO_RECOVER = "auto_recover";
   const std::string AravisDetectorPlugin::CONFIG_EMPTY_BUFF   = "empty_buffers";
+  const std::string AravisDetectorPlugin::CONFIG_ZERO_COPY    = "zero_copy";
+  const std::string AravisDetectorPlugin::CONFIG_ZERO_COPY_RESERVE = "zero_copy_reserve";
+  const std::string AravisDetectorPlugin::CONFIG_FILL_MISSING = "fill_missing_frames";
+  const std::string AravisDetectorPlugin::CONFIG_CLOCK_WINDOW = "clock_window";
+  const std::string AravisDetectorPlugin::CONFIG_BUFFER_LOG_INTERVAL = "buffer_log_interval_ms";
+  const std::string AravisDetectorPlugin::CONFIG_COMPRESSION_THREADS = "compression_threads";
+  const std::string AravisDetectorPlugin::CONFIG_COMPRESSION_CODEC = "compression_codec";
+  const std::string AravisDetectorPlugin::CONFIG_COMPRESSION_SHUFFLE = "compression_shuffle";
+  const std::string AravisDetectorPlugin::CONFIG_COMPRESSION_LEVEL = "compression_level";
+  const std::string AravisDetectorPlugin::CONFIG_DARK_FILE    = "dark_file";
+  const std::string AravisDetectorPlugin::CONFIG_GAIN_FILE    = "gain_file";
+  const std::string AravisDetectorPlugin::CONFIG_ROI_X        = "roi_x";
+  const std::string AravisDetectorPlugin::CONFIG_ROI_Y        = "roi_y";
+  const std::string AravisDetectorPlugin::CONFIG_ROI_WIDTH    = "roi_width";
+  const std::string AravisDetectorPlugin::CONFIG_ROI_HEIGHT   = "roi_height";
+  const std::string AravisDetectorPlugin::CONFIG_BINNING_X    = "binning_x";
+  const std::string AravisDetectorPlugin::CONFIG_BINNING_Y    = "binning_y";
+  const std::string AravisDetectorPlugin::CONFIG_BINNING_MODE = "binning_mode";
+  const std::string AravisDetectorPlugin::CONFIG_DECIMATION   = "decimation";
+  const std::string AravisDetectorPlugin::CONFIG_IMAGE_STATISTICS = "image_statistics";
+  const std::string AravisDetectorPlugin::CONFIG_HISTOGRAM_BINS = "histogram_bins";
+  const std::string AravisDetectorPlugin::CONFIG_BATCH_SIZE   = "batch_size";
+  const std::string AravisDetectorPlugin::CONFIG_BATCH_TIMEOUT = "batch_timeout_ms";
+  const std::string AravisDetectorPlugin::CONFIG_QUEUE_DEPTH  = "queue_depth";
+  const std::string AravisDetectorPlugin::CONFIG_QUEUE_OVERFLOW = "queue_overflow";
+  const std::string AravisDetectorPlugin::CONFIG_BUFFER_ARENA = "buffer_arena";
+  const std::string AravisDetectorPlugin::CONFIG_HUGEPAGES    = "hugepages";
+  const std::string AravisDetectorPlugin::CONFIG_LOCK_BUFFERS = "lock_buffers";
+  const std::string AravisDetectorPlugin::CONFIG_ADAPTIVE_BUFF = "adaptive_buffers";
+  const std::string AravisDetectorPlugin::CONFIG_BUFF_LOW_WATERMARK = "buffer_low_watermark";
+  const std::string AravisDetectorPlugin::CONFIG_BUFF_MEMORY_LIMIT = "buffer_memory_limit_mb";
+  const std::string AravisDetectorPlugin::CONFIG_BUFF_IDLE_MS = "buffer_idle_ms";
+  const std::string AravisDetectorPlugin::CONFIG_VIRTUAL_SOURCE = "virtual_source";
+  const std::string AravisDetectorPlugin::CONFIG_VIRTUAL_WIDTH = "virtual_width";
+  const std::string AravisDetectorPlugin::CONFIG_VIRTUAL_HEIGHT = "virtual_height";
+  const std::string AravisDetectorPlugin::CONFIG_VIRTUAL_FRAME_RATE = "virtual_frame_rate";
+
+  /** Dispatch queue overflow policies*/
+  const std::string AravisDetectorPlugin::QUEUE_OVERFLOW_BLOCK       = "block";
+  const std::string AravisDetectorPlugin::QUEUE_OVERFLOW_DROP_OLDEST = "drop_oldest";
+  const std::string AravisDetectorPlugin::QUEUE_OVERFLOW_DROP_NEWEST = "drop_newest";
 
   /** Frame creation*/
   const std::string AravisDetectorPlugin::TEMP_FILES_PATH     = "file_path";
@@ -89,6 +181,84 @@ namespace FrameProcessor
   const std::string AravisDetectorPlugin::FILE_NAME           = "file_name"; 
   const std::string AravisDetectorPlugin::COMPRESSION_TYPE    = "compression";
 
+  /** Frame parameters*/
+  const std::string AravisDetectorPlugin::PARAM_SYSTEM_TIMESTAMP = "system_timestamp";
+  const std::string AravisDetectorPlugin::PARAM_CAMERA_TIMESTAMP = "camera_timestamp";
+  const std::string AravisDetectorPlugin::PARAM_FRAME_ID = "camera_frame_id";
+  const std::string AravisDetectorPlugin::PARAM_MISSING_FRAME = "missing_frame";
+  const std::string AravisDetectorPlugin::PARAM_UTC_TIMESTAMP = "utc_timestamp";
+  const std::string AravisDetectorPlugin::PARAM_STATS_SUM = "stats_sum";
+  const std::string AravisDetectorPlugin::PARAM_STATS_MIN = "stats_min";
+  const std::string AravisDetectorPlugin::PARAM_STATS_MAX = "stats_max";
+  const std::string AravisDetectorPlugin::PARAM_STATS_CENTROID_X = "stats_centroid_x";
+  const std::string AravisDetectorPlugin::PARAM_STATS_CENTROID_Y = "stats_centroid_y";
+  const std::string AravisDetectorPlugin::PARAM_STATS_RMS_X = "stats_rms_x";
+  const std::string AravisDetectorPlugin::PARAM_STATS_RMS_Y = "stats_rms_y";
+  const std::string AravisDetectorPlugin::PARAM_STATS_HISTOGRAM = "stats_histogram";
+  const std::string AravisDetectorPlugin::PARAM_BATCH_IMAGES = "batch_images";
+  const std::string AravisDetectorPlugin::PARAM_BATCH_FRAME_IDS = "camera_frame_ids";
+  const std::string AravisDetectorPlugin::PARAM_BATCH_SYSTEM_TIMESTAMPS = "system_timestamps";
+  const std::string AravisDetectorPlugin::PARAM_BATCH_CAMERA_TIMESTAMPS = "camera_timestamps";
+  const std::string AravisDetectorPlugin::PARAM_BATCH_UTC_TIMESTAMPS = "utc_timestamps";
+
+  /** Names of the latency histograms in status, indexed by LatencyStage*/
+  static const char *LATENCY_STAGE_NAMES[] = {"aravis", "queue", "build", "push", "total", "jitter"};
+
+  /** Names of the buffer outcomes in status and logs, indexed by BufferOutcome*/
+  static const char *BUFFER_OUTCOME_NAMES[] = {"success", "empty", "unknown", "cleared", "timeout", "missing_packets",
+    "wrong_packet_id", "size_mismatch", "filling", "aborted", "payload_not_supported", "other"};
+
+  /** Most frames averaged into one dark frame, so the sums of 16 bit pixels fit in 32 bits*/
+  static const int MAX_DARK_CAPTURE_FRAMES = 65535;
+
+  /** Largest bin along one axis, so the sum of a block of 16 bit pixels fits in 32 bits*/
+  static const int MAX_BINNING = 256;
+
+  /** Most images stacked into one batch frame*/
+  static const int MAX_BATCH_SIZE = 4096;
+
+  /** Length of the window the rolling frame rate and image statistics are measured over*/
+  static const uint64_t FPS_WINDOW_NS = 1000000000;
+
+  /** Empty queue checks the dispatch thread spins through before it sleeps*/
+  static const int DISPATCH_IDLE_SPINS = 100;
+
+  /** Longest the dispatch thread sleeps on an empty queue, so it still pushes stale batches and takes resets*/
+  static const int DISPATCH_IDLE_WAIT_MS = 10;
+
+  /** Largest GigE Vision 1.x block id, the id after it is 1 (0 is not a valid id)*/
+  static const uint64_t GVSP_MAX_BLOCK_ID = 65535;
+
+  /** A drop in frame id is a wrap around only from this close to the end of the id range*/
+  static const uint64_t GVSP_WRAP_MARGIN = 1024;
+
+  /** Most placeholder frames pushed for one gap, longer gaps are only counted. Placeholders
+   * are made on the thread making frames, so a long gap would hold up the frames after it*/
+  static const uint64_t MAX_PLACEHOLDER_FRAMES = 64;
+
+  /** @brief Host wall clock time in nanoseconds, the clock used for buffer system timestamps*/
+  static uint64_t realtime_ns(){
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+  }
+
+  /** Marks buffers added by the adaptive pool so they can be freed again*/
+  static char ADAPTIVE_BUFFER_TAG;
+
+  /** Pixel layouts used to specialise frame creation
+   * 
+   * bytes_per_pixel is the size of one pixel in the frame pushed downstream, 0 when
+   * unknown in which case the whole buffer is sent. Packed layouts are unpacked by 
+   * unpack_kernel_.
+   */
+  struct Mono8Layout   { static constexpr DataType data_type = raw_8bit;    static constexpr unsigned channels = 1; static constexpr size_t bytes_per_pixel = 1; static constexpr bool packed = false; };
+  struct Mono16Layout  { static constexpr DataType data_type = raw_16bit;   static constexpr unsigned channels = 1; static constexpr size_t bytes_per_pixel = 2; static constexpr bool packed = false; };
+  struct PackedLayout  { static constexpr DataType data_type = raw_16bit;   static constexpr unsigned channels = 1; static constexpr size_t bytes_per_pixel = 2; static constexpr bool packed = true;  };
+  struct Rgb8Layout    { static constexpr DataType data_type = raw_8bit;    static constexpr unsigned channels = 3; static constexpr size_t bytes_per_pixel = 3; static constexpr bool packed = false; };
+  struct Yuv422Layout  { static constexpr DataType data_type = raw_8bit;    static constexpr unsigned channels = 2; static constexpr size_t bytes_per_pixel = 2; static constexpr bool packed = false; };
+  struct UnknownLayout { static constexpr DataType data_type = raw_unknown; static constexpr unsigned channels = 1; static constexpr size_t bytes_per_pixel = 0; static constexpr bool packed = false; };
+
 /** @brief Constructor for the plugin
  * 
  * Sets default values, starts the status monitoring thread and logger object
@@ -98,10 +268,15 @@ AravisDetectorPlugin::AravisDetectorPlugin() :
   working_(true),
   streaming_(false),
   camera_connected_(false),
-  frame_count_(0)
+  frame_count_(0),
+  frame_builder_(&AravisDetectorPlugin::build_frame<UnknownLayout>)
 {
+  publish_camera_settings();
+
   // Start the status thread to monitor the camera
   thread_ = new boost::thread(&AravisDetectorPlugin::status_task, this);
+  // and the command thread running camera operations
+  command_thread_ = new boost::thread(&AravisDetectorPlugin::command_task, this);
 
   logger_ = Logger::getLogger("FP.AravisDetectorPlugin");
   LOG4CXX_INFO(logger_, "AravisDetectorPlugin loaded");
@@ -111,6 +286,23 @@ AravisDetectorPlugin::AravisDetectorPlugin() :
 /** @brief Class Destructor. Closes the Publish socket */
 AravisDetectorPlugin::~AravisDetectorPlugin()
 {
+  // commands still queued are dropped
+  {
+    boost::mutex::scoped_lock lock(command_mutex_);
+    commands_running_ = false;
+  }
+  command_cond_.notify_all();
+  command_done_cond_.notify_all();
+  command_thread_->join();
+  delete command_thread_;
+
+  stop_virtual_stream();
+  stop_dispatch_thread();
+  release_camera();
+  if(discovery_thread_ != NULL){
+    discovery_thread_->join();
+    delete discovery_thread_;
+  }
   arv_shutdown();
   LOG4CXX_TRACE(logger_, "AravisDetectorPlugin destructor.");
 }
@@ -127,11 +319,54 @@ void AravisDetectorPlugin::process_frame(boost::shared_ptr<Frame> frame)
 }
 
 /** @brief Implements json configurations
+ * 
+ * Every message is applied by the command thread, the only thread that talks to the
+ * camera or changes the settings the stream and the status polls read, so a message
+ * never overlaps with a poll or a recovery. Messages with camera operations (connect,
+ * start, stop, list devices, acquire or a camera feature) are checked for obviously
+ * invalid values first. With async_commands their reply returns straight away with
+ * their command id, and once anything is queued later messages are queued behind it
+ * to keep their order. Otherwise the reply waits for the message to be applied.
  * 
  * @param[in] config - IpcMessage containing configuration data
  * @param[out] reply - Response IpcMessage
  */
 void AravisDetectorPlugin::configure(OdinData::IpcMessage& config, OdinData::IpcMessage& reply)
+{
+  try{
+    if (config.has_param(CONFIG_ASYNC_COMMANDS))
+{      set_async_commands(config.get_param<bool>(CONFIG_ASYNC_COMMANDS), reply);
+}
+
+    if(is_camera_command(config) || commands_pending()){
+      std::string invalid;
+      if(!check_camera_values(config, invalid)){
+        log_error("Camera configuration rejected, " + invalid + ". Nothing was applied", reply);
+        return;
+      }
+      if(async_commands_){
+        queue_command(config, reply);
+        return;
+      }
+    }
+  }
+  catch (std::runtime_error& e)
+  {
+    std::stringstream ss;
+    ss << "Bad ctrl msg: " << e.what();
+    log_error(ss.str(), reply);
+    return;
+  }
+
+  run_command(COMMAND_CONFIG, &config, reply);
+}
+
+/** @brief Applies a configuration message, on the command thread or the caller's
+ * 
+ * @param[in] config - IpcMessage containing configuration data
+ * @param[out] reply - Response IpcMessage
+ */
+void AravisDetectorPlugin::apply_configuration(OdinData::IpcMessage& config, OdinData::IpcMessage& reply)
 {  try{
     /** Flags*/
     if (config.has_param(START_STREAM))
@@ -152,28 +387,91 @@ void AravisDetectorPlugin::configure(OdinData::IpcMessage& config, OdinData::Ipc
 {      connect_aravis_camera(config.get_param<std::string>(CONFIG_CAMERA_IP), reply);
 }
 
-    /** Camera config*/
-    if (config.has_param(CONFIG_EXPOSURE))
-{      set_exposure(config.get_param<double>(CONFIG_EXPOSURE), reply);
-}
-    if (config.has_param(CONFIG_FRAME_RATE))
-{      set_frame_rate(config.get_param<double>(CONFIG_FRAME_RATE), reply);
+    /** Camera config, applied as one batch*/
+    apply_camera_config(config, reply);
+
+    /** Any other GenICam feature*/
+    if (config.has_param(CONFIG_FEATURES))
+{      set_features(config, reply);
 }
+
     if (config.has_param(CONFIG_FRAME_COUNT))
 {      set_frame_count(config.get_param<int32_t>(CONFIG_FRAME_COUNT), reply);
-}
-    if (config.has_param(CONFIG_PIXEL_FORMAT))
-{      set_pixel_format(config.get_param<std::string>(CONFIG_PIXEL_FORMAT), reply);
-}
-    if (config.has_param(CONFIG_ACQUISITION_MODE))
-{      set_acquisition_mode(config.get_param<std::string>(CONFIG_ACQUISITION_MODE), reply);
 }
     if (config.has_param(CONFIG_STATUS_FREQ))
 {      set_status_poll_frequency(static_cast<size_t>(config.get_param<int>(CONFIG_STATUS_FREQ)), reply);
 }  
+    if (config.has_param(CONFIG_DISCOVERY_INTERVAL))
+{      set_discovery_interval(static_cast<size_t>(config.get_param<int>(CONFIG_DISCOVERY_INTERVAL)), reply);
+}
+    if (config.has_param(CONFIG_AUTO_RECOVER))
+{      set_auto_recover(config.get_param<bool>(CONFIG_AUTO_RECOVER), reply);
+}
+    if (config.has_param(CONFIG_CAMERA_CACHE))
+{      set_camera_cache_path(config.get_param<std::string>(CONFIG_CAMERA_CACHE), reply);
+}
+    if (config.has_param(CONFIG_PARAMETER_RESYNC))
+{      set_parameter_resync(static_cast<size_t>(config.get_param<int>(CONFIG_PARAMETER_RESYNC)), reply);
+}
     if (config.has_param(CONFIG_EMPTY_BUFF))
 {      set_empty_buffers(static_cast<size_t>(config.get_param<int>(CONFIG_EMPTY_BUFF)), reply);
 }  
+    if (config.has_param(CONFIG_ZERO_COPY))
+{      set_zero_copy(config.get_param<bool>(CONFIG_ZERO_COPY), reply);
+}
+    if (config.has_param(CONFIG_ZERO_COPY_RESERVE))
+{      set_zero_copy_reserve(config.get_param<int>(CONFIG_ZERO_COPY_RESERVE), reply);
+}
+    if (config.has_param(CONFIG_FILL_MISSING))
+{      set_fill_missing(config.get_param<bool>(CONFIG_FILL_MISSING), reply);
+}
+    if (config.has_param(CONFIG_CLOCK_WINDOW))
+{      set_clock_window(config.get_param<int>(CONFIG_CLOCK_WINDOW), reply);
+}
+    if (config.has_param(CONFIG_BUFFER_LOG_INTERVAL))
+{      set_buffer_log_interval(static_cast<size_t>(config.get_param<int>(CONFIG_BUFFER_LOG_INTERVAL)), reply);
+}
+    if (config.has_param(CONFIG_QUEUE_DEPTH))
+{      set_queue_depth(config.get_param<int>(CONFIG_QUEUE_DEPTH), reply);
+}
+    if (config.has_param(CONFIG_QUEUE_OVERFLOW))
+{      set_queue_overflow(config.get_param<std::string>(CONFIG_QUEUE_OVERFLOW), reply);
+}
+    if (config.has_param(CONFIG_BUFFER_ARENA))
+{      set_buffer_arena(config.get_param<bool>(CONFIG_BUFFER_ARENA), reply);
+}
+    if (config.has_param(CONFIG_HUGEPAGES))
+{      set_hugepages(config.get_param<bool>(CONFIG_HUGEPAGES), reply);
+}
+    if (config.has_param(CONFIG_LOCK_BUFFERS))
+{      set_lock_buffers(config.get_param<bool>(CONFIG_LOCK_BUFFERS), reply);
+}
+    if (config.has_param(CONFIG_ADAPTIVE_BUFF))
+{      set_adaptive_buffers(config.get_param<bool>(CONFIG_ADAPTIVE_BUFF), reply);
+}
+    if (config.has_param(CONFIG_BUFF_LOW_WATERMARK))
+{      set_buffer_low_watermark(config.get_param<int>(CONFIG_BUFF_LOW_WATERMARK), reply);
+}
+    if (config.has_param(CONFIG_BUFF_MEMORY_LIMIT))
+{      set_buffer_memory_limit(static_cast<size_t>(config.get_param<int>(CONFIG_BUFF_MEMORY_LIMIT)), reply);
+}
+    if (config.has_param(CONFIG_BUFF_IDLE_MS))
+{      set_buffer_idle_time(static_cast<size_t>(config.get_param<int>(CONFIG_BUFF_IDLE_MS)), reply);
+}
+
+    /** Virtual camera*/
+    if (config.has_param(CONFIG_VIRTUAL_SOURCE))
+{      set_virtual_source(config.get_param<std::string>(CONFIG_VIRTUAL_SOURCE), reply);
+}
+    if (config.has_param(CONFIG_VIRTUAL_WIDTH))
+{      set_virtual_width(config.get_param<int>(CONFIG_VIRTUAL_WIDTH), reply);
+}
+    if (config.has_param(CONFIG_VIRTUAL_HEIGHT))
+{      set_virtual_height(config.get_param<int>(CONFIG_VIRTUAL_HEIGHT), reply);
+}
+    if (config.has_param(CONFIG_VIRTUAL_FRAME_RATE))
+{      set_virtual_frame_rate(config.get_param<double>(CONFIG_VIRTUAL_FRAME_RATE), reply);
+}
 
     /** Frame creation*/
     if (config.has_param(TEMP_FILES_PATH))
@@ -187,6 +485,61 @@ void AravisDetectorPlugin::configure(OdinData::IpcMessage& config, OdinData::Ipc
 }
     if (config.has_param(COMPRESSION_TYPE))
 {      set_compression_type(config.get_param<std::string>(COMPRESSION_TYPE), reply);
+}
+    if (config.has_param(CONFIG_COMPRESSION_CODEC))
+{      set_compression_codec(config.get_param<std::string>(CONFIG_COMPRESSION_CODEC), reply);
+}
+    if (config.has_param(CONFIG_COMPRESSION_SHUFFLE))
+{      set_compression_shuffle(config.get_param<std::string>(CONFIG_COMPRESSION_SHUFFLE), reply);
+}
+    if (config.has_param(CONFIG_COMPRESSION_LEVEL))
+{      set_compression_level(config.get_param<int>(CONFIG_COMPRESSION_LEVEL), reply);
+}
+    if (config.has_param(CONFIG_COMPRESSION_THREADS))
+{      set_compression_threads(config.get_param<int>(CONFIG_COMPRESSION_THREADS), reply);
+}
+
+    /** Dark and flat field correction*/
+    if (config.has_param(CONFIG_DARK_FILE))
+{      set_dark_file(config.get_param<std::string>(CONFIG_DARK_FILE), reply);
+}
+    if (config.has_param(CONFIG_GAIN_FILE))
+{      set_gain_file(config.get_param<std::string>(CONFIG_GAIN_FILE), reply);
+}
+    if (config.has_param(CAPTURE_DARK))
+{      capture_dark(config.get_param<int>(CAPTURE_DARK), reply);
+}
+    if (config.has_param(SAVE_DARK))
+{      save_dark(config.get_param<std::string>(SAVE_DARK), reply);
+}
+
+    /** Region of interest, binning and decimation*/
+    if (config.has_param(CONFIG_ROI_X) || config.has_param(CONFIG_ROI_Y) ||
+        config.has_param(CONFIG_ROI_WIDTH) || config.has_param(CONFIG_ROI_HEIGHT))
+{      set_roi(config.has_param(CONFIG_ROI_X) ? config.get_param<int>(CONFIG_ROI_X) : static_cast<int>(reduction_settings_.x),
+              config.has_param(CONFIG_ROI_Y) ? config.get_param<int>(CONFIG_ROI_Y) : static_cast<int>(reduction_settings_.y),
+              config.has_param(CONFIG_ROI_WIDTH) ? config.get_param<int>(CONFIG_ROI_WIDTH) : static_cast<int>(reduction_settings_.width),
+              config.has_param(CONFIG_ROI_HEIGHT) ? config.get_param<int>(CONFIG_ROI_HEIGHT) : static_cast<int>(reduction_settings_.height), reply);
+}
+    if (config.has_param(CONFIG_BINNING_X) || config.has_param(CONFIG_BINNING_Y) || config.has_param(CONFIG_BINNING_MODE))
+{      set_binning(config.has_param(CONFIG_BINNING_X) ? config.get_param<int>(CONFIG_BINNING_X) : static_cast<int>(reduction_settings_.bin_x),
+                  config.has_param(CONFIG_BINNING_Y) ? config.get_param<int>(CONFIG_BINNING_Y) : static_cast<int>(reduction_settings_.bin_y),
+                  config.has_param(CONFIG_BINNING_MODE) ? config.get_param<std::string>(CONFIG_BINNING_MODE) : FrameReduction::mode_name(reduction_settings_.mode), reply);
+}
+    if (config.has_param(CONFIG_DECIMATION))
+{      set_decimation(config.get_param<int>(CONFIG_DECIMATION), reply);
+}
+    if (config.has_param(CONFIG_IMAGE_STATISTICS))
+{      set_image_statistics(config.get_param<bool>(CONFIG_IMAGE_STATISTICS), reply);
+}
+    if (config.has_param(CONFIG_HISTOGRAM_BINS))
+{      set_histogram_bins(config.get_param<int>(CONFIG_HISTOGRAM_BINS), reply);
+}
+    if (config.has_param(CONFIG_BATCH_SIZE))
+{      set_batch_size(config.get_param<int>(CONFIG_BATCH_SIZE), reply);
+}
+    if (config.has_param(CONFIG_BATCH_TIMEOUT))
+{      set_batch_timeout(config.get_param<int>(CONFIG_BATCH_TIMEOUT), reply);
 }
 
   }
@@ -200,22 +553,83 @@ void AravisDetectorPlugin::configure(OdinData::IpcMessage& config, OdinData::Ipc
 }
 
 /** @brief Provides python client with current configuration data in json format
+ * 
+ * The settings are written by the command thread, so they are read there too.
  * 
  * @param[out] reply - Response IpcMessage
  */
 void AravisDetectorPlugin::requestConfiguration(OdinData::IpcMessage& reply){
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_IP, camera_address_);
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_ID, camera_id_);
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_SERIAL, camera_serial_);
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_MODEL, camera_model_);
+  run_command(COMMAND_REQUEST_CONFIG, NULL, reply);
+}
 
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_EXPOSURE, exposure_time_us_);
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_FRAME_RATE, frame_rate_hz_);
+/** @brief Adds the current configuration to a reply, on the command thread
+ * 
+ * @param[out] reply - Response IpcMessage
+ */
+void AravisDetectorPlugin::report_configuration(OdinData::IpcMessage& reply){
+    CameraSettings camera_settings;
+    {
+      boost::mutex::scoped_lock lock(camera_settings_mutex_);
+      camera_settings = camera_settings_;
+    }
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_IP, camera_settings.address);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_ID, camera_settings.id);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_SERIAL, camera_settings.serial);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_MODEL, camera_settings.model);
+
+    CameraStats camera_stats = camera_stats_.read();
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_EXPOSURE, camera_stats.exposure_time_us);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_FRAME_RATE, camera_stats.frame_rate_hz);
     reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_FRAME_COUNT, frame_count_);
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_PIXEL_FORMAT, pixel_format_);
-    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ACQUISITION_MODE, acquisition_mode_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_PIXEL_FORMAT, camera_settings.pixel_format);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ACQUISITION_MODE, camera_settings.acquisition_mode);
     reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_STATUS_FREQ, status_freq_ms_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_DISCOVERY_INTERVAL, discovery_interval_ms_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_PARAMETER_RESYNC, parameter_resync_ms_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ASYNC_COMMANDS, async_commands_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CAMERA_CACHE, camera_cache_path_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_AUTO_RECOVER, auto_recover_);
+    report_features(reply, false);
     reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_EMPTY_BUFF, n_empty_buffers_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ZERO_COPY, zero_copy_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ZERO_COPY_RESERVE, n_zero_copy_reserve_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_FILL_MISSING, fill_missing_.load());
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_CLOCK_WINDOW, clock_window_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BUFFER_LOG_INTERVAL, buffer_log_interval_ms_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_COMPRESSION_THREADS, n_compression_threads_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_COMPRESSION_CODEC, compression_codec_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_COMPRESSION_SHUFFLE, compression_shuffle_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_COMPRESSION_LEVEL, compression_level_);
+    {
+      boost::mutex::scoped_lock lock(correction_mutex_);
+      reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_DARK_FILE, dark_file_);
+      reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_GAIN_FILE, gain_file_);
+    }
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ROI_X, static_cast<long unsigned int>(reduction_settings_.x));
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ROI_Y, static_cast<long unsigned int>(reduction_settings_.y));
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ROI_WIDTH, static_cast<long unsigned int>(reduction_settings_.width));
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ROI_HEIGHT, static_cast<long unsigned int>(reduction_settings_.height));
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BINNING_X, reduction_settings_.bin_x);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BINNING_Y, reduction_settings_.bin_y);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BINNING_MODE, std::string(FrameReduction::mode_name(reduction_settings_.mode)));
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_DECIMATION, decimation_.load());
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_IMAGE_STATISTICS, measure_images_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_HISTOGRAM_BINS, histogram_bins_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BATCH_SIZE, batch_size_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BATCH_TIMEOUT, batch_timeout_ms_.load());
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_QUEUE_DEPTH, queue_depth_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_QUEUE_OVERFLOW, queue_overflow_name_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BUFFER_ARENA, use_buffer_arena_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_HUGEPAGES, use_hugepages_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_LOCK_BUFFERS, lock_buffers_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_ADAPTIVE_BUFF, adaptive_buffers_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BUFF_LOW_WATERMARK, buffer_low_watermark_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BUFF_MEMORY_LIMIT, buffer_memory_limit_mb_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_BUFF_IDLE_MS, buffer_idle_ms_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_VIRTUAL_SOURCE, virtual_source_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_VIRTUAL_WIDTH, virtual_width_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_VIRTUAL_HEIGHT, virtual_height_);
+    reply.set_param(get_name() + "/" + AravisDetectorPlugin::CONFIG_VIRTUAL_FRAME_RATE, virtual_frame_rate_hz_);
 
     reply.set_param(get_name() + "/" + AravisDetectorPlugin::TEMP_FILES_PATH, temp_file_path_);
     reply.set_param(get_name() + "/" + AravisDetectorPlugin::DATA_SET_NAME, data_set_name_);
@@ -229,68 +643,341 @@ void AravisDetectorPlugin::requestConfiguration(OdinData::IpcMessage& reply){
  */
 void AravisDetectorPlugin::status(OdinData::IpcMessage &status){
 
+  // consistent copies of the values other threads keep updating
+  FrameStats frame_stats = frame_stats_.read();
+  CameraStats camera_stats = camera_stats_.read();
+  ImageSummary image_summary = image_summary_.read();
+  CameraSettings camera_settings;
+  {
+    boost::mutex::scoped_lock lock(camera_settings_mutex_);
+    camera_settings = camera_settings_;
+  }
+
   /** Camera parameters */
-  status.set_param(get_name() + "/" + "camera_id", camera_id_);
-  status.set_param(get_name() + "/" + "camera_ip", camera_address_);
-  status.set_param(get_name() + "/" + "camera_model", camera_model_);
-  status.set_param(get_name() + "/" + "camera_connected", camera_connected_);
+  status.set_param(get_name() + "/" + "camera_id", camera_settings.id);
+  status.set_param(get_name() + "/" + "camera_ip", camera_settings.address);
+  status.set_param(get_name() + "/" + "camera_model", camera_settings.model);
+  status.set_param(get_name() + "/" + "camera_connected", camera_connected_.load());
 
   /** List all devices found on network by index*/
-  status.set_param(get_name()+ "/" + "connected_devices",connected_devices_);
-  for (auto& [key, val]: available_cameras_){
-    status.set_param(get_name() + "/" + "camera_" + key + "_id", val.first);
-    status.set_param(get_name() + "/" + "camera_" + key + "_address", val.second);
+  {
+    boost::mutex::scoped_lock lock(device_list_mutex_);
+    status.set_param(get_name()+ "/" + "connected_devices",connected_devices_);
+    for (auto& [key, val]: available_cameras_){
+      status.set_param(get_name() + "/" + "camera_" + key + "_id", val.first);
+      status.set_param(get_name() + "/" + "camera_" + key + "_address", val.second);
+    }
+  }
+  status.set_param(get_name() + "/" + "discovering", discovering_.load());
+  status.set_param(get_name() + "/" + "discoveries", n_discoveries_.load());
+  status.set_param(get_name() + "/" + "liveness_failures", camera_stats.liveness_failures);
+  status.set_param(get_name() + "/" + "parameter_resyncs", camera_stats.parameter_resyncs);
+  status.set_param(get_name() + "/" + "config_restarts", camera_stats.config_restarts);
+  status.set_param(get_name() + "/" + "fast_reconnects", camera_stats.fast_reconnects);
+  status.set_param(get_name() + "/" + "recovering", recovering_.load());
+  status.set_param(get_name() + "/" + "recoveries", camera_stats.recoveries);
+  status.set_param(get_name() + "/" + "recovery_attempts", camera_stats.recovery_attempts);
+  status.set_param(get_name() + "/" + "last_recovery_gap_ms", camera_stats.last_recovery_gap_ms);
+  status.set_param(get_name() + "/" + "recovery_dropped_frames", frame_stats.recovery_dropped_frames);
+  report_features(status, true);
+  {
+    boost::mutex::scoped_lock lock(command_mutex_);
+    status.set_param(get_name() + "/" + "command_pending", n_queued_configs());
+    status.set_param(get_name() + "/" + "command_last_queued", last_queued_command_);
+    status.set_param(get_name() + "/" + "command_running", running_command_);
+    status.set_param(get_name() + "/" + "command_last_completed", last_completed_command_);
+    status.set_param(get_name() + "/" + "command_last_failed", last_failed_command_);
+    status.set_param(get_name() + "/" + "command_last_error", last_command_error_);
   }
 
   /** Stream parameters*/
-  status.set_param(get_name() + "/" + "payload", payload_);
-  status.set_param(get_name()+ "/" + "image_height",static_cast<long unsigned int>(image_height_px_));
-  status.set_param(get_name()+ "/" + "image_width", static_cast<long unsigned int>(image_width_px_));
+  status.set_param(get_name() + "/" + "payload", camera_stats.payload);
+  status.set_param(get_name()+ "/" + "image_height",static_cast<long unsigned int>(frame_stats.image_height));
+  status.set_param(get_name()+ "/" + "image_width", static_cast<long unsigned int>(frame_stats.image_width));
+
+  status.set_param(get_name() + "/" + "streaming", streaming_.load());
+
+  status.set_param(get_name() + "/" + "input_buffers", camera_stats.input_buffers);
+  status.set_param(get_name() + "/" + "output_buffers", camera_stats.output_buffers);
+
+  status.set_param(get_name()+ "/" + "frames_made", static_cast<long int>(frame_stats.frames_made));
+  status.set_param(get_name() + "/" + "completed_buff", camera_stats.completed_buffers + frame_stats.virtual_frames);
+  status.set_param(get_name() + "/" + "failed_buff", camera_stats.failed_buffers);
+  status.set_param(get_name() + "/" + "underrun_buff", camera_stats.underrun_buffers);
+  for (int outcome = 0; outcome < N_BUFFER_OUTCOMES; outcome++){
+    status.set_param(get_name() + "/" + "buffer_status_" + BUFFER_OUTCOME_NAMES[outcome],
+      static_cast<long unsigned int>(buffer_outcomes_[outcome].load(std::memory_order_relaxed)));
+  }
 
-  status.set_param(get_name() + "/" + "streaming", streaming_);
+  status.set_param(get_name() + "/" + "buffers_in_flight", n_buffers_in_flight_.load());
+  status.set_param(get_name() + "/" + "zero_copy_frames", frame_stats.zero_copy_frames);
+  status.set_param(get_name() + "/" + "copied_frames", frame_stats.copied_frames);
+  status.set_param(get_name() + "/" + "unpacked_frames", frame_stats.unpacked_frames);
+
+  /** Dark and flat field correction*/
+  status.set_param(get_name() + "/" + "correction_pixels", static_cast<long unsigned int>(correction_pixels_.load()));
+  status.set_param(get_name() + "/" + "corrected_frames", frame_stats.corrected_frames);
+  status.set_param(get_name() + "/" + "correction_mismatches", frame_stats.correction_mismatches);
+  status.set_param(get_name() + "/" + "dark_capture_frames", frame_stats.dark_capture_frames);
+
+  /** Region of interest, binning and decimation*/
+  status.set_param(get_name() + "/" + "reduced_frames", frame_stats.reduced_frames);
+  status.set_param(get_name() + "/" + "decimated_frames", frame_stats.decimated_frames);
+
+  /** Batching*/
+  status.set_param(get_name() + "/" + "batches_made", frame_stats.batches_made);
+  status.set_param(get_name() + "/" + "partial_batches", frame_stats.partial_batches);
+
+  /** Image statistics, averaged over the last complete window*/
+  status.set_param(get_name() + "/" + "measured_frames", frame_stats.measured_frames);
+  status.set_param(get_name() + "/" + "stats_window_frames", image_summary.frames);
+  status.set_param(get_name() + "/" + "stats_mean_sum", image_summary.mean_sum);
+  status.set_param(get_name() + "/" + "stats_mean_centroid_x", image_summary.mean_centroid_x);
+  status.set_param(get_name() + "/" + "stats_mean_centroid_y", image_summary.mean_centroid_y);
+  status.set_param(get_name() + "/" + "stats_mean_rms_x", image_summary.mean_rms_x);
+  status.set_param(get_name() + "/" + "stats_mean_rms_y", image_summary.mean_rms_y);
+  status.set_param(get_name() + "/" + "stats_min", image_summary.min);
+  status.set_param(get_name() + "/" + "stats_max", image_summary.max);
+  for (unsigned int bin = 0; bin < image_summary.histogram_bins; bin++){
+    status.set_param(get_name() + "/" + "stats_histogram_" + std::to_string(bin), static_cast<long unsigned int>(image_summary.histogram[bin]));
+  }
 
-  status.set_param(get_name() + "/" + "input_buffers", n_input_buff_);
-  status.set_param(get_name() + "/" + "output_buffers", n_output_buff_);
+  /** Camera frame ids*/
+  status.set_param(get_name() + "/" + "frame_gaps", frame_stats.frame_gaps);
+  status.set_param(get_name() + "/" + "missing_frames", frame_stats.missing_frames);
+  status.set_param(get_name() + "/" + "longest_frame_gap", frame_stats.longest_frame_gap);
+  status.set_param(get_name() + "/" + "frame_id_wraps", frame_stats.frame_id_wraps);
+  status.set_param(get_name() + "/" + "frame_id_resets", frame_stats.frame_id_resets);
+  status.set_param(get_name() + "/" + "placeholder_frames", frame_stats.placeholder_frames);
+
+  /** Camera clock mapping*/
+  status.set_param(get_name() + "/" + "clock_synchronised", frame_stats.clock.ready);
+  status.set_param(get_name() + "/" + "clock_offset_ns", static_cast<long int>(frame_stats.clock.offset_ns));
+  status.set_param(get_name() + "/" + "clock_drift_ppm", frame_stats.clock.drift_ppm);
+  status.set_param(get_name() + "/" + "clock_jitter_ns", frame_stats.clock.jitter_ns);
+  status.set_param(get_name() + "/" + "clock_max_residual_ns", frame_stats.clock.max_residual_ns);
+  status.set_param(get_name() + "/" + "clock_samples", static_cast<long unsigned int>(frame_stats.clock.samples));
+  status.set_param(get_name() + "/" + "clock_outliers", static_cast<long unsigned int>(frame_stats.clock.outliers));
+  status.set_param(get_name() + "/" + "clock_resets", static_cast<long unsigned int>(frame_stats.clock.resets));
+
+  /** Dispatch queue*/
+  status.set_param(get_name() + "/" + "queue_size", n_queue_size_.load());
+  status.set_param(get_name() + "/" + "queue_high_water", n_queue_high_water_.load());
+  status.set_param(get_name() + "/" + "queue_blocked", n_queue_blocked_.load());
+  status.set_param(get_name() + "/" + "queue_dropped_oldest", n_queue_dropped_oldest_.load());
+  status.set_param(get_name() + "/" + "queue_dropped_newest", n_queue_dropped_newest_.load());
+
+  /** Buffer arena*/
+  status.set_param(get_name() + "/" + "arena_bytes", static_cast<long unsigned int>(camera_stats.arena_bytes));
+  status.set_param(get_name() + "/" + "arena_hugepages", camera_stats.arena_hugepages);
+  status.set_param(get_name() + "/" + "arena_locked", camera_stats.arena_locked);
+  status.set_param(get_name() + "/" + "arena_reuses", camera_stats.arena_reuses);
+
+  /** Adaptive buffer pool*/
+  status.set_param(get_name() + "/" + "pool_buffers", camera_stats.empty_buffers + n_extra_buffers_.load());
+  status.set_param(get_name() + "/" + "pool_extra_buffers", n_extra_buffers_.load());
+  status.set_param(get_name() + "/" + "pool_bytes", static_cast<long unsigned int>((camera_stats.empty_buffers + n_extra_buffers_) * camera_stats.payload));
+  status.set_param(get_name() + "/" + "pool_grows", camera_stats.pool_grows);
+  status.set_param(get_name() + "/" + "pool_shrinks", camera_stats.pool_shrinks);
+  status.set_param(get_name() + "/" + "pool_limit_hits", camera_stats.pool_limit_hits);
+
+  /** Virtual camera*/
+  status.set_param(get_name() + "/" + "virtual_streaming", virtual_streaming_.load());
+  status.set_param(get_name() + "/" + "virtual_late_frames", frame_stats.virtual_late_frames);
+
+  /** Compression in the plugin*/
+  {
+    FrameCompressor::Stats compression = frame_compressor_.stats();
+    const LatencyHistogram& compress_time = frame_compressor_.compress_time();
+    status.set_param(get_name() + "/" + "compression_running", frame_compressor_.running());
+    status.set_param(get_name() + "/" + "compressed_frames", static_cast<long unsigned int>(compression.frames));
+    status.set_param(get_name() + "/" + "compression_failures", static_cast<long unsigned int>(compression.failures));
+    status.set_param(get_name() + "/" + "compression_ratio", compression.bytes_out ? static_cast<double>(compression.bytes_in) / compression.bytes_out : 0.0);
+    status.set_param(get_name() + "/" + "compression_in_flight", static_cast<long unsigned int>(frame_compressor_.in_flight()));
+    status.set_param(get_name() + "/" + "compression_time_p50_us", compress_time.percentile(0.5) / 1e3);
+    status.set_param(get_name() + "/" + "compression_time_p99_us", compress_time.percentile(0.99) / 1e3);
+    status.set_param(get_name() + "/" + "compression_time_max_us", compress_time.max() / 1e3);
+  }
 
-  status.set_param(get_name()+ "/" + "frames_made", static_cast<long int>(n_frames_made_));
-  status.set_param(get_name() + "/" + "completed_buff", n_completed_buff_);
-  status.set_param(get_name() + "/" + "failed_buff", n_failed_buff_);
-  status.set_param(get_name() + "/" + "underrun_buff", n_underrun_buff_);
+  /** Frame rate and latency percentiles in microseconds*/
+  status.set_param(get_name() + "/" + "rolling_fps", rolling_fps_.load());
+  for (int stage = 0; stage < N_LATENCY_STAGES; stage++){
+    std::string prefix = get_name() + "/" + "latency_" + LATENCY_STAGE_NAMES[stage];
+    status.set_param(prefix + "_p50_us", latency_[stage].percentile(0.5) / 1e3);
+    status.set_param(prefix + "_p99_us", latency_[stage].percentile(0.99) / 1e3);
+    status.set_param(prefix + "_p999_us", latency_[stage].percentile(0.999) / 1e3);
+    status.set_param(prefix + "_max_us", latency_[stage].max() / 1e3);
+  }
 }
 
-/** @brief Reset stream statistics */
+/** @brief Reset stream statistics
+ * 
+ * Counters kept by one thread are only zeroed by that thread, so this asks the thread
+ * making frames and the command thread to zero theirs, at the next frame or poll. 
+ * The counters of the stream thread are atomic and zeroed here.
+ */
 bool AravisDetectorPlugin::reset_statistics(){
-    n_input_buff_ =0;
-    n_output_buff_ =0;
-    n_completed_buff_ =0;
-    n_failed_buff_ =0;  
-    n_underrun_buff_ =0;
+    frame_reset_requested_ = true;
+    camera_reset_requested_ = true;
+    for (int outcome = 0; outcome < N_BUFFER_OUTCOMES; outcome++)
+      buffer_outcomes_[outcome].store(0, std::memory_order_relaxed);
+    n_queue_high_water_ =0;
+    n_queue_blocked_ =0;
+    n_queue_dropped_oldest_ =0;
+    n_queue_dropped_newest_ =0;
+    frame_compressor_.reset_statistics();
     return true;
 }
 
+/** @brief Zeroes the frame counters if reset_statistics asked for it
+ * 
+ * Called by the thread making frames, or by the command thread while there is none.
+ */
+void AravisDetectorPlugin::consume_frame_reset(){
+  if(!frame_reset_requested_.exchange(false))
+    return;
+  n_zero_copy_frames_ =0;
+  n_copied_frames_ =0;
+  n_unpacked_frames_ =0;
+  n_corrected_frames_ =0;
+  n_correction_mismatches_ =0;
+  n_reduced_frames_ =0;
+  n_decimated_frames_ =0;
+  n_measured_frames_ =0;
+  n_partial_batches_ =0;
+  n_frame_gaps_ =0;
+  n_missing_frames_ =0;
+  longest_frame_gap_ =0;
+  n_frame_id_wraps_ =0;
+  n_frame_id_resets_ =0;
+  n_placeholder_frames_ =0;
+  n_virtual_frames_ =0;
+  n_virtual_late_frames_ =0;
+  for (LatencyHistogram& histogram : latency_)
+    histogram.reset();
+  publish_frame_stats();
+}
+
+/** @brief Zeroes the stream statistics if reset_statistics asked for it, on the command thread */
+void AravisDetectorPlugin::consume_camera_reset(){
+  if(!camera_reset_requested_.exchange(false))
+    return;
+  n_input_buff_ =0;
+  n_output_buff_ =0;
+  n_completed_buff_ =0;
+  n_failed_buff_ =0;
+  n_underrun_buff_ =0;
+  n_pool_grows_ =0;
+  n_pool_shrinks_ =0;
+  n_pool_limit_hits_ =0;
+  publish_camera_stats();
+}
+
+/** @brief Publishes the frame counters for status()
+ * 
+ * Called by the thread pushing frames after each frame, so status() never reads
+ * the counters while they are being updated.
+ */
+void AravisDetectorPlugin::publish_frame_stats(){
+  FrameStats stats;
+  stats.frames_made = n_frames_made_;
+  stats.image_height = image_height_px_;
+  stats.image_width = image_width_px_;
+  stats.zero_copy_frames = n_zero_copy_frames_;
+  stats.copied_frames = n_copied_frames_;
+  stats.unpacked_frames = n_unpacked_frames_;
+  stats.corrected_frames = n_corrected_frames_;
+  stats.correction_mismatches = n_correction_mismatches_;
+  stats.dark_capture_frames = dark_capture_frames_;
+  stats.reduced_frames = n_reduced_frames_;
+  stats.decimated_frames = n_decimated_frames_;
+  stats.measured_frames = n_measured_frames_;
+  stats.batches_made = n_batches_made_;
+  stats.partial_batches = n_partial_batches_;
+  stats.frame_gaps = n_frame_gaps_;
+  stats.missing_frames = n_missing_frames_;
+  stats.longest_frame_gap = longest_frame_gap_;
+  stats.frame_id_wraps = n_frame_id_wraps_;
+  stats.frame_id_resets = n_frame_id_resets_;
+  stats.placeholder_frames = n_placeholder_frames_;
+  stats.recovery_dropped_frames = n_recovery_dropped_frames_;
+  stats.virtual_frames = n_virtual_frames_;
+  stats.virtual_late_frames = n_virtual_late_frames_;
+  stats.clock = clock_mapper_.estimate();
+  frame_stats_.write(stats);
+}
+
+/** @brief Publishes the camera values and stream statistics for status()
+ * 
+ * Called by the command thread whenever they are read from the camera or changed by
+ * a config; it is the only writer of the snapshot.
+ */
+void AravisDetectorPlugin::publish_camera_stats(){
+  CameraStats stats;
+  stats.exposure_time_us = exposure_time_us_;
+  stats.frame_rate_hz = frame_rate_hz_;
+  stats.payload = payload_;
+  stats.input_buffers = n_input_buff_;
+  stats.output_buffers = n_output_buff_;
+  stats.completed_buffers = n_completed_buff_;
+  stats.failed_buffers = n_failed_buff_;
+  stats.underrun_buffers = n_underrun_buff_;
+  stats.liveness_failures = n_liveness_failures_;
+  stats.parameter_resyncs = n_parameter_resyncs_;
+  stats.config_restarts = n_config_restarts_;
+  stats.fast_reconnects = n_fast_reconnects_;
+  stats.recoveries = n_recoveries_;
+  stats.recovery_attempts = n_recovery_attempts_;
+  stats.last_recovery_gap_ms = last_recovery_gap_ms_;
+  stats.empty_buffers = n_empty_buffers_;
+  stats.arena_bytes = buffer_arena_.mapped_bytes();
+  stats.arena_hugepages = buffer_arena_.on_hugepages();
+  stats.arena_locked = buffer_arena_.locked();
+  stats.arena_reuses = n_arena_reuses_;
+  stats.pool_grows = n_pool_grows_;
+  stats.pool_shrinks = n_pool_shrinks_;
+  stats.pool_limit_hits = n_pool_limit_hits_;
+  camera_stats_.write(stats);
+}
+
+/** @brief Copies the names and modes of the camera for status() and requestConfiguration()
+ * 
+ * Called by the command thread after each command and poll, the only thread that
+ * changes them.
+ */
+void AravisDetectorPlugin::publish_camera_settings(){
+  boost::mutex::scoped_lock lock(camera_settings_mutex_);
+  camera_settings_.id = camera_id_;
+  camera_settings_.serial = camera_serial_;
+  camera_settings_.address = camera_address_;
+  camera_settings_.model = camera_model_;
+  camera_settings_.pixel_format = pixel_format_;
+  camera_settings_.acquisition_mode = acquisition_mode_;
+}
+
 /** @brief Status execution thread for this class.
  *
  * The thread executes in a continuous loop until the working_ flag is set to false.
- * This thread queries the camera status
+ * The camera itself is only polled by the command thread, see poll_camera; this
+ * thread queues the polls and logs the buffer summaries.
  */
 void AravisDetectorPlugin::status_task()
 {
-  // Error return value
-	GErrorWrapper error;
   // Configure logging for this thread
   OdinData::configure_logging_mdc(OdinData::app_path.c_str());
 
   // Main worker task of this callback
-  // Check the queue for messages
+  bool was_streaming = false;
   while (working_) {
     boost::this_thread::sleep(boost::posix_time::milliseconds(status_freq_ms_));
 
-    if (camera_connected_){
-      get_config(GET_CONFIG_CAMERA_PARAMS);
-      if(streaming_){
-        get_config(GET_CONFIG_STREAM_STAT);
-      }
-    }
+    if(!poll_queued_.exchange(true))
+      queue_task(COMMAND_POLL);
+    // the last, partial interval of a stream is summed up once it has stopped
+    bool streaming = streaming_;
+    if(streaming || was_streaming)
+      log_buffer_summary(!streaming);
+    was_streaming = streaming;
   }
 }
 
@@ -341,23 +1028,34 @@ void AravisDetectorPlugin::get_config(int32_t get_option){
       get_pixel_format();
 
       get_acquisition_mode();
+      get_image_size();
       get_frame_size();
 
+      last_resync_ = boost::posix_time::microsec_clock::universal_time();
       break;
 
     case GET_CONFIG_CAMERA_PARAMS: 
-    /** Constant camera parameter check */
-
-      check_connection();
-
-      if(camera_connected_){
+    /** Constant camera parameter check
+     * 
+     * The parameters are cached at connect and refreshed by our own writes, so a
+     * poll only reads them from the camera when a resync is due.
+     */
+    {
+      bool resync = parameter_resync_due();
+      check_connection(resync);
+
+      if(camera_connected_ && resync){
         get_frame_rate();
         get_exposure();
         get_pixel_format();
         get_acquisition_mode();
+        get_image_size();
         get_frame_size();
+        read_features();
+        n_parameter_resyncs_++;
       }
       break;
+    }
     case GET_CONFIG_STREAM_STAT:
     /** Stream Statistics*/ 
       get_stream_state();
@@ -375,6 +1073,7 @@ void AravisDetectorPlugin::get_config(int32_t get_option){
       get_pixel_format();
 
       get_acquisition_mode();
+      get_image_size();
       get_frame_size();
 
       get_stream_state();
@@ -383,6 +1082,7 @@ void AravisDetectorPlugin::get_config(int32_t get_option){
   default:
     log_error("Invalid get_config option");      
 }
+  publish_camera_stats();
 }
 
 
@@ -412,6 +1112,8 @@ void AravisDetectorPlugin::set_file_path(std::string new_file_path,  OdinData::I
 }
 
 /** @brief Change data set name
+ * 
+ * Frames are made by another thread, so the name is applied on the next stream start.
  * 
  * @param data_set_name string
  * @param reply ipc message log
@@ -422,6 +1124,8 @@ void AravisDetectorPlugin::set_dataset_name(std::string data_set_name,  OdinData
 }
 
 /** @brief Change compression type used 
+ * 
+ * Applied on the next stream start, like the data set name.
  * 
  * @param compression_type string
  * @param reply ipc message log
@@ -441,6 +1145,86 @@ void AravisDetectorPlugin::set_status_poll_frequency(size_t status_freq_ms,  Odi
   status_freq_ms_ = status_freq_ms;
 }
 
+/** @brief Change the minimum time between background device discoveries
+ * 
+ * @param interval_ms size_t, in miliseconds
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_discovery_interval(size_t interval_ms,  OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "discovery_interval_ms_ | old: "<< discovery_interval_ms_ << " | new:" << interval_ms);
+  discovery_interval_ms_ = interval_ms;
+}
+
+/** @brief Choose whether camera operations run on the command thread
+ * 
+ * When false they run on the caller's thread, and the reply reports their errors.
+ * 
+ * @param async_commands bool
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_async_commands(bool async_commands,  OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "async_commands_ | old: "<< async_commands_ << " | new:" << async_commands);
+  async_commands_ = async_commands;
+}
+
+/** @brief Change the directory of cached camera states
+ * 
+ * Cameras whose serial number has a state in this directory are restored from it
+ * on connection, skipping the full read back.
+ * 
+ * @param cache_path directory, created on first use, empty to disable the cache
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_camera_cache_path(std::string cache_path,  OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "camera_cache_path_ | old: "<< camera_cache_path_ << " | new:" << cache_path);
+  camera_cache_path_ = cache_path;
+}
+
+/** @brief Turns automatic recovery of a lost camera on or off
+ * 
+ * When on, a camera that fails the liveness check is looked for by serial number
+ * every discovery_interval_ms_, reconnected, given its configuration back and, if
+ * it was streaming, restarted.
+ * 
+ * @param auto_recover bool: true to recover lost cameras
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_auto_recover(bool auto_recover,  OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "auto_recover_ | old: "<< auto_recover_ << " | new:" << auto_recover);
+  auto_recover_ = auto_recover;
+  if(!auto_recover)
+    recovering_ = false;
+}
+
+/** @brief Change the time between re-reads of the cached camera parameters
+ * 
+ * Only needed to pick up changes made to the camera by something other than this
+ * plugin, such as another client or the camera adjusting itself.
+ * 
+ * @param resync_ms size_t, in miliseconds, 0 to never re-read them
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_parameter_resync(size_t resync_ms,  OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "parameter_resync_ms_ | old: "<< parameter_resync_ms_ << " | new:" << resync_ms);
+  parameter_resync_ms_ = resync_ms;
+}
+
+/** @brief Is it time to re-read the cached camera parameters?
+ * 
+ * @return true once every parameter_resync_ms_, never when it is 0
+ */
+bool AravisDetectorPlugin::parameter_resync_due(){
+  if(parameter_resync_ms_ == 0) return false;
+
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  if(!last_resync_.is_not_a_date_time() &&
+     (now - last_resync_).total_milliseconds() < static_cast<long>(parameter_resync_ms_))
+    return false;
+
+  last_resync_ = now;
+  return true;
+}
+
 
 /*******************************
 *      Callback functions      *
@@ -455,15 +1239,198 @@ static void buffer_callback(ArvStream *stream_temp, AravisDetectorPlugin *object
   object_temp->callback_access(stream_temp);
 }
 
-/** @brief Provides the callback function with access to acquire_stream_buffer
+/** @brief Called by Aravis when the camera stops answering the heartbeat
+ * 
+ * @param device pointer to the ArvDevice of the connected camera
+ * @param object_temp pointer to the AravisDetectorPlugin currently running
+ */
+static void control_lost_callback(ArvDevice *device, AravisDetectorPlugin *object_temp){
+  object_temp->control_lost();
+}
+
+/** @brief Flags the camera as lost, picked up by the next status poll
+ * 
+ * Runs on the Aravis heartbeat thread, so it only sets the flag.
+ */
+void AravisDetectorPlugin::control_lost(){
+  control_lost_ = true;
+}
+
+/** @brief Provides the callback function with access to the stream buffers
+ * 
+ * Runs on the Aravis stream thread, so it only pops the finished buffer, validates it
+ * and hands it to the dispatch thread. Failed buffers go straight back to the stream.
  * 
  * @param stream_temp pointer to currently used ArvStream object 
  */
 void AravisDetectorPlugin::callback_access(ArvStream *stream_temp){
-  stream_ = stream_temp;
-  acquire_buffer();
+  uint64_t callback_time = realtime_ns();
+
+  ArvBuffer *buffer = arv_stream_try_pop_buffer(stream_temp);
+  if(buffer == NULL)
+    return;
+
+  // counted until the buffer is queued or handed back, so a stop can wait for it
+  n_callbacks_active_++;
+  if(!buffer_is_valid(buffer) || !dispatching_){
+    requeue_buffer(stream_temp, buffer);
+  }else{
+    QueuedBuffer queued = {buffer, callback_time};
+    enqueue_buffer(stream_temp, queued);
+  }
+  n_callbacks_active_--;
 } 
 
+/** @brief Passes a valid buffer to the dispatch thread
+ * 
+ * When the queue is full the overflow policy decides whether the stream thread waits 
+ * for room, discards the oldest queued buffer or discards the incoming one. Discarded
+ * buffers are pushed back to the stream straight away.
+ * 
+ * @param stream the stream the buffer was popped from, which is not stream_ once a
+ *        stop has released it
+ * @param queued a completed buffer popped from stream and the time it was popped
+ */
+void AravisDetectorPlugin::enqueue_buffer(ArvStream *stream, const QueuedBuffer& queued){
+  if(!dispatch_queue_->try_push(queued)){
+    QueuedBuffer oldest;
+    switch(stream_queue_overflow_){
+      case QUEUE_DROP_NEWEST:
+        n_queue_dropped_newest_++;
+        requeue_buffer(stream, queued.buffer);
+        return;
+      case QUEUE_DROP_OLDEST:
+        do{
+          if(dispatch_queue_->try_pop(oldest)){
+            n_queue_dropped_oldest_++;
+            requeue_buffer(stream, oldest.buffer);
+          }
+        }while(!dispatch_queue_->try_push(queued));
+        break;
+      case QUEUE_BLOCK:
+        n_queue_blocked_++;
+        do{
+          if(!dispatching_){
+            requeue_buffer(stream, queued.buffer);
+            return;
+          }
+          boost::this_thread::yield();
+        }while(!dispatch_queue_->try_push(queued));
+        break;
+    }
+  }
+
+  // the push must be visible before the flag is read, or a dispatch thread going to
+  // sleep could miss both the buffer and the wake up
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if(dispatch_waiting_){
+    boost::mutex::scoped_lock lock(dispatch_wait_mutex_);
+    dispatch_wait_cond_.notify_one();
+  }
+
+  long unsigned int queue_size = dispatch_queue_->size();
+  n_queue_size_ = queue_size;
+  if(queue_size > n_queue_high_water_)
+    n_queue_high_water_ = queue_size;
+}
+
+/** @brief Dispatch execution thread
+ * 
+ * Runs while the stream is active. Takes buffers queued by the stream callback, turns
+ * them into frames and pushes them through the downstream plugins, so a slow plugin 
+ * never holds up the Aravis stream thread.
+ */
+void AravisDetectorPlugin::dispatch_task(){
+  // Configure logging for this thread
+  OdinData::configure_logging_mdc(OdinData::app_path.c_str());
+
+  QueuedBuffer queued;
+  int idle_spins = 0;
+  while(dispatching_){
+    consume_frame_reset();
+    if(!dispatch_queue_->try_pop(queued)){
+      // spin briefly so a buffer right behind is picked up without a wake up, then sleep
+      if(++idle_spins < DISPATCH_IDLE_SPINS){
+        boost::this_thread::yield();
+      }else{
+        flush_stale_batch();
+        wait_for_buffer();
+      }
+      continue;
+    }
+    idle_spins = 0;
+    n_queue_size_ = dispatch_queue_->size();
+
+    // a zero copy frame hands the buffer back itself once it is released
+    if(!process_buffer(queued.buffer, queued.callback_time))
+      requeue_buffer(stream_, queued.buffer);
+  }
+
+  // return anything still queued so the stream owns all of its buffers again
+  while(dispatch_queue_->try_pop(queued))
+    requeue_buffer(stream_, queued.buffer);
+}
+
+/** @brief Sleeps the dispatch thread until a buffer is queued, it is stopped or DISPATCH_IDLE_WAIT_MS pass
+ * 
+ * The stream thread only takes the lock to wake it when the flag says it sleeps, so
+ * a steady stream costs no system call on either side.
+ */
+void AravisDetectorPlugin::wait_for_buffer(){
+  boost::mutex::scoped_lock lock(dispatch_wait_mutex_);
+  dispatch_waiting_ = true;
+  // a buffer queued before the flag was raised gets no wake up
+  if(dispatch_queue_->size() == 0 && dispatching_)
+    dispatch_wait_cond_.timed_wait(lock, boost::posix_time::milliseconds(DISPATCH_IDLE_WAIT_MS));
+  dispatch_waiting_ = false;
+}
+
+/** @brief Creates the dispatch queue and starts the dispatch thread
+ * 
+ * The queue is sized from queue_depth_ and its overflow policy latched every time,
+ * so a new depth or policy is picked up on the next stream start. The previous thread
+ * must already be stopped: stopping it here would also stop the compressor started
+ * for this stream.
+ */
+void AravisDetectorPlugin::start_dispatch_thread(){
+  dispatch_queue_.reset(new SpscQueue<QueuedBuffer>(queue_depth_));
+  stream_queue_overflow_ = queue_overflow_;
+  n_queue_size_ = 0;
+  dispatching_ = true;
+  dispatch_thread_ = new boost::thread(&AravisDetectorPlugin::dispatch_task, this);
+}
+
+/** @brief Stops the dispatch thread and waits for the frame it is pushing to finish
+ * 
+ * Turning the stream signals off does not wait for a callback already running, so
+ * the callbacks still queuing a buffer are waited for and whatever they queued after
+ * the dispatch thread's last pass goes back to the stream, which then owns all of
+ * its buffers again. Must not be called from the dispatch thread itself.
+ */
+void AravisDetectorPlugin::stop_dispatch_thread(){
+  dispatching_ = false;
+  {
+    boost::mutex::scoped_lock lock(dispatch_wait_mutex_);
+    dispatch_wait_cond_.notify_one();
+  }
+  while(n_callbacks_active_ > 0)
+    boost::this_thread::yield();
+  if(dispatch_thread_ != NULL){
+    dispatch_thread_->join();
+    delete dispatch_thread_;
+    dispatch_thread_ = NULL;
+    QueuedBuffer queued;
+    while(dispatch_queue_->try_pop(queued))
+      requeue_buffer(stream_, queued.buffer);
+    n_queue_size_ = 0;
+    // the thread making frames is gone, so the batch it left can be pushed from here
+    flush_batch();
+    publish_frame_stats();
+  }
+  // the frames still being compressed are pushed before this returns
+  frame_compressor_.stop();
+}
+
 
 /*********************************
 **       Camera Functions       **
@@ -488,26 +1455,46 @@ void AravisDetectorPlugin::callback_access(ArvStream *stream_temp){
  */
 void AravisDetectorPlugin::connect_aravis_camera(std::string ip_string, OdinData::IpcMessage& reply){
   GErrorWrapper error;
-  arv_update_device_list();
-  unsigned int number_of_cameras = arv_get_n_devices();
 
-  if(number_of_cameras == 0){
-    log_warning("No camera found on network", reply);
-    return;
+  // a stream cannot outlive the camera it came from
+  if(camera_ != NULL){
+    if(streaming_ && stream_ != NULL)
+      auto_stop_stream();
+    release_camera();
+  }
+
+  {
+    // Aravis opens a camera by address without a discovery; the device list is
+    // shared with the background discovery
+    boost::mutex::scoped_lock lock(device_list_mutex_);
+    camera_ = arv_camera_new(ip_string.c_str(), error.get());
   }
 
-  camera_ = arv_camera_new(ip_string.c_str(), error.get());
+  // otherwise discover the network and try again, for ids that are not an address
+  if(error || !ARV_IS_CAMERA(camera_)){
+    unsigned int number_of_cameras = update_device_list();
 
-  if(error){log_error("Error when connecting to camera: "+ error.message(), reply);
-    return;}
+    if(number_of_cameras == 0){
+      log_warning("No camera found on network", reply);
+      return;
+    }
+
+    GErrorWrapper retry_error;
+    {
+      boost::mutex::scoped_lock lock(device_list_mutex_);
+      camera_ = arv_camera_new(ip_string.c_str(), retry_error.get());
+    }
+    if(retry_error){log_error("Error when connecting to camera: "+ retry_error.message(), reply);
+      return;}
+  }
 
   if (!ARV_IS_CAMERA (camera_)){log_error("Failed to create camera object", reply);
     return;}
 
+  // Aravis keeps a heartbeat with the camera and reports when it fails
+  control_lost_ = false;
+  control_lost_handler_ = g_signal_connect(arv_camera_get_device(camera_), "control-lost", G_CALLBACK(control_lost_callback), this);
 
-  camera_model_ = arv_camera_get_model_name (camera_, NULL);
-  LOG4CXX_INFO(logger_,"Connected to camera " << camera_model_);
-    
   /***************************************
   **      Camera init routine
   ****************************************/
@@ -516,11 +1503,18 @@ void AravisDetectorPlugin::connect_aravis_camera(std::string ip_string, OdinData
 
   camera_address_ = ip_string;
   camera_connected_ = true;
+  // any connection, by hand or by a recovery attempt, ends a recovery
+  recovering_ = false;
 
-  // get config values 
-  get_config(GET_CONFIG_CAMERA_INIT);
+  // feature nodes belong to the device they were resolved on
+  feature_table_.reset(arv_camera_get_device(camera_));
 
-  save_genicam_xml(temp_file_path_);
+  // a camera seen before is restored from the cache, otherwise read everything back
+  get_camera_serial();
+  if(!restore_camera_state(reply))
+    init_camera_state();
+
+  LOG4CXX_INFO(logger_,"Connected to camera " << camera_model_);
 
   // display configs
   LOG4CXX_INFO(logger_, "The exposure time bounds are min: " << min_exposure_time_ << " and max: "<< max_exposure_time_);
@@ -538,8 +1532,14 @@ void AravisDetectorPlugin::connect_aravis_camera(std::string ip_string, OdinData
 
 /** @brief check that camera is still connected
  * 
+ * Runs on every status poll, so it only asks the connected camera itself: the
+ * control-lost flag raised by the Aravis heartbeat and, with a parameter resync,
+ * a single serial number read. Network discovery is left to a background thread,
+ * started when the camera is lost.
+ * 
+ * @param read_serial also read the serial number to check it is the same camera
  */
-void AravisDetectorPlugin::check_connection(){
+void AravisDetectorPlugin::check_connection(bool read_serial){
 
   if(camera_ == NULL){
     log_error("No connection, camera object removed unexpectedly during run");
@@ -547,43 +1547,60 @@ void AravisDetectorPlugin::check_connection(){
     return;
   }
 
-  arv_update_device_list();
-  unsigned int number_of_cameras = arv_get_n_devices();
-
-  if(number_of_cameras==0){camera_connected_= false;
-    LOG4CXX_INFO(logger_, "No camera found on network");}
-
-  bool found_match = false;
-  for(int i=0; i<number_of_cameras; i++){
-    if (camera_address_ == arv_get_device_address(i)){
-      found_match =true;
-    }
+  if(control_lost_){camera_connected_ = false;
+    LOG4CXX_INFO(logger_, "No connection, camera stopped answering the heartbeat");
   }
+  else if(read_serial){
+    GErrorWrapper error;
+    std::string serial_temp = arv_camera_get_device_serial_number(camera_, error.get());
 
-  if(!found_match){     camera_connected_= false;
-    LOG4CXX_INFO(logger_, "No connection, none of the cameras available match the address");
+    if(error){camera_connected_=false; 
+      LOG4CXX_INFO(logger_, "No connection, error: "<< error.message());  
+      }
+    else if(camera_serial_ != serial_temp){camera_connected_=false; 
+      LOG4CXX_INFO(logger_, "Connected to different camera");    }
   }
 
-  GErrorWrapper error;
-  std::string serial_temp = arv_camera_get_device_serial_number(camera_, error.get());
-
-  if(error){camera_connected_=false; 
-    LOG4CXX_INFO(logger_, "No connection, error: "<< error.message());  
-    }
-
-  if(camera_serial_ != serial_temp){camera_connected_=false; 
-    LOG4CXX_INFO(logger_, "Connected to different camera");    }
-
   // If camera is connected after all that, then exit
   if(camera_connected_) return;
 
   // if not, we need to stop all camera related processes
   // OdinData::IpcMessage msg;
+  n_liveness_failures_++;
+  bool was_streaming = streaming_;
   if(streaming_)auto_stop_stream();
-  camera_ = NULL;
+
+  // remember what the camera was doing while the cached model still describes it
+  if(auto_recover_ && !camera_serial_.empty()){
+    capture_camera_state(recovery_state_);
+    recovery_resume_stream_ = was_streaming;
+    // the dispatch thread has been stopped, so its last frame id is settled
+    lost_frame_id_ = last_frame_id_;
+    camera_lost_time_ = boost::posix_time::microsec_clock::universal_time();
+    last_recovery_attempt_ = boost::posix_time::ptime();
+    recovering_ = true;
+    LOG4CXX_WARN(logger_, "Lost camera " << camera_serial_ << ", trying to recover it");
+  }
+
+  release_camera();
+  // a recovery runs its own discovery
+  if(!recovering_)
+    request_discovery();
 }
 
 
+/** @brief Drops the camera object, its control-lost handler and its feature nodes */
+void AravisDetectorPlugin::release_camera(){
+  feature_table_.reset(NULL);
+  if(camera_ == NULL)
+    return;
+  if(control_lost_handler_ != 0){
+    g_signal_handler_disconnect(arv_camera_get_device(camera_), control_lost_handler_);
+    control_lost_handler_ = 0;
+  }
+  g_clear_object(&camera_);
+}
+
 /** @brief Checks for available devices
  * 
  * Displays in the console a list of all available cameras in the format:
@@ -592,17 +1609,149 @@ void AravisDetectorPlugin::check_connection(){
  * Device index [int] has the id [str] and address [str]
  */
 void AravisDetectorPlugin::find_aravis_cameras(OdinData::IpcMessage& reply){
-  // Updating the device list is required before using get device id
-  arv_update_device_list();
-  unsigned int number_of_cameras = arv_get_n_devices();
+  unsigned int number_of_cameras = update_device_list();
 
   if(number_of_cameras==0){ log_warning("No camera found on network", reply);
     return;}
+}
 
-  connected_devices_ = number_of_cameras;
-  for(int i=0; i<number_of_cameras; i++){
+/** @brief Runs Aravis device discovery and refreshes the list of available cameras
+ * 
+ * Discovery broadcasts on every interface and waits for the answers, so it is only
+ * run on request and from the background discovery thread, never on a status poll.
+ * 
+ * @return number of devices found
+ */
+unsigned int AravisDetectorPlugin::update_device_list(){
+  boost::mutex::scoped_lock lock(device_list_mutex_);
+  // Updating the device list is required before using get device id
+  arv_update_device_list();
+  unsigned int number_of_cameras = arv_get_n_devices();
+
+  connected_devices_ = number_of_cameras;
+  available_cameras_.clear();
+  for(unsigned int i=0; i<number_of_cameras; i++){
     available_cameras_[std::to_string(i)] = std::make_pair(arv_get_device_id(i),arv_get_device_address(i));
   }
+  return number_of_cameras;
+}
+
+/** @brief Starts a background discovery unless one is running or ran recently
+ * 
+ * At most one discovery runs per discovery_interval_ms_, however often the camera
+ * is found missing.
+ */
+void AravisDetectorPlugin::request_discovery(){
+  if(discovering_) return;
+
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  if(!last_discovery_.is_not_a_date_time() &&
+     (now - last_discovery_).total_milliseconds() < static_cast<long>(discovery_interval_ms_))
+    return;
+
+  if(discovery_thread_ != NULL){
+    discovery_thread_->join();
+    delete discovery_thread_;
+  }
+  last_discovery_ = now;
+  discovering_ = true;
+  discovery_thread_ = new boost::thread(&AravisDetectorPlugin::discovery_task, this);
+}
+
+/** @brief Is it time for another attempt to recover the lost camera?
+ * 
+ * Called from the status polls while recovering. Attempts are spaced by
+ * discovery_interval_ms_, since each one runs a discovery.
+ */
+bool AravisDetectorPlugin::recovery_due(){
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  if(!last_recovery_attempt_.is_not_a_date_time() &&
+     (now - last_recovery_attempt_).total_milliseconds() < static_cast<long>(discovery_interval_ms_))
+    return false;
+  last_recovery_attempt_ = now;
+  return true;
+}
+
+/** @brief Looks for the camera with the given serial number on the network
+ * 
+ * @param serial serial number of the camera
+ * @param[out] address address of the camera if found
+ * @return false if no camera with this serial number answered the discovery
+ */
+bool AravisDetectorPlugin::find_device_by_serial(const std::string& serial, std::string& address){
+  unsigned int number_of_cameras = update_device_list();
+  n_discoveries_++;
+
+  boost::mutex::scoped_lock lock(device_list_mutex_);
+  for(unsigned int i=0; i<number_of_cameras; i++){
+    const char *device_serial = arv_get_device_serial_nbr(i);
+    if(device_serial != NULL && serial == device_serial){
+      const char *device_address = arv_get_device_address(i);
+      if(device_address == NULL)
+        return false;
+      address = device_address;
+      return true;
+    }
+  }
+  return false;
+}
+
+/** @brief One attempt to reconnect to the lost camera and resume where it stopped
+ * 
+ * Runs on the command thread, from a status poll. The camera is
+ * found by serial number, since a rebooted switch or camera may hand it a new
+ * address. Once connected the configuration it had when it was lost is applied 
+ * again and, if it was streaming, the stream is restarted with the buffer arena
+ * and frame numbering of the old one. The time without a camera and the frames
+ * it would have sent meanwhile are reported in the status.
+ */
+void AravisDetectorPlugin::recover_camera(){
+  // the operator may have connected a camera or turned recovery off meanwhile
+  if(!recovering_ || camera_connected_ || !auto_recover_){
+    recovering_ = false;
+    return;
+  }
+
+  n_recovery_attempts_++;
+  std::string address;
+  if(!find_device_by_serial(recovery_state_.serial, address)){
+    LOG4CXX_INFO(logger_, "Lost camera " << recovery_state_.serial << " not found yet");
+    return;
+  }
+
+  OdinData::IpcMessage reply;
+  long unsigned int fast_reconnects = n_fast_reconnects_;
+  connect_aravis_camera(address, reply);
+  if(!camera_connected_ || camera_serial_ != recovery_state_.serial){
+    LOG4CXX_WARN(logger_, "Failed to reconnect to lost camera " << recovery_state_.serial << " at " << address);
+    return;
+  }
+
+  // a fast reconnect has already replayed the cached state, otherwise the
+  // camera may have come back with its power on defaults
+  if(n_fast_reconnects_ == fast_reconnects)
+    replay_camera_state(recovery_state_, reply);
+
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  last_recovery_gap_ms_ = static_cast<long unsigned int>((now - camera_lost_time_).total_milliseconds());
+  if(recovery_resume_stream_){
+    // only used if the camera restarted its frame ids, see check_frame_id
+    lost_frames_estimate_ = recovery_state_.acquisition_mode == "Continuous" ?
+      static_cast<long unsigned int>(last_recovery_gap_ms_ * recovery_state_.frame_rate_hz / 1000.0) : 0;
+    start_stream(reply, true);
+  }
+  recovering_ = false;
+  n_recoveries_++;
+  LOG4CXX_WARN(logger_, "Recovered camera " << camera_serial_ << " at " << address << " after " << last_recovery_gap_ms_ << " ms");
+}
+
+/** @brief Background discovery thread, refreshes the available cameras once */
+void AravisDetectorPlugin::discovery_task(){
+  OdinData::configure_logging_mdc(OdinData::app_path.c_str());
+  unsigned int number_of_cameras = update_device_list();
+  n_discoveries_++;
+  LOG4CXX_INFO(logger_, "Background discovery found " << number_of_cameras << " devices");
+  discovering_ = false;
 }
 
 /** @brief Get serial of the current connected camera
@@ -626,6 +1775,134 @@ void AravisDetectorPlugin::get_camera_serial(){
   camera_serial_ = serial_temp;
 }
 
+/** @brief Reads the whole camera model back from a newly connected camera
+ * 
+ * The slow path of a connection, also saving the GenICam XML and the camera state
+ * for the next fast reconnect.
+ */
+void AravisDetectorPlugin::init_camera_state(){
+  camera_model_ = arv_camera_get_model_name (camera_, NULL);
+  applied_features_.clear();
+
+  // get config values 
+  get_config(GET_CONFIG_CAMERA_INIT);
+
+  save_genicam_xml(temp_file_path_);
+  if(!camera_cache_path_.empty()){
+    size_t xml_length;
+    const char *xml = arv_device_get_genicam_xml(arv_camera_get_device(camera_), &xml_length);
+    std::string error;
+    if(!CameraCache::save_xml(camera_cache_path_, camera_serial_, xml, xml_length, error))
+      log_warning(error);
+  }
+  save_camera_state();
+}
+
+/** @brief Restores a camera from the camera cache instead of reading it back
+ * 
+ * The cached description (model, id, bounds and pixel formats) is taken as is and
+ * the last applied configuration is written back in one batch, since the camera
+ * may have been power cycled. Only what the setters read back is read from the
+ * camera.
+ * 
+ * @param reply ipc message log
+ * @return false if the cache is disabled or holds nothing usable for this camera
+ */
+bool AravisDetectorPlugin::restore_camera_state(OdinData::IpcMessage& reply){
+  if(camera_cache_path_.empty() || camera_serial_.empty())
+    return false;
+
+  CameraState state;
+  std::string error;
+  if(!CameraCache::load(camera_cache_path_, camera_serial_, state, error)){
+    LOG4CXX_INFO(logger_, error);
+    return false;
+  }
+
+  camera_model_ = state.model;
+  camera_id_ = state.id;
+  min_exposure_time_ = state.min_exposure_time;
+  max_exposure_time_ = state.max_exposure_time;
+  min_frame_rate_ = state.min_frame_rate;
+  max_frame_rate_ = state.max_frame_rate;
+  set_pixel_format_list(state.pixel_formats);
+
+  replay_camera_state(state, reply);
+
+  last_resync_ = boost::posix_time::microsec_clock::universal_time();
+  n_fast_reconnects_++;
+  LOG4CXX_INFO(logger_, "Restored camera " << camera_serial_ << " from the camera cache");
+  return true;
+}
+
+/** @brief Writes a saved configuration back to the connected camera in one batch
+ * 
+ * Used when the camera may have lost its settings: after a fast reconnect and when
+ * recovering a lost camera.
+ * 
+ * @param state configuration to apply, its features replace the applied features
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::replay_camera_state(const CameraState& state, OdinData::IpcMessage& reply){
+  OdinData::IpcMessage config;
+  config.set_param(CONFIG_PIXEL_FORMAT, state.pixel_format);
+  config.set_param(CONFIG_IMAGE_WIDTH, state.width);
+  config.set_param(CONFIG_IMAGE_HEIGHT, state.height);
+  config.set_param(CONFIG_ACQUISITION_MODE, state.acquisition_mode);
+  config.set_param(CONFIG_EXPOSURE, state.exposure_time_us);
+  config.set_param(CONFIG_FRAME_RATE, state.frame_rate_hz);
+  apply_camera_config(config, reply, true);
+
+  applied_features_.clear();
+  bool model_changed = false;
+  std::string error;
+  for(const std::pair<std::string, FeatureTable::Input>& feature : state.features){
+    int index = feature_table_.resolve(feature.first, error);
+    if(index < 0){
+      log_error(error, reply);
+      continue;
+    }
+    if(write_feature(index, feature.first, feature.second, reply))
+      model_changed = model_changed || is_modelled_feature(feature.first);
+  }
+  if(model_changed)
+    refresh_camera_model();
+  save_camera_state();
+}
+
+/** @brief Copies the camera model and applied configuration into a CameraState */
+void AravisDetectorPlugin::capture_camera_state(CameraState& state){
+  state = CameraState();
+  state.serial = camera_serial_;
+  state.model = camera_model_;
+  state.id = camera_id_;
+  state.min_exposure_time = min_exposure_time_;
+  state.max_exposure_time = max_exposure_time_;
+  state.exposure_time_us = exposure_time_us_;
+  state.min_frame_rate = min_frame_rate_;
+  state.max_frame_rate = max_frame_rate_;
+  state.frame_rate_hz = frame_rate_hz_;
+  state.pixel_formats = pixel_formats_;
+  state.pixel_format = pixel_format_;
+  state.acquisition_mode = acquisition_mode_;
+  state.width = camera_width_px_;
+  state.height = camera_height_px_;
+  state.payload = payload_;
+  state.features.assign(applied_features_.begin(), applied_features_.end());
+}
+
+/** @brief Saves the camera model and applied configuration to the camera cache */
+void AravisDetectorPlugin::save_camera_state(){
+  if(camera_cache_path_.empty() || camera_serial_.empty() || !ARV_IS_CAMERA(camera_))
+    return;
+
+  CameraState state;
+  capture_camera_state(state);
+  std::string error;
+  if(!CameraCache::save(camera_cache_path_, state, error))
+    log_warning(error);
+}
+
 /** @brief Get id of the current connected camera
  *
  * Saved to camera_id_
@@ -652,11 +1929,11 @@ void AravisDetectorPlugin::get_camera_id(){
  * 
  * @param acq_mode std::string = one of the following: "Continuous", "SingleFrame","MultiFrame"
  */
-void AravisDetectorPlugin::set_acquisition_mode(std::string acq_mode, OdinData::IpcMessage& reply){
+bool AravisDetectorPlugin::set_acquisition_mode(std::string acq_mode, OdinData::IpcMessage& reply){
   
   if(!(acq_mode == "Continuous" || acq_mode == "SingleFrame" ||acq_mode == "MultiFrame")){
-    log_error("the acquisition mode supplied: " + acq_mode +" is invalid and must be of the following: Continuous, SingleFrame, MultiFrame");
-    return;
+    log_error("the acquisition mode supplied: " + acq_mode +" is invalid and must be of the following: Continuous, SingleFrame, MultiFrame", reply);
+    return false;
   }
   
   GErrorWrapper error;
@@ -664,10 +1941,11 @@ void AravisDetectorPlugin::set_acquisition_mode(std::string acq_mode, OdinData::
   arv_camera_set_acquisition_mode(camera_, temp, error.get());
   if(error){
     log_error("When setting acquisition mode the following error ocurred: \n" + error.message(), reply);
-    return;
+    return false;
   }
   LOG4CXX_INFO(logger_, "Previous acquisition mode:"<< acquisition_mode_ << " new:" << acq_mode );
   acquisition_mode_= acq_mode;
+  return true;
 }
 
 /** @brief Get current acquisition mode
@@ -693,27 +1971,30 @@ void AravisDetectorPlugin::get_acquisition_mode(){
  * 
  * @param exposure_time_us
  */
-void AravisDetectorPlugin::set_exposure(double exposure_time_us, OdinData::IpcMessage& reply){
+bool AravisDetectorPlugin::set_exposure(double exposure_time_us, OdinData::IpcMessage& reply){
   GErrorWrapper error;
 
-  // aravis already checks this but we warn the user
-  if(exposure_time_us < min_exposure_time_){
-    log_error("The exposure time: "+ std::to_string(exposure_time_us) + " is out of bounds: min="+std::to_string(min_exposure_time_)+" and is set to minimum", reply);
-    exposure_time_us = min_exposure_time_;
-  } else if(exposure_time_us > max_exposure_time_){
-    log_error("The exposure time: "+ std::to_string(exposure_time_us) + " is out of bounds: max="+std::to_string(max_exposure_time_) +" and is set to maximum", reply);
-    exposure_time_us = max_exposure_time_;
+  // a value out of bounds is rejected rather than clamped, so a restored value is never changed
+  if(exposure_time_us < min_exposure_time_ || exposure_time_us > max_exposure_time_){
+    log_error("The exposure time: "+ std::to_string(exposure_time_us) + " is out of bounds: min="+std::to_string(min_exposure_time_)
+              + " max=" + std::to_string(max_exposure_time_) + " and was not set", reply);
+    return false;
   }
   
   arv_camera_set_exposure_time(camera_, exposure_time_us, error.get());
 
   if(error){ 
     log_error("When setting exposure time the following error ocurred: \n" + error.message(), reply);
-    return;
+    return false;
   }   
 
   LOG4CXX_INFO(logger_, "exposure_time_us_ | old: "<< exposure_time_us_ << " | new:" << exposure_time_us);
-  exposure_time_us_ = exposure_time_us;
+  // read back what the camera applied, a longer exposure can also lower the frame rate
+  get_exposure();
+  get_frame_rate_bounds();
+  get_frame_rate();
+  publish_camera_stats();
+  return true;
 }
 
 /** @brief Get exposure time bounds in microseconds
@@ -764,27 +2045,30 @@ void AravisDetectorPlugin::get_exposure(){
  * 
  * @param frame_rate_hz number of frames per second
  */
-void AravisDetectorPlugin::set_frame_rate(double frame_rate_hz, OdinData::IpcMessage& reply){
+bool AravisDetectorPlugin::set_frame_rate(double frame_rate_hz, OdinData::IpcMessage& reply){
   GErrorWrapper error;
 
-  // aravis already checks this but we change it for log reasons
-  if(frame_rate_hz < min_frame_rate_){
-    log_error("The frame rate: "+ std::to_string(frame_rate_hz) + " is out of bounds: min="+ std::to_string( min_frame_rate_)+" and is set to minimum", reply);
-    frame_rate_hz= min_frame_rate_;
-  } else if(frame_rate_hz > max_frame_rate_){
-    log_error("The frame rate: "+ std::to_string( frame_rate_hz) + " is out of bounds: max="+ std::to_string(max_frame_rate_) + " and is set to maximum", reply);
-    frame_rate_hz = max_frame_rate_;
+  // a value out of bounds is rejected rather than clamped, so a restored value is never changed
+  if(frame_rate_hz < min_frame_rate_ || frame_rate_hz > max_frame_rate_){
+    log_error("The frame rate: "+ std::to_string(frame_rate_hz) + " is out of bounds: min="+ std::to_string(min_frame_rate_)
+              + " max=" + std::to_string(max_frame_rate_) + " and was not set", reply);
+    return false;
   }
 
   arv_camera_set_frame_rate(camera_, frame_rate_hz, error.get());
 
   if(error){ 
     log_error("When setting frame rate the following error ocurred: \n" + error.message(), reply);
-    return;
+    return false;
   }
 
   LOG4CXX_INFO(logger_, "frame_rate_hz_ | old: "<< frame_rate_hz_ << " | new:" << frame_rate_hz);
-  frame_rate_hz_ = frame_rate_hz;
+  // read back what the camera applied, the frame period also bounds the exposure
+  get_frame_rate();
+  get_exposure_bounds();
+  get_exposure();
+  publish_camera_stats();
+  return true;
 }
 
 /** @brief Read frame rate bounds from the camera
@@ -830,18 +2114,68 @@ void AravisDetectorPlugin::get_frame_rate(){
  * 
  * @param pixel_format string representation of the format (eg, Mono8, Mono12, RGB8)
  */
-void AravisDetectorPlugin::set_pixel_format(std::string pixel_format, OdinData::IpcMessage& reply){
+bool AravisDetectorPlugin::set_pixel_format(std::string pixel_format, OdinData::IpcMessage& reply){
   GErrorWrapper error;
 
-  arv_camera_set_pixel_format_from_string(camera_, pixel_format.c_str(), error.get());
+  // without a camera the format only describes the virtual source
+  if(virtual_source_.empty() || ARV_IS_CAMERA(camera_))
+    arv_camera_set_pixel_format_from_string(camera_, pixel_format.c_str(), error.get());
 
   if(error){
     log_error("When setting pixel format the following error ocurred: \n" + error.message(), reply);
-    return;
+    return false;
   }
   
   LOG4CXX_INFO(logger_, "pixel_format_ | old: "<< pixel_format_ << " | new:" << pixel_format);
   pixel_format_ = pixel_format;
+  // the payload follows the pixel size
+  if(ARV_IS_CAMERA(camera_))
+    get_frame_size();
+  return true;
+}
+
+/** @brief Sets the width of the camera image
+ * 
+ * Changes the payload, so it should be set while the camera is not streaming.
+ * 
+ * @param width width in pixels, within the camera's width bounds
+ */
+bool AravisDetectorPlugin::set_image_width(int width, OdinData::IpcMessage& reply){
+  GErrorWrapper error;
+
+  arv_camera_set_integer(camera_, "Width", width, error.get());
+
+  if(error){
+    log_error("When setting image width the following error ocurred: \n" + error.message(), reply);
+    return false;
+  }
+
+  LOG4CXX_INFO(logger_, "camera_width_px_ | old: "<< camera_width_px_ << " | new:" << width);
+  get_image_size();
+  get_frame_size();
+  return true;
+}
+
+/** @brief Sets the height of the camera image
+ * 
+ * Changes the payload, so it should be set while the camera is not streaming.
+ * 
+ * @param height height in pixels, within the camera's height bounds
+ */
+bool AravisDetectorPlugin::set_image_height(int height, OdinData::IpcMessage& reply){
+  GErrorWrapper error;
+
+  arv_camera_set_integer(camera_, "Height", height, error.get());
+
+  if(error){
+    log_error("When setting image height the following error ocurred: \n" + error.message(), reply);
+    return false;
+  }
+
+  LOG4CXX_INFO(logger_, "camera_height_px_ | old: "<< camera_height_px_ << " | new:" << height);
+  get_image_size();
+  get_frame_size();
+  return true;
 }
 
 /** @brief Get a list of available pixel formats
@@ -863,17 +2197,25 @@ void AravisDetectorPlugin::get_available_pixel_formats(){
     return;
   }
 
-  n_pixel_formats_ =  temp;
+  set_pixel_format_list(std::vector<std::string>(formats_temp, formats_temp + temp));
+  free(formats_temp); // only need to free the container
+}
+
+/** @brief Saves a list of pixel formats to pixel_formats_ and available_pixel_formats_
+ * 
+ * @param formats pixel formats the camera offers
+ */
+void AravisDetectorPlugin::set_pixel_format_list(const std::vector<std::string>& formats){
+  n_pixel_formats_ = formats.size();
+  pixel_formats_ = formats;
   available_pixel_formats_ = "\n"; // clean from old strings and start new line
   if(n_pixel_formats_ > 1){
     for(int i=0; i< n_pixel_formats_; i++){
-      available_pixel_formats_ += "#" + std::to_string(i+1) + " " + formats_temp[i] + "\n";
+      available_pixel_formats_ += "#" + std::to_string(i+1) + " " + formats[i] + "\n";
     }
-  }else{
-    available_pixel_formats_.append(formats_temp[0]);
+  }else if(n_pixel_formats_ == 1){
+    available_pixel_formats_.append(formats[0]);
   }
-      
-  free(formats_temp); // only need to free the container
 }
 
 /** @brief Get currently used pixel format from the camera
@@ -893,6 +2235,38 @@ void AravisDetectorPlugin::get_pixel_format(){
 }
 
 
+/** @brief Get the image width and height set on the camera, and their maximums
+ *
+ * Saved to camera_width_px_, camera_height_px_, max_width_px_ and max_height_px_
+ */
+void AravisDetectorPlugin::get_image_size(){
+  GErrorWrapper error;
+  int width = arv_camera_get_integer(camera_, "Width", error.get());
+  int height = error ? 0 : arv_camera_get_integer(camera_, "Height", error.get());
+
+  if(error){
+    log_error("When reading the image size the following error occurred: \n" + error.message());
+    return;
+  }
+
+  camera_width_px_ = width;
+  camera_height_px_ = height;
+
+  // the maximums depend on binning and offsets, so they are read along with the size
+  int max_width = arv_camera_get_integer(camera_, "WidthMax", error.get());
+  int max_height = error ? 0 : arv_camera_get_integer(camera_, "HeightMax", error.get());
+  if(error){
+    log_warning("When reading the largest image size the following error occurred: \n" + error.message());
+    return;
+  }
+  max_width_px_ = max_width;
+  max_height_px_ = max_height;
+}
+
+/** @brief Get the payload (frame size in bytes) from the camera
+ *
+ * Saved to payload_
+ */
 void AravisDetectorPlugin::get_frame_size(){
   GErrorWrapper error;
   int temp = arv_camera_get_payload(camera_, error.get());
@@ -903,6 +2277,472 @@ void AravisDetectorPlugin::get_frame_size(){
   }
 
   payload_ = temp;
+  publish_camera_stats();
+}
+
+/** @brief Applies every camera feature in a configuration as one batch
+ * 
+ * The whole batch is validated before anything is written, so an invalid value
+ * leaves the camera untouched. Values equal to the cached ones are not written.
+ * Features are written in dependency order: pixel format and image size (which
+ * define the payload), then acquisition mode, then exposure and frame rate. The
+ * frame rate goes first when the new exposure does not fit in the current frame
+ * period. The bounds checked are the cached exposure, frame rate and image size
+ * limits; an exposure given with a frame rate only has to fit in its period. If the
+ * camera still refuses a write, the batch stops there and a stream stopped for it is
+ * not restarted.
+ * 
+ * A running stream is only stopped, and restarted once the batch is applied, when
+ * the pixel format or image size change. The buffer arena is reused on restart
+ * when the payload ends up the same.
+ * 
+ * @param config IpcMessage holding any of the camera features
+ * @param reply ipc message log
+ * @param force write every value given, even those equal to the cached ones
+ */
+void AravisDetectorPlugin::apply_camera_config(OdinData::IpcMessage& config, OdinData::IpcMessage& reply, bool force){
+  bool has_format = config.has_param(CONFIG_PIXEL_FORMAT);
+  bool has_width = config.has_param(CONFIG_IMAGE_WIDTH);
+  bool has_height = config.has_param(CONFIG_IMAGE_HEIGHT);
+  bool has_mode = config.has_param(CONFIG_ACQUISITION_MODE);
+  bool has_exposure = config.has_param(CONFIG_EXPOSURE);
+  bool has_rate = config.has_param(CONFIG_FRAME_RATE);
+
+  if(!(has_format || has_width || has_height || has_mode || has_exposure || has_rate))
+    return;
+
+  std::string pixel_format = has_format ? config.get_param<std::string>(CONFIG_PIXEL_FORMAT) : pixel_format_;
+  int width = has_width ? config.get_param<int>(CONFIG_IMAGE_WIDTH) : camera_width_px_;
+  int height = has_height ? config.get_param<int>(CONFIG_IMAGE_HEIGHT) : camera_height_px_;
+  std::string acq_mode = has_mode ? config.get_param<std::string>(CONFIG_ACQUISITION_MODE) : acquisition_mode_;
+  double exposure_time_us = has_exposure ? config.get_param<double>(CONFIG_EXPOSURE) : exposure_time_us_;
+  double frame_rate_hz = has_rate ? config.get_param<double>(CONFIG_FRAME_RATE) : frame_rate_hz_;
+
+  // without a camera only the pixel format of a virtual source can be set
+  if(!ARV_IS_CAMERA(camera_)){
+    if(has_width || has_height || has_mode || has_exposure || has_rate){
+      log_error("Cannot configure the camera without connecting to one first", reply);
+      return;
+    }
+    set_pixel_format(pixel_format, reply);
+    return;
+  }
+
+  // validate the whole batch against the cached model before writing anything
+  std::string invalid;
+  if(!check_camera_values(config, invalid)){
+    // invalid on any camera, already described
+  }else if(has_format && !pixel_formats_.empty() &&
+           std::find(pixel_formats_.begin(), pixel_formats_.end(), pixel_format) == pixel_formats_.end()){
+    invalid = "the pixel format " + pixel_format + " is not available on this camera";
+  }else if(has_width && max_width_px_ > 0 && width > max_width_px_){
+    invalid = "the image width " + std::to_string(width) + " is above the maximum of " + std::to_string(max_width_px_);
+  }else if(has_height && max_height_px_ > 0 && height > max_height_px_){
+    invalid = "the image height " + std::to_string(height) + " is above the maximum of " + std::to_string(max_height_px_);
+  }else if(has_exposure && exposure_time_us < min_exposure_time_){
+    invalid = "the exposure time " + std::to_string(exposure_time_us) + " is below the minimum of " + std::to_string(min_exposure_time_);
+  }else if(has_exposure && !has_rate && max_exposure_time_ > 0 && exposure_time_us > max_exposure_time_){
+    invalid = "the exposure time " + std::to_string(exposure_time_us) + " is above the maximum of " + std::to_string(max_exposure_time_);
+  }else if(has_exposure && has_rate && exposure_time_us > 1e6 / frame_rate_hz){
+    invalid = "the exposure time " + std::to_string(exposure_time_us) + " does not fit in the frame period at " + std::to_string(frame_rate_hz) + " Hz";
+  }else if(has_rate && frame_rate_hz < min_frame_rate_){
+    invalid = "the frame rate " + std::to_string(frame_rate_hz) + " is below the minimum of " + std::to_string(min_frame_rate_);
+  }else if(has_rate && max_frame_rate_ > 0 && frame_rate_hz > max_frame_rate_ && !(has_exposure && exposure_time_us < exposure_time_us_)){
+    // a shorter exposure in the same batch raises the maximum, which only the camera knows
+    invalid = "the frame rate " + std::to_string(frame_rate_hz) + " is above the maximum of " + std::to_string(max_frame_rate_);
+  }
+
+  if(!invalid.empty()){
+    log_error("Camera configuration rejected, " + invalid + ". Nothing was applied", reply);
+    return;
+  }
+
+  bool format_changed = has_format && (force || pixel_format != pixel_format_);
+  bool width_changed = has_width && (force || width != camera_width_px_);
+  bool height_changed = has_height && (force || height != camera_height_px_);
+
+  // the camera locks the features defining the payload while acquiring
+  bool restart = (format_changed || width_changed || height_changed) && (streaming_ || virtual_streaming_);
+  if(restart){
+    LOG4CXX_INFO(logger_, "Payload changes, restarting the stream to apply the configuration");
+    stop_stream(reply);
+  }
+
+  // each write stops the batch at the first one the camera refuses
+  bool applied = (!format_changed || set_pixel_format(pixel_format, reply)) &&
+                 (!width_changed || set_image_width(width, reply)) &&
+                 (!height_changed || set_image_height(height, reply)) &&
+                 (!has_mode || !(force || acq_mode != acquisition_mode_) || set_acquisition_mode(acq_mode, reply));
+
+  // a longer exposure than the frame period allows needs the new frame rate first
+  bool rate_first = has_rate && exposure_time_us > max_exposure_time_;
+  applied = applied &&
+            (!rate_first || !(force || frame_rate_hz != frame_rate_hz_) || set_frame_rate(frame_rate_hz, reply)) &&
+            (!has_exposure || !(force || exposure_time_us != exposure_time_us_) || set_exposure(exposure_time_us, reply)) &&
+            (!has_rate || rate_first || !(force || frame_rate_hz != frame_rate_hz_) || set_frame_rate(frame_rate_hz, reply));
+
+  if(!applied){
+    // the cached model holds what the camera was left with
+    log_error("Camera configuration stopped at the first feature the camera refused, the features before it were applied"
+              + std::string(restart ? " and the stream was left stopped" : ""), reply);
+  }else if(restart){
+    n_config_restarts_++;
+    start_stream(reply);
+  }
+  save_camera_state();
+}
+
+/** @brief Checks the camera features in a configuration without the camera
+ * 
+ * Only catches values that are invalid on any camera, so it can run before a
+ * command is queued.
+ * 
+ * @param config IpcMessage holding any of the camera features
+ * @param[out] invalid description of the first invalid value
+ * @return false if a value is invalid
+ */
+bool AravisDetectorPlugin::check_camera_values(OdinData::IpcMessage& config, std::string& invalid){
+  if(config.has_param(CONFIG_IMAGE_WIDTH) && config.get_param<int>(CONFIG_IMAGE_WIDTH) <= 0)
+    invalid = "the image width must be positive";
+  else if(config.has_param(CONFIG_IMAGE_HEIGHT) && config.get_param<int>(CONFIG_IMAGE_HEIGHT) <= 0)
+    invalid = "the image height must be positive";
+  else if(config.has_param(CONFIG_EXPOSURE) && config.get_param<double>(CONFIG_EXPOSURE) <= 0)
+    invalid = "the exposure time must be positive";
+  else if(config.has_param(CONFIG_FRAME_RATE) && config.get_param<double>(CONFIG_FRAME_RATE) <= 0)
+    invalid = "the frame rate must be positive";
+  else if(config.has_param(CONFIG_ACQUISITION_MODE)){
+    std::string acq_mode = config.get_param<std::string>(CONFIG_ACQUISITION_MODE);
+    if(!(acq_mode == "Continuous" || acq_mode == "SingleFrame" || acq_mode == "MultiFrame"))
+      invalid = "the acquisition mode " + acq_mode + " must be one of: Continuous, SingleFrame, MultiFrame";
+  }
+  return invalid.empty();
+}
+
+/** @brief Reads or writes any GenICam feature by name
+ * 
+ * Each entry of the features object is a feature name and the value to write, or
+ * null to read the feature. Features are resolved into the feature table on first
+ * use, so repeated access skips the lookup in the GenICam tree. Writing a feature
+ * the plugin also models (exposure, frame rate, pixel format, image size,
+ * acquisition mode, binning or decimation) refreshes the cached camera parameters.
+ * 
+ * @param config IpcMessage holding the features object
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_features(OdinData::IpcMessage& config, OdinData::IpcMessage& reply){
+  OdinData::IpcMessage feature_config(config.get_param<const rapidjson::Value&>(CONFIG_FEATURES));
+  bool model_changed = false;
+
+  for(const std::string& name : feature_config.get_param_names()){
+    const rapidjson::Value& value = feature_config.get_param<const rapidjson::Value&>(name);
+    std::string error;
+
+    int index = feature_table_.resolve(name, error);
+    if(index < 0){
+      log_error(error, reply);
+      continue;
+    }
+    if(value.IsNull()){
+      if(!feature_table_.read(index, error))
+        log_error(error, reply);
+      continue;
+    }
+
+    FeatureTable::Input input;
+    input.integer = 0;
+    input.number = 0;
+    input.boolean = false;
+    if(value.IsBool()){
+      input.kind = FeatureTable::Input::INPUT_BOOLEAN;
+      input.boolean = value.GetBool();
+    }else if(value.IsInt64()){
+      input.kind = FeatureTable::Input::INPUT_INTEGER;
+      input.integer = value.GetInt64();
+    }else if(value.IsNumber()){
+      input.kind = FeatureTable::Input::INPUT_NUMBER;
+      input.number = value.GetDouble();
+    }else if(value.IsString()){
+      input.kind = FeatureTable::Input::INPUT_TEXT;
+      input.text = value.GetString();
+    }else{
+      log_error("The value for feature " + name + " must be a number, boolean, string or null", reply);
+      continue;
+    }
+
+    if(write_feature(index, name, input, reply))
+      model_changed = model_changed || is_modelled_feature(name);
+  }
+
+  if(model_changed)
+    refresh_camera_model();
+  save_camera_state();
+}
+
+/** @brief Writes a resolved feature and remembers the value for the camera cache
+ * 
+ * @param index position of the feature in the feature table
+ * @param name feature name
+ * @param input value to write
+ * @param reply ipc message log
+ * @return true if the value was written
+ */
+bool AravisDetectorPlugin::write_feature(int index, const std::string& name, const FeatureTable::Input& input, OdinData::IpcMessage& reply){
+  std::string error;
+  if(!feature_table_.write(index, input, error)){
+    log_error(error, reply);
+    return false;
+  }
+  LOG4CXX_INFO(logger_, "feature " << name << " written");
+
+  // commands are actions, not state to restore
+  FeatureTable::Type type;
+  if(feature_table_.type(index, type) && type != FeatureTable::FEATURE_COMMAND)
+    applied_features_[name] = input;
+  return true;
+}
+
+/** @brief Is the feature one of those the plugin keeps in its own camera model? */
+bool AravisDetectorPlugin::is_modelled_feature(const std::string& name){
+  return name == "PixelFormat" || name == "Width" || name == "Height" ||
+    name == "AcquisitionMode" || boost::starts_with(name, "Exposure") ||
+    boost::starts_with(name, "AcquisitionFrameRate") || boost::starts_with(name, "Binning") ||
+    boost::starts_with(name, "Decimation");
+}
+
+/** @brief Re-reads every camera parameter the plugin keeps in its own model */
+void AravisDetectorPlugin::refresh_camera_model(){
+  get_exposure_bounds();
+  get_exposure();
+  get_frame_rate_bounds();
+  get_frame_rate();
+  get_pixel_format();
+  get_acquisition_mode();
+  get_image_size();
+  get_frame_size();
+}
+
+/** @brief Re-reads every feature in the feature table from the camera */
+void AravisDetectorPlugin::read_features(){
+  for(size_t i = 0; i < feature_table_.size(); i++){
+    std::string error;
+    if(!feature_table_.read(static_cast<int>(i), error))
+      log_error(error);
+  }
+}
+
+/** @brief Adds the cached value of every feature in the feature table to a message
+ * 
+ * Only the table is read, never the camera.
+ * 
+ * @param msg message to add the features to, under features/<name>
+ * @param with_bounds add the value under features/<name>/value, with min and max for numeric features
+ */
+void AravisDetectorPlugin::report_features(OdinData::IpcMessage& msg, bool with_bounds){
+  std::vector<FeatureTable::Value> values;
+  feature_table_.snapshot(values);
+
+  for(const FeatureTable::Value& value : values){
+    if(!value.known) continue;
+    std::string key = get_name() + "/" + CONFIG_FEATURES + "/" + value.name;
+    std::string value_key = with_bounds ? key + "/value" : key;
+    switch(value.type){
+      case FeatureTable::FEATURE_INTEGER:     msg.set_param(value_key, value.integer); break;
+      case FeatureTable::FEATURE_FLOAT:       msg.set_param(value_key, value.number);  break;
+      case FeatureTable::FEATURE_BOOLEAN:     msg.set_param(value_key, value.boolean); break;
+      case FeatureTable::FEATURE_ENUMERATION:
+      case FeatureTable::FEATURE_STRING:      msg.set_param(value_key, value.text);    break;
+      case FeatureTable::FEATURE_COMMAND:     break;
+    }
+    if(with_bounds && (value.type == FeatureTable::FEATURE_INTEGER || value.type == FeatureTable::FEATURE_FLOAT)){
+      msg.set_param(key + "/min", value.min);
+      msg.set_param(key + "/max", value.max);
+    }
+  }
+}
+
+
+/*********************************
+**        Command thread        **
+**********************************/
+
+/** @brief Does the configuration talk to the camera or change the buffers of its stream? */
+bool AravisDetectorPlugin::is_camera_command(OdinData::IpcMessage& config){
+  return config.has_param(START_STREAM) || config.has_param(STOP_STREAM) ||
+         config.has_param(LIST_DEVICES) || config.has_param(ACQUIRE_BUFFER) ||
+         config.has_param(CONFIG_CAMERA_IP) || config.has_param(CONFIG_PIXEL_FORMAT) ||
+         config.has_param(CONFIG_IMAGE_WIDTH) || config.has_param(CONFIG_IMAGE_HEIGHT) ||
+         config.has_param(CONFIG_ACQUISITION_MODE) || config.has_param(CONFIG_EXPOSURE) ||
+         config.has_param(CONFIG_FRAME_RATE) || config.has_param(CONFIG_FEATURES) ||
+         config.has_param(CONFIG_EMPTY_BUFF) || config.has_param(CONFIG_BUFFER_ARENA) ||
+         config.has_param(CONFIG_HUGEPAGES) || config.has_param(CONFIG_LOCK_BUFFERS);
+}
+
+/** @brief Is a configuration queued or running? */
+bool AravisDetectorPlugin::commands_pending(){
+  boost::mutex::scoped_lock lock(command_mutex_);
+  return n_queued_configs() != 0 || running_command_ != 0;
+}
+
+/** @brief Number of configurations queued, polls aside. Called with command_mutex_ held */
+size_t AravisDetectorPlugin::n_queued_configs(){
+  return std::count_if(commands_.begin(), commands_.end(),
+    [](const CameraCommand& command){ return command.kind == COMMAND_CONFIG; });
+}
+
+/** @brief Queues a configuration for the command thread
+ * 
+ * @param config configuration to apply
+ * @param reply gets the command id, to match against command_last_completed in the status
+ */
+void AravisDetectorPlugin::queue_command(OdinData::IpcMessage& config, OdinData::IpcMessage& reply){
+  CameraCommand command;
+  command.kind = COMMAND_CONFIG;
+  command.config = config.encode();
+  command.reply = NULL;
+  command.done = NULL;
+  {
+    boost::mutex::scoped_lock lock(command_mutex_);
+    command.id = ++last_queued_command_;
+    commands_.push_back(command);
+  }
+  command_cond_.notify_one();
+  reply.set_param(get_name() + "/" + "command_id", command.id);
+  LOG4CXX_DEBUG(logger_, "Queued command " << command.id);
+}
+
+/** @brief Runs a configuration or a configuration request on the command thread and waits for it
+ * 
+ * Used for every configuration not queued with async_commands, so the reply is that
+ * of the command itself. Only configurations get a command id.
+ * 
+ * @param kind COMMAND_CONFIG or COMMAND_REQUEST_CONFIG
+ * @param config configuration to apply, NULL for a request
+ * @param reply filled in by the command thread
+ */
+void AravisDetectorPlugin::run_command(CommandKind kind, OdinData::IpcMessage *config, OdinData::IpcMessage& reply){
+  bool done = false;
+  CameraCommand command;
+  command.kind = kind;
+  command.id = 0;
+  if(config != NULL)
+    command.config = config->encode();
+  command.reply = &reply;
+  command.done = &done;
+
+  boost::mutex::scoped_lock lock(command_mutex_);
+  if(kind == COMMAND_CONFIG)
+    command.id = ++last_queued_command_;
+  commands_.push_back(command);
+  command_cond_.notify_one();
+  while(commands_running_ && !done)
+    command_done_cond_.wait(lock);
+}
+
+/** @brief Queues a status poll or a stop at frame_count_ for the command thread */
+void AravisDetectorPlugin::queue_task(CommandKind kind){
+  CameraCommand command;
+  command.kind = kind;
+  command.id = 0;
+  command.reply = NULL;
+  command.done = NULL;
+  {
+    boost::mutex::scoped_lock lock(command_mutex_);
+    commands_.push_back(command);
+  }
+  command_cond_.notify_one();
+}
+
+/** @brief Checks the connected camera and reads the stream statistics
+ * 
+ * Runs on the command thread every status_freq_ms_. A lost camera is looked for
+ * here too while recovering.
+ */
+void AravisDetectorPlugin::poll_camera(){
+  poll_queued_ = false;
+  consume_camera_reset();
+  // with no thread making frames their counters are this thread's to reset
+  if(dispatch_thread_ == NULL && virtual_thread_ == NULL)
+    consume_frame_reset();
+
+  if (camera_connected_){
+    get_config(GET_CONFIG_CAMERA_PARAMS);
+    if(streaming_)
+      get_config(GET_CONFIG_STREAM_STAT);
+  }
+  else if (recovering_ && recovery_due()){
+    recover_camera();
+    publish_camera_stats();
+  }
+}
+
+/** @brief Command thread, applies queued configurations and status polls one at a time
+ * 
+ * Every call into the camera or its stream is made here, so the cached camera 
+ * model needs no lock; the other threads read the copies published after each
+ * command. A command that nacks its reply or throws is recorded as the last failed
+ * command with its error, both reported by status().
+ */
+void AravisDetectorPlugin::command_task(){
+  // Configure logging for this thread
+  OdinData::configure_logging_mdc(OdinData::app_path.c_str());
+
+  boost::mutex::scoped_lock lock(command_mutex_);
+  while(commands_running_){
+    if(commands_.empty()){
+      command_cond_.wait(lock);
+      continue;
+    }
+    CameraCommand command = commands_.front();
+    commands_.pop_front();
+    // requests, polls and stops have no id and report through the reply or the status counters
+    if(command.kind != COMMAND_CONFIG){
+      lock.unlock();
+      if(command.kind == COMMAND_REQUEST_CONFIG)
+        report_configuration(*command.reply);
+      else if(command.kind == COMMAND_POLL)
+        poll_camera();
+      // a stream restarted since the stop was queued is left running
+      else if(auto_stop_requested_ && streaming_)
+        auto_stop_stream();
+      publish_camera_settings();
+      publish_camera_stats();
+      lock.lock();
+      if(command.done != NULL){
+        *command.done = true;
+        command_done_cond_.notify_all();
+      }
+      continue;
+    }
+    running_command_ = command.id;
+    lock.unlock();
+
+    std::string error;
+    OdinData::IpcMessage queued_reply;
+    OdinData::IpcMessage& reply = command.reply != NULL ? *command.reply : queued_reply;
+    try{
+      OdinData::IpcMessage config(command.config.c_str(), false);
+      apply_configuration(config, reply);
+      if(reply.get_msg_type() == OdinData::IpcMessage::MsgTypeNack)
+        error = reply.get_param<std::string>("error", "command failed");
+    }
+    catch(std::exception& e){
+      error = e.what();
+    }
+    publish_camera_settings();
+    publish_camera_stats();
+
+    lock.lock();
+    running_command_ = 0;
+    last_completed_command_ = command.id;
+    if(command.done != NULL)
+      *command.done = true;
+    command_done_cond_.notify_all();
+    if(!error.empty()){
+      last_failed_command_ = command.id;
+      last_command_error_ = error;
+      LOG4CXX_WARN(logger_, "Command " << command.id << " failed: " << error);
+    }
+  }
 }
 
 
@@ -920,14 +2760,23 @@ void AravisDetectorPlugin::get_frame_size(){
  * - Adds buffers
  * - starts camera acquisition and the buffer reading function
  */
-void AravisDetectorPlugin::start_stream(OdinData::IpcMessage& reply){
+void AravisDetectorPlugin::start_stream(OdinData::IpcMessage& reply, bool resume){
   GErrorWrapper error;
+
+  // a virtual source replaces the camera entirely
+  if(!virtual_source_.empty()){
+    start_virtual_stream(reply);
+    return;}
   
   // check you are connected to a camera
   if (!ARV_IS_CAMERA(camera_)){
     log_error("Cannot start stream without connecting to a camera first.", reply);
     return;}
 
+  // the previous dispatch thread is stopped before the frame state is set up again,
+  // so only one thread at a time ever touches it
+  stop_dispatch_thread();
+
   // delete old stream
   if(stream_ != NULL){
     LOG4CXX_INFO(logger_, "Removing old stream");
@@ -949,18 +2798,57 @@ void AravisDetectorPlugin::start_stream(OdinData::IpcMessage& reply){
     log_error("Stream was not initialized, error undetected", reply);
     return;}
 
+  if(zero_copy_ && n_empty_buffers_ <= n_zero_copy_reserve_)
+    log_warning("Zero copy needs more than " + std::to_string(n_zero_copy_reserve_) + " empty buffers, every frame will be copied");
+
   // and populate it with a few empty buffers (frames)
-  for(int i =0; i<n_empty_buffers_; i++){
-    arv_stream_push_buffer(stream_, arv_buffer_new(payload_, NULL));
+  if(use_buffer_arena_){
+    if(!prepare_buffer_arena(reply)){
+      g_object_unref(stream_);
+      stream_ = NULL;
+      return;}
+    // the arena keeps its own reference so the buffers outlive the stream
+    for(ArvBuffer *buffer : buffer_arena_.buffers()){
+      arv_stream_push_buffer(stream_, static_cast<ArvBuffer*>(g_object_ref(buffer)));
+    }
+  }else{
+    for(int i =0; i<n_empty_buffers_; i++){
+      arv_stream_push_buffer(stream_, arv_buffer_new(payload_, NULL));
+    }
   }
 
-  // stream callback mechanism
-  arv_stream_set_emit_signals (stream_, TRUE);
-  g_signal_connect (stream_, "new-buffer", G_CALLBACK (buffer_callback), this);
+  if(!start_compression(reply)){
+    g_object_unref(stream_);
+    stream_ = NULL;
+    return;}
+
+  // resolve everything that depends on the pixel format once, not per frame
+  select_frame_builder(pixel_format_);
+
+  // buffers added by the adaptive pool went with the old stream
+  n_extra_buffers_ = 0;
+  n_buffers_to_shrink_ = 0;
+  last_underrun_count_ = 0;
+  last_pool_pressure_ = boost::posix_time::microsec_clock::universal_time();
 
-  // Start the stream
+  // a recovered stream carries on numbering frames
+  if(!resume){
+    n_frames_made_ = 0;
+    n_batches_made_ = 0;
+  }
+  // the camera numbers the frames of each acquisition from the start
+  last_frame_id_ = 0;
+  clock_mapper_.set_window(clock_window_);
+  last_frame_bytes_ = 0;
+  auto_stop_requested_ = false;
+  resumed_stream_ = resume;
+  publish_frame_stats();
+
+  // Start the stream, buffers are handed to the dispatch thread
   streaming_= true;
-  n_frames_made_ = 0;
+  start_dispatch_thread();
+  arv_stream_set_emit_signals (stream_, TRUE);
+  g_signal_connect (stream_, "new-buffer", G_CALLBACK (buffer_callback), this);
   arv_camera_start_acquisition (camera_, error.get());
 
   if(error)
@@ -968,6 +2856,37 @@ void AravisDetectorPlugin::start_stream(OdinData::IpcMessage& reply){
 
 }
 
+/** @brief Makes sure the buffer arena matches the current payload and buffer count
+ * 
+ * The buffers from the previous stream are reused when nothing about them has changed
+ * and no downstream frame still holds one. Otherwise a new region is mapped; the old
+ * one is unmapped once its last buffer is released.
+ * 
+ * @param reply Ipc Message from config
+ * @return false if the arena could not be allocated
+ */
+bool AravisDetectorPlugin::prepare_buffer_arena(OdinData::IpcMessage& reply){
+  if(n_buffers_in_flight_ == 0 &&
+     buffer_arena_.matches(payload_, n_empty_buffers_, use_hugepages_, lock_buffers_)){
+    n_arena_reuses_++;
+    LOG4CXX_INFO(logger_, "Reusing " << n_empty_buffers_ << " buffers from the buffer arena");
+    return true;
+  }
+
+  std::string error;
+  if(!buffer_arena_.allocate(payload_, n_empty_buffers_, use_hugepages_, lock_buffers_, error)){
+    log_error(error, reply);
+    return false;
+  }
+  if(use_hugepages_ && !buffer_arena_.on_hugepages())
+    log_warning("No hugepages available for the buffer arena, using normal pages");
+  if(lock_buffers_ && !buffer_arena_.locked())
+    log_warning("Failed to lock the buffer arena into memory, check the memlock limit");
+
+  LOG4CXX_INFO(logger_, "Mapped " << buffer_arena_.mapped_bytes() << " bytes for " << n_empty_buffers_ << " buffers of " << payload_ << " bytes");
+  return true;
+}
+
 /** @brief Stop acquisition and destruct stream
  * 
  * use when Ipc Messages are required (config)
@@ -978,13 +2897,22 @@ void AravisDetectorPlugin::start_stream(OdinData::IpcMessage& reply){
 void AravisDetectorPlugin::stop_stream(OdinData::IpcMessage& reply){
   GErrorWrapper error;
 
+  // a camera recovered after this should stay stopped
+  recovery_resume_stream_ = false;
+
+  if(virtual_thread_ != NULL){
+    stop_virtual_stream();
+    LOG4CXX_INFO(logger_,"Stopping virtual camera stream");
+    return;
+  }
+
   if(camera_ == NULL || stream_ == NULL){
     log_error("There is no stream to stop. Exiting process", reply);
     return;
   }
 
   arv_stream_set_emit_signals (stream_, FALSE);
-
+  stop_dispatch_thread();
 
   arv_camera_stop_acquisition (camera_, error.get());
   streaming_ = false;
@@ -999,7 +2927,8 @@ void AravisDetectorPlugin::stop_stream(OdinData::IpcMessage& reply){
 
 /** @brief Stops stream without ipc message
  * 
- * Identical to stop_stream but without a reply.
+ * Identical to stop_stream but without a reply. Runs on the command thread, for a
+ * lost camera or once the stream has made frame_count_ frames.
 */
 void AravisDetectorPlugin::auto_stop_stream(){
   GErrorWrapper error;
@@ -1010,6 +2939,7 @@ void AravisDetectorPlugin::auto_stop_stream(){
   }
 
   arv_stream_set_emit_signals (stream_, FALSE);
+  stop_dispatch_thread();
 
   arv_camera_stop_acquisition (camera_, error.get());
   streaming_ = false;
@@ -1023,6 +2953,186 @@ void AravisDetectorPlugin::auto_stop_stream(){
 }
 
 
+/*********************************
+**        Virtual camera        **
+**********************************/
+
+/** @brief Sets the raw file streamed instead of a camera
+ * 
+ * While set, start and stop drive the virtual source and no camera is needed. The 
+ * file holds back to back frames of virtual_width x virtual_height pixels in the 
+ * configured pixel_format, with no header. Applied on the next stream start.
+ * 
+ * @param path raw file to replay, empty to go back to the camera
+ */
+void AravisDetectorPlugin::set_virtual_source(std::string path, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "virtual_source_ | old: "<< virtual_source_ << " | new:" << path);
+  virtual_source_ = path;
+}
+
+/** @brief Sets the width of the frames in the virtual source
+ * @param width width in pixels
+ */
+void AravisDetectorPlugin::set_virtual_width(int width, OdinData::IpcMessage& reply){
+  if(width <= 0){
+    log_error("Virtual source width must be positive, got " + std::to_string(width), reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "virtual_width_ | old: "<< virtual_width_ << " | new:" << width);
+  virtual_width_ = width;
+}
+
+/** @brief Sets the height of the frames in the virtual source
+ * @param height height in pixels
+ */
+void AravisDetectorPlugin::set_virtual_height(int height, OdinData::IpcMessage& reply){
+  if(height <= 0){
+    log_error("Virtual source height must be positive, got " + std::to_string(height), reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "virtual_height_ | old: "<< virtual_height_ << " | new:" << height);
+  virtual_height_ = height;
+}
+
+/** @brief Sets the rate the virtual source replays frames at
+ * @param frame_rate_hz frames per second, 0 to replay as fast as the plugin can take them
+ */
+void AravisDetectorPlugin::set_virtual_frame_rate(double frame_rate_hz, OdinData::IpcMessage& reply){
+  if(frame_rate_hz < 0){
+    log_error("Virtual source frame rate cannot be negative, got " + std::to_string(frame_rate_hz), reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "virtual_frame_rate_hz_ | old: "<< virtual_frame_rate_hz_ << " | new:" << frame_rate_hz);
+  virtual_frame_rate_hz_ = frame_rate_hz;
+}
+
+/** @brief Maps the virtual source and starts replaying it
+ * 
+ * Frames go through process_image like camera buffers, so the frame builders, the 
+ * frame count limit and the frame counters behave as they do with a camera. The
+ * file is mapped and pre-faulted here so the replay does not measure disk reads.
+ * 
+ * @param reply Ipc Message from config
+ */
+void AravisDetectorPlugin::start_virtual_stream(OdinData::IpcMessage& reply){
+  if(virtual_streaming_){
+    log_error("The virtual camera is already streaming", reply);
+    return;
+  }
+  // collect a replay that ended on its own
+  stop_virtual_stream();
+
+  select_frame_builder(pixel_format_);
+  if(bytes_per_pixel_ == 0){
+    log_error("Pixel format " + pixel_format_ + " is not supported by the virtual camera", reply);
+    return;
+  }
+
+  size_t n_pixels = static_cast<size_t>(virtual_width_) * virtual_height_;
+  size_t frame_bytes = unpack_kernel_ != NULL ? PixelUnpack::packed_bytes(unpack_format_, n_pixels) : n_pixels * bytes_per_pixel_;
+
+  std::string error;
+  if(!virtual_file_.open(virtual_source_, frame_bytes, error)){
+    log_error(error, reply);
+    return;
+  }
+
+  if(!start_compression(reply)){
+    virtual_file_.close();
+    return;
+  }
+
+  payload_ = frame_bytes;
+  n_frames_made_ = 0;
+  n_batches_made_ = 0;
+  publish_frame_stats();
+  publish_camera_stats();
+  streaming_ = true;
+  virtual_streaming_ = true;
+  virtual_thread_ = new boost::thread(&AravisDetectorPlugin::virtual_task, this);
+
+  LOG4CXX_INFO(logger_, "Replaying " << virtual_file_.n_frames() << " " << pixel_format_ << " frames of " 
+    << virtual_width_ << "x" << virtual_height_ << " from " << virtual_source_ << " at "
+    << (virtual_frame_rate_hz_ > 0 ? std::to_string(virtual_frame_rate_hz_) + " Hz" : "full speed"));
+}
+
+/** @brief Stops the virtual source and unmaps its file
+ * 
+ * Must not be called from the virtual source thread itself.
+ */
+void AravisDetectorPlugin::stop_virtual_stream(){
+  virtual_streaming_ = false;
+  if(virtual_thread_ == NULL)
+    return;
+  virtual_thread_->join();
+  delete virtual_thread_;
+  virtual_thread_ = NULL;
+  flush_batch();
+  publish_frame_stats();
+  frame_compressor_.stop();
+  virtual_file_.close();
+  streaming_ = false;
+}
+
+/** @brief Virtual source execution thread
+ * 
+ * Loops over the frames of virtual_file_ until stopped or frame_count_ frames have 
+ * been made. At a set rate each frame has a fixed slot; a frame that falls more than 
+ * one period behind counts as late and the schedule restarts from now rather than 
+ * bursting to catch up.
+ */
+void AravisDetectorPlugin::virtual_task(){
+  // Configure logging for this thread
+  OdinData::configure_logging_mdc(OdinData::app_path.c_str());
+
+  boost::posix_time::time_duration period = boost::posix_time::microseconds(
+    virtual_frame_rate_hz_ > 0 ? static_cast<long>(1e6 / virtual_frame_rate_hz_) : 0);
+  boost::posix_time::ptime next_frame = boost::posix_time::microsec_clock::universal_time();
+
+  ImageView image;
+  image.size = virtual_file_.frame_bytes();
+  image.height = virtual_height_;
+  image.width = virtual_width_;
+  image.buffer = NULL;
+  image.camera_timestamp = 0;
+  image.frame_id = 0;
+  image.callback_time = 0;
+
+  size_t index = 0;
+  while(virtual_streaming_){
+    consume_frame_reset();
+    if(frame_count_ > 0 && n_frames_made_ >= frame_count_){
+      LOG4CXX_INFO(logger_,"Reached " << frame_count_ <<" frames, stopping virtual camera stream");
+      break;
+    }
+
+    if(period.total_microseconds() > 0){
+      boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+      if(now < next_frame){
+        flush_stale_batch();
+        // sleep in short steps so a stop is not held up by a slow rate, or a batch by its timeout
+        boost::this_thread::sleep(std::min(next_frame, now + boost::posix_time::milliseconds(10)));
+        continue;
+      }
+      if(now - next_frame > period){
+        n_virtual_late_frames_++;
+        next_frame = now;
+      }
+      next_frame += period;
+    }
+
+    image.data = virtual_file_.frame(index);
+    image.system_timestamp = realtime_ns();
+    n_virtual_frames_++;
+    process_image(image);
+    if(++index == virtual_file_.n_frames())
+      index = 0;
+  }
+
+  virtual_streaming_ = false;
+  streaming_ = false;
+}
+
 /** @brief Sets maximum number of frames taken in stream mode
  * @param frame_count unsigned int: frame limit
  */
@@ -1038,6 +3148,509 @@ void AravisDetectorPlugin::set_empty_buffers(int n_empty_buffers, OdinData::IpcM
   n_empty_buffers_ = n_empty_buffers;
 }
 
+/** @brief Turns the adaptive buffer pool on or off
+ * 
+ * @param adaptive bool: true to grow the pool under pressure
+ */
+void AravisDetectorPlugin::set_adaptive_buffers(bool adaptive, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "adaptive_buffers_ | old: "<< adaptive_buffers_ << " | new:" << adaptive);
+  adaptive_buffers_ = adaptive;
+}
+
+/** @brief Sets the number of free buffers below which the adaptive pool grows
+ * 
+ * @param low_watermark int: free buffer count
+ */
+void AravisDetectorPlugin::set_buffer_low_watermark(int low_watermark, OdinData::IpcMessage& reply){
+  if(low_watermark < 0){
+    log_error("The buffer low watermark: " + std::to_string(low_watermark) + " must not be negative", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "buffer_low_watermark_ | old: "<< buffer_low_watermark_ << " | new:" << low_watermark);
+  buffer_low_watermark_ = low_watermark;
+}
+
+/** @brief Sets the maximum memory the adaptive pool can use for stream buffers
+ * 
+ * @param limit_mb size_t: ceiling in megabytes, including the n_empty_buffers_ base pool
+ */
+void AravisDetectorPlugin::set_buffer_memory_limit(size_t limit_mb, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "buffer_memory_limit_mb_ | old: "<< buffer_memory_limit_mb_ << " | new:" << limit_mb);
+  buffer_memory_limit_mb_ = limit_mb;
+}
+
+/** @brief Sets how long the pool must go without pressure before extra buffers are freed
+ * 
+ * @param idle_ms size_t: idle time in milliseconds
+ */
+void AravisDetectorPlugin::set_buffer_idle_time(size_t idle_ms, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "buffer_idle_ms_ | old: "<< buffer_idle_ms_ << " | new:" << idle_ms);
+  buffer_idle_ms_ = idle_ms;
+}
+
+/** @brief Chooses between per stream heap buffers and the persistent buffer arena
+ * 
+ * @param use_arena bool: true to take the stream buffers from the arena
+ */
+void AravisDetectorPlugin::set_buffer_arena(bool use_arena, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "use_buffer_arena_ | old: "<< use_buffer_arena_ << " | new:" << use_arena);
+  use_buffer_arena_ = use_arena;
+  if(!use_arena)
+    buffer_arena_.release();
+}
+
+/** @brief Turns placeholder frames for missing camera frames on or off
+ * 
+ * @param fill_missing bool: true to push a blank frame for each missing camera frame id
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_fill_missing(bool fill_missing, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "fill_missing_ | old: "<< fill_missing_.load() << " | new:" << fill_missing);
+  fill_missing_.store(fill_missing, std::memory_order_relaxed);
+}
+
+/** @brief Sets the number of frames the camera to host clock fit is averaged over
+ * 
+ * A longer window gives a steadier mapping but follows changes of drift more slowly.
+ * Applied on the next stream start.
+ * 
+ * @param clock_window int: number of frames, at least 2
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_clock_window(int clock_window, OdinData::IpcMessage& reply){
+  if(clock_window < 2){
+    log_error("Clock window must be at least 2 frames", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "clock_window_ | old: "<< clock_window_ << " | new:" << clock_window);
+  clock_window_ = clock_window;
+}
+
+/** @brief Sets the minimum time between summaries of failed buffers
+ * 
+ * @param interval_ms size_t, in miliseconds
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_buffer_log_interval(size_t interval_ms, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "buffer_log_interval_ms_ | old: "<< buffer_log_interval_ms_ << " | new:" << interval_ms);
+  buffer_log_interval_ms_ = interval_ms;
+}
+
+/** @brief Starts the compression threads for a new stream, if compression is on
+ * 
+ * @param reply ipc message log
+ * @return false if compression is on but could not be started
+ */
+bool AravisDetectorPlugin::start_compression(OdinData::IpcMessage& reply){
+  if(n_compression_threads_ == 0)
+    return true;
+
+  std::string error;
+  if(!frame_compressor_.start(n_compression_threads_, compression_codec_, compression_shuffle_, compression_level_,
+                              boost::bind(&AravisDetectorPlugin::process_frame, this, boost::placeholders::_1), error)){
+    log_error(error, reply);
+    return false;
+  }
+  LOG4CXX_INFO(logger_, "Compressing frames with blosc " << compression_codec_ << " on " << n_compression_threads_ << " threads");
+  return true;
+}
+
+/** @brief Sets the number of threads compressing frames in the plugin
+ * 
+ * With at least one thread, frames are compressed with Blosc before they leave the
+ * plugin and carry the blosc compression type, so the file writer can write them
+ * as chunks without compressing them itself. Applied on the next stream start.
+ * 
+ * @param n_threads int: number of threads, 0 to send frames uncompressed
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_compression_threads(int n_threads,  OdinData::IpcMessage& reply){
+  if(n_threads < 0){
+    log_error("Number of compression threads cannot be negative", reply);
+    return;
+  }
+  if(n_threads > 0 && !FrameCompressor::available()){
+    log_error("Compression in the plugin needs it to be built with Blosc", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "n_compression_threads_ | old: "<< n_compression_threads_ << " | new:" << n_threads);
+  n_compression_threads_ = n_threads;
+}
+
+/** @brief Sets the Blosc compressor used in the plugin, applied on the next stream start
+ * 
+ * @param codec string: blosclz, lz4, lz4hc, zlib or zstd
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_compression_codec(std::string codec,  OdinData::IpcMessage& reply){
+  std::string error;
+  if(!FrameCompressor::check_settings(codec, compression_shuffle_, compression_level_, error)){
+    log_error(error, reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "compression_codec_ | old: "<< compression_codec_ << " | new:" << codec);
+  compression_codec_ = codec;
+}
+
+/** @brief Sets the Blosc shuffle used in the plugin, applied on the next stream start
+ * 
+ * The bit shuffle with lz4 is the bitshuffle/LZ4 scheme, in Blosc's chunk format.
+ * 
+ * @param shuffle string: none, byte or bit
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_compression_shuffle(std::string shuffle,  OdinData::IpcMessage& reply){
+  std::string error;
+  if(!FrameCompressor::check_settings(compression_codec_, shuffle, compression_level_, error)){
+    log_error(error, reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "compression_shuffle_ | old: "<< compression_shuffle_ << " | new:" << shuffle);
+  compression_shuffle_ = shuffle;
+}
+
+/** @brief Sets the Blosc compression level used in the plugin, applied on the next stream start
+ * 
+ * @param level int: 0 (no compression) to 9
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_compression_level(int level,  OdinData::IpcMessage& reply){
+  std::string error;
+  if(!FrameCompressor::check_settings(compression_codec_, compression_shuffle_, level, error)){
+    log_error(error, reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "compression_level_ | old: "<< compression_level_ << " | new:" << level);
+  compression_level_ = level;
+}
+
+/** @brief Replaces the dark frame and gain map applied to frames
+ * 
+ * The new maps are taken up by the thread making frames before its next frame.
+ * Must be called with correction_mutex_ held.
+ * 
+ * @param dark dark frame, empty for none
+ * @param gain gain map, empty for none
+ * @param[out] error description of the failure
+ * @return false if the two do not have the same number of pixels, nothing is changed
+ */
+bool AravisDetectorPlugin::update_correction(const std::vector<float>& dark, const std::vector<float>& gain, std::string& error){
+  boost::shared_ptr<FrameCorrection::Maps> maps;
+  if(!dark.empty() || !gain.empty()){
+    maps = boost::make_shared<FrameCorrection::Maps>();
+    if(!FrameCorrection::make_maps(dark, gain, *maps, error))
+      return false;
+  }
+  dark_map_ = dark;
+  gain_map_ = gain;
+  pending_correction_ = maps;
+  correction_pixels_ = maps ? maps->dark.size() : 0;
+  correction_changed_.store(true, std::memory_order_release);
+  return true;
+}
+
+/** @brief Loads the dark frame subtracted from every frame
+ * 
+ * The file holds one native endian 32 bit float per pixel, in row order, for frames
+ * of the current size (see save_dark). Frames of another size are sent uncorrected.
+ * Applied from the next frame, streaming or not.
+ * 
+ * @param dark_file string: path of the file, empty to stop subtracting a dark frame
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_dark_file(std::string dark_file,  OdinData::IpcMessage& reply){
+  std::vector<float> dark;
+  std::string error;
+  if(!dark_file.empty() && !FrameCorrection::load_map(dark_file, dark, error)){
+    log_error(error, reply);
+    return;
+  }
+  boost::mutex::scoped_lock lock(correction_mutex_);
+  if(!update_correction(dark, gain_map_, error)){
+    log_error(error, reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "dark_file_ | old: "<< dark_file_ << " | new:" << dark_file);
+  dark_file_ = dark_file;
+}
+
+/** @brief Loads the gain map every frame is multiplied by after the dark is subtracted
+ * 
+ * The file holds one native endian 32 bit float per pixel, in row order, usually the
+ * mean of a flat field divided by each pixel of it. Applied from the next frame.
+ * 
+ * @param gain_file string: path of the file, empty to stop applying a gain map
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_gain_file(std::string gain_file,  OdinData::IpcMessage& reply){
+  std::vector<float> gain;
+  std::string error;
+  if(!gain_file.empty() && !FrameCorrection::load_map(gain_file, gain, error)){
+    log_error(error, reply);
+    return;
+  }
+  boost::mutex::scoped_lock lock(correction_mutex_);
+  if(!update_correction(dark_map_, gain, error)){
+    log_error(error, reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "gain_file_ | old: "<< gain_file_ << " | new:" << gain_file);
+  gain_file_ = gain_file;
+}
+
+/** @brief Averages the next frames into a new dark frame
+ * 
+ * The capture runs on the thread making frames, from the raw pixels, while the frames
+ * are still pushed as usual. Once done the average replaces the dark frame in use.
+ * 
+ * @param n_frames int: number of frames to average, 1 to 65535
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::capture_dark(int n_frames,  OdinData::IpcMessage& reply){
+  if(n_frames < 1 || n_frames > MAX_DARK_CAPTURE_FRAMES){
+    log_error("A dark frame is captured from 1 to " + std::to_string(MAX_DARK_CAPTURE_FRAMES) + " frames", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "Capturing a dark frame from the next " << n_frames << " frames");
+  dark_capture_request_ = n_frames;
+}
+
+/** @brief Writes the dark frame in use, loaded or captured, in the format dark_file reads
+ * 
+ * @param path string: file to write
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::save_dark(std::string path,  OdinData::IpcMessage& reply){
+  boost::mutex::scoped_lock lock(correction_mutex_);
+  if(dark_map_.empty()){
+    log_error("There is no dark frame to save", reply);
+    return;
+  }
+  std::string error;
+  if(!FrameCorrection::save_map(path, dark_map_, error)){
+    log_error(error, reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "Saved the dark frame of " << dark_map_.size() << " pixels to " << path);
+}
+
+/** @brief Sets the region of interest cropped out of each frame, applied on the next stream start
+ * 
+ * The region is checked against the image size when the first frame arrives; if it
+ * does not fit, frames are sent whole. Bayer frames are also sent whole unless x and
+ * y are even, so the colour pattern of the region starts like the sensor's.
+ * 
+ * @param x int: first column
+ * @param y int: first row
+ * @param width int: number of columns, 0 for up to the right edge
+ * @param height int: number of rows, 0 for up to the bottom edge
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_roi(int x, int y, int width, int height,  OdinData::IpcMessage& reply){
+  if(x < 0 || y < 0 || width < 0 || height < 0){
+    log_error("Region of interest values cannot be negative", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "roi | old: "<< reduction_settings_.x << "," << reduction_settings_.y << " " << reduction_settings_.width << "x" << reduction_settings_.height
+                        << " | new:" << x << "," << y << " " << width << "x" << height);
+  reduction_settings_.x = x;
+  reduction_settings_.y = y;
+  reduction_settings_.width = width;
+  reduction_settings_.height = height;
+}
+
+/** @brief Sets the binning of the region of interest, applied on the next stream start
+ * 
+ * Sums are widened so they never overflow: to 16 bits for 8 bit frames when they
+ * fit, otherwise to 32 bits. Means keep the depth of the frames. Bayer frames are
+ * sent whole with any binning other than 1x1, which would mix their colours.
+ * 
+ * @param bin_x int: columns binned into one pixel, 1 to 256
+ * @param bin_y int: rows binned into one pixel, 1 to 256
+ * @param mode string: "sum" or "mean"
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_binning(int bin_x, int bin_y, std::string mode,  OdinData::IpcMessage& reply){
+  if(bin_x < 1 || bin_y < 1 || bin_x > MAX_BINNING || bin_y > MAX_BINNING){
+    log_error("Binning must be between 1 and " + std::to_string(MAX_BINNING) + " along each axis", reply);
+    return;
+  }
+  FrameReduction::Mode binning_mode;
+  if(!FrameReduction::mode_from_string(mode, binning_mode)){
+    log_error("Binning mode " + mode + " is not one of sum, mean", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "binning | old: "<< reduction_settings_.bin_x << "x" << reduction_settings_.bin_y << " " << FrameReduction::mode_name(reduction_settings_.mode)
+                        << " | new:" << bin_x << "x" << bin_y << " " << mode);
+  reduction_settings_.bin_x = bin_x;
+  reduction_settings_.bin_y = bin_y;
+  reduction_settings_.mode = binning_mode;
+}
+
+/** @brief Pushes only one camera frame in every n
+ * 
+ * Applied from the next frame. Dropped frames are counted in decimated_frames.
+ * 
+ * @param decimation int: keep one frame in this many, 1 to keep them all
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_decimation(int decimation,  OdinData::IpcMessage& reply){
+  if(decimation < 1){
+    log_error("Decimation must be at least 1", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "decimation_ | old: "<< decimation_.load() << " | new:" << decimation);
+  decimation_.store(decimation, std::memory_order_relaxed);
+}
+
+/** @brief Adds the image statistics of each frame to its parameters, applied on the next stream start
+ * 
+ * Only monochrome and Bayer frames of 8 and 16 bits, after any correction and binning, 
+ * are measured.
+ * 
+ * @param measure_images bool
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_image_statistics(bool measure_images,  OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "measure_images_ | old: "<< measure_images_ << " | new:" << measure_images);
+  measure_images_ = measure_images;
+}
+
+/** @brief Sets the number of bins of the per frame histogram, applied on the next stream start
+ * 
+ * The bins split the range of the pixel type evenly, so with 16 bins each bin of an
+ * 8 bit frame is 16 values wide.
+ * 
+ * @param histogram_bins int: 0 for no histogram, or a power of two up to 256
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_histogram_bins(int histogram_bins,  OdinData::IpcMessage& reply){
+  if(histogram_bins < 0 || !ImageStatistics::valid_histogram_bins(histogram_bins)){
+    log_error("Histogram bins must be 0 or a power of two up to " + std::to_string(ImageStatistics::MAX_HISTOGRAM_BINS), reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "histogram_bins_ | old: "<< histogram_bins_ << " | new:" << histogram_bins);
+  histogram_bins_ = histogram_bins;
+}
+
+/** @brief Sets the number of images stacked into each frame, applied on the next stream start
+ * 
+ * Batch frames are batch x height x width, numbered by batch, so the file writer's
+ * dataset needs the same dimensions. Batched images are always copied.
+ * 
+ * @param batch_size int: 1 to push a frame per image, up to 4096
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_batch_size(int batch_size,  OdinData::IpcMessage& reply){
+  if(batch_size < 1 || batch_size > MAX_BATCH_SIZE){
+    log_error("Batch size must be between 1 and " + std::to_string(MAX_BATCH_SIZE), reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "batch_size_ | old: "<< batch_size_ << " | new:" << batch_size);
+  batch_size_ = batch_size;
+}
+
+/** @brief Sets how long after its first image a batch that is not full is pushed
+ * 
+ * Keeps the latency of a slow or stalled stream bounded. The blank slots of a batch
+ * pushed early are counted in partial_batches.
+ * 
+ * @param batch_timeout_ms int, in miliseconds, 0 to only push full batches
+ * @param reply ipc message log
+ */
+void AravisDetectorPlugin::set_batch_timeout(int batch_timeout_ms,  OdinData::IpcMessage& reply){
+  if(batch_timeout_ms < 0){
+    log_error("Batch timeout cannot be negative", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "batch_timeout_ms_ | old: "<< batch_timeout_ms_.load() << " | new:" << batch_timeout_ms);
+  batch_timeout_ms_.store(batch_timeout_ms, std::memory_order_relaxed);
+}
+
+/** @brief Requests hugepages for the buffer arena, applied on the next allocation
+ * 
+ * @param use_hugepages bool
+ */
+void AravisDetectorPlugin::set_hugepages(bool use_hugepages, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "use_hugepages_ | old: "<< use_hugepages_ << " | new:" << use_hugepages);
+  use_hugepages_ = use_hugepages;
+}
+
+/** @brief Requests the buffer arena to be locked into RAM, applied on the next allocation
+ * 
+ * @param lock_buffers bool
+ */
+void AravisDetectorPlugin::set_lock_buffers(bool lock_buffers, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "lock_buffers_ | old: "<< lock_buffers_ << " | new:" << lock_buffers);
+  lock_buffers_ = lock_buffers;
+}
+
+/** @brief Sets the number of buffers that can wait for the dispatch thread
+ * 
+ * Takes effect the next time the stream is started.
+ * 
+ * @param queue_depth int: dispatch queue capacity, at least 1
+ */
+void AravisDetectorPlugin::set_queue_depth(int queue_depth, OdinData::IpcMessage& reply){
+  if(queue_depth < 1){
+    log_error("The queue depth: " + std::to_string(queue_depth) + " must be at least 1", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "queue_depth_ | old: "<< queue_depth_ << " | new:" << queue_depth);
+  queue_depth_ = queue_depth;
+}
+
+/** @brief Sets what the stream callback does when the dispatch queue is full
+ * 
+ * Takes effect the next time the stream is started.
+ * 
+ * @param policy std::string = one of the following: "block", "drop_oldest", "drop_newest"
+ */
+void AravisDetectorPlugin::set_queue_overflow(std::string policy, OdinData::IpcMessage& reply){
+  if(policy == QUEUE_OVERFLOW_BLOCK){
+    queue_overflow_ = QUEUE_BLOCK;
+  }else if(policy == QUEUE_OVERFLOW_DROP_OLDEST){
+    queue_overflow_ = QUEUE_DROP_OLDEST;
+  }else if(policy == QUEUE_OVERFLOW_DROP_NEWEST){
+    queue_overflow_ = QUEUE_DROP_NEWEST;
+  }else{
+    log_error("the queue overflow policy supplied: " + policy + " is invalid and must be of the following: block, drop_oldest, drop_newest", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "queue_overflow_ | old: "<< queue_overflow_name_ << " | new:" << policy);
+  queue_overflow_name_ = policy;
+}
+
+/** @brief Turns zero copy frame creation on or off
+ * 
+ * In zero copy mode the frames pushed downstream point straight into the ArvBuffer 
+ * and the buffer is only handed back to the stream once every plugin has released it.
+ * Applied on the next stream start.
+ * 
+ * @param zero_copy bool: true to wrap buffers, false to copy them
+ */
+void AravisDetectorPlugin::set_zero_copy(bool zero_copy, OdinData::IpcMessage& reply){
+  LOG4CXX_INFO(logger_, "zero_copy_ | old: "<< zero_copy_ << " | new:" << zero_copy);
+  zero_copy_ = zero_copy;
+}
+
+/** @brief Sets the number of buffers that are never handed downstream in zero copy mode
+ * 
+ * Once fewer than n_reserve buffers are left to the stream, frames are copied
+ * instead so the camera never runs out of buffers while a downstream plugin stalls.
+ * Applied on the next stream start.
+ * 
+ * @param n_reserve int: number of buffers kept for the camera
+ */
+void AravisDetectorPlugin::set_zero_copy_reserve(int n_reserve, OdinData::IpcMessage& reply){
+  if(n_reserve < 0){
+    log_error("The zero copy reserve: " + std::to_string(n_reserve) + " must not be negative", reply);
+    return;
+  }
+  LOG4CXX_INFO(logger_, "n_zero_copy_reserve_ | old: "<< n_zero_copy_reserve_ << " | new:" << n_reserve);
+  n_zero_copy_reserve_ = n_reserve;
+}
+
 
 /** @brief processes a fixed number of buffers
  * 
@@ -1083,93 +3696,856 @@ void AravisDetectorPlugin::acquire_buffer(){
 
   buffer = arv_stream_pop_buffer(stream_);
 
-  if(buffer_is_valid(buffer)){
-    process_buffer(buffer);
-  }
+  // a zero copy frame hands the buffer back itself once it is released
+  if(buffer_is_valid(buffer) && process_buffer(buffer))
+    return;
 
   // for stream we need to replenish the buffers
   arv_stream_push_buffer(stream_, buffer);
  }
 
-/** @brief Captures one frame buffer from a continuos stream
+/** @brief Checks a buffer popped from the stream
  * 
- * Checks the buffer for errors and sends it to the frame processor if it is ok.
+ * Runs on the stream thread for every buffer, so it only counts the outcome of
+ * arv_buffer_get_status; failures are logged as periodic summaries by the status
+ * thread (see log_buffer_summary).
  * 
- * Essentially calls arv_buffer_get_status and sends the result through a switch
+ * @return true if the buffer holds a complete image
  */
 bool AravisDetectorPlugin::buffer_is_valid(ArvBuffer *buffer){
-  bool buffer_state = false;
+  BufferOutcome outcome;
   // if buffer is empty then it isn't finished.
-  if (!ARV_IS_BUFFER (buffer))
-    log_error("Buffer is empty");
-
-  switch(arv_buffer_get_status(buffer)){
-    case ARV_BUFFER_STATUS_SUCCESS:
-      buffer_state = true;
-      break;
-    case ARV_BUFFER_STATUS_UNKNOWN:
-      log_error("Error when getting the buffer: status unknown");
-      break;
-    case ARV_BUFFER_STATUS_TIMEOUT:
-      log_error("Error when getting the buffer: timeout");
-      break;
-    case ARV_BUFFER_STATUS_MISSING_PACKETS:
-      log_error("Error when getting the buffer: missing packets.");
-      break;
-    case ARV_BUFFER_STATUS_WRONG_PACKET_ID:
-      log_error("Error when getting the buffer: wrong packet id");
-      break;
-    case ARV_BUFFER_STATUS_SIZE_MISMATCH:
-      log_error("Error when getting the buffer: size mismatch");
-      break;
-    case ARV_BUFFER_STATUS_FILLING:
-      log_error("Error when getting the buffer: status still filling");
-      break;
-    case ARV_BUFFER_STATUS_ABORTED:
-      log_error("Error when getting the buffer: aborted");
-      break;
-    case ARV_BUFFER_STATUS_PAYLOAD_NOT_SUPPORTED:
-      log_error("Error when getting the buffer: payload not supported");
-      break;
-    default:
-      log_error("Error when getting the buffer: unexpected buffer status");
+  if (!ARV_IS_BUFFER (buffer)){
+    outcome = BUFFER_EMPTY;
+  }else{
+    switch(arv_buffer_get_status(buffer)){
+      case ARV_BUFFER_STATUS_SUCCESS:               outcome = BUFFER_SUCCESS; break;
+      case ARV_BUFFER_STATUS_UNKNOWN:               outcome = BUFFER_UNKNOWN; break;
+      case ARV_BUFFER_STATUS_CLEARED:               outcome = BUFFER_CLEARED; break;
+      case ARV_BUFFER_STATUS_TIMEOUT:               outcome = BUFFER_TIMEOUT; break;
+      case ARV_BUFFER_STATUS_MISSING_PACKETS:       outcome = BUFFER_MISSING_PACKETS; break;
+      case ARV_BUFFER_STATUS_WRONG_PACKET_ID:       outcome = BUFFER_WRONG_PACKET_ID; break;
+      case ARV_BUFFER_STATUS_SIZE_MISMATCH:         outcome = BUFFER_SIZE_MISMATCH; break;
+      case ARV_BUFFER_STATUS_FILLING:               outcome = BUFFER_FILLING; break;
+      case ARV_BUFFER_STATUS_ABORTED:               outcome = BUFFER_ABORTED; break;
+      case ARV_BUFFER_STATUS_PAYLOAD_NOT_SUPPORTED: outcome = BUFFER_PAYLOAD_NOT_SUPPORTED; break;
+      default:                                      outcome = BUFFER_OTHER;
+    }
   }
-  return buffer_state;
+  buffer_outcomes_[outcome].fetch_add(1, std::memory_order_relaxed);
+  return outcome == BUFFER_SUCCESS;
  }
 
+/** @brief Logs one line summing up the failed buffers since the last summary
+ * 
+ * Called from the status thread while streaming, at most once per 
+ * buffer_log_interval_ms_, e.g. "423 missing_packets, 2 timeout buffers in the last
+ * 1.0 s", and once more after the stream stops. Nothing is logged while every 
+ * buffer succeeds.
+ * 
+ * @param stream_ended log what is left of the interval now, the stream has stopped
+ */
+void AravisDetectorPlugin::log_buffer_summary(bool stream_ended){
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+  if(last_buffer_log_.is_not_a_date_time())
+    last_buffer_log_ = now;
+  long elapsed_ms = (now - last_buffer_log_).total_milliseconds();
+  if(!stream_ended && elapsed_ms < static_cast<long>(buffer_log_interval_ms_))
+    return;
 
-/** @brief Changes buffer object to DataBlockFrame object pointer. 
+  std::ostringstream summary;
+  for (int outcome = BUFFER_EMPTY; outcome < N_BUFFER_OUTCOMES; outcome++){
+    uint64_t count = buffer_outcomes_[outcome].load(std::memory_order_relaxed);
+    // the counts drop back when the statistics are reset
+    uint64_t logged = logged_buffer_outcomes_[outcome];
+    uint64_t failed = count < logged ? count : count - logged;
+    logged_buffer_outcomes_[outcome] = count;
+    if(failed == 0)
+      continue;
+    if(summary.tellp() > 0)
+      summary << ", ";
+    summary << failed << " " << BUFFER_OUTCOME_NAMES[outcome];
+  }
+  // the next stream starts its own interval
+  last_buffer_log_ = stream_ended ? boost::posix_time::ptime() : now;
+
+  if(summary.tellp() > 0){
+    summary << " buffers in the last " << std::fixed << std::setprecision(1) << elapsed_ms / 1000.0 << " s";
+    log_error(summary.str());
+  }
+}
+
+
+/** @brief Changes buffer object to a frame object pointer and pushes it downstream
+ * 
+ * In zero copy mode the buffer is wrapped in an AravisBufferFrame. If that would leave
+ * fewer than n_zero_copy_reserve_ buffers to the stream the image is copied into a 
+ * DataBlockFrame instead.
+ * 
+ * @return true if the buffer is now owned by a frame, false if it should be pushed back to the stream
+ */
+bool AravisDetectorPlugin::process_buffer(ArvBuffer *buffer, uint64_t callback_time){
+  ImageView image;
+  image.data = arv_buffer_get_image_data(buffer, &image.size);
+  image.height = arv_buffer_get_image_height(buffer);
+  image.width = arv_buffer_get_image_width(buffer);
+  image.buffer = buffer;
+  image.system_timestamp = arv_buffer_get_system_timestamp(buffer);
+  image.camera_timestamp = arv_buffer_get_timestamp(buffer);
+  image.frame_id = arv_buffer_get_frame_id(buffer);
+  image.callback_time = callback_time;
+  return process_image(image);
+}
+
+/** @brief Turns an image into a frame and pushes it downstream
+ * 
+ * Shared by the camera stream and the virtual source so both are measured on the
+ * same path.
+ * 
+ * @return true if the image buffer is now owned by a frame
+ */
+bool AravisDetectorPlugin::process_image(const ImageView& image){
+
+  if (frame_count_ > 0 && n_frames_made_ >= frame_count_){
+    // Multi frame mode and we have already processed the correct number of frames
+    // Do not push this frame, the first one past the limit queues the stop
+    bool expected = false;
+    if(auto_stop_requested_.compare_exchange_strong(expected, true))
+      queue_task(COMMAND_AUTO_STOP);
+    return false;
+  }
+
+  uint64_t dispatch_time = realtime_ns();
+  clock_mapper_.add(image.camera_timestamp, image.system_timestamp);
+  uint64_t previous_id = last_frame_id_;
+  uint64_t n_missing = check_frame_id(image.frame_id);
+  if(n_missing > 0 && fill_missing_.load(std::memory_order_relaxed))
+    push_placeholder_frames(previous_id, n_missing);
+
+  if(!keep_frame()){
+    n_decimated_frames_++;
+    publish_frame_stats();
+    return false;
+  }
+
+  bool retained = false;
+  boost::shared_ptr<Frame> new_frame = (this->*frame_builder_)(image, retained);
+  if(!new_frame)
+    return false;
+
+  if(new_frame == batch_frame_){
+    // the image went into the batch, which is only pushed once full
+    if(measure_frames_)
+      measure_image(static_cast<uint8_t*>(batch_frame_->get_data_ptr()) + (batch_images_ - 1) * last_frame_bytes_, NULL, dispatch_time);
+    uint64_t built_time = realtime_ns();
+    if(batch_images_ == stream_batch_size_)
+      flush_batch();
+    n_frames_made_++;
+    publish_frame_stats();
+    record_latency(image, dispatch_time, built_time, realtime_ns());
+    return false;
+  }
+
+  if(measure_frames_)
+    measure_image(new_frame->get_image_ptr(), &new_frame->meta_data(), dispatch_time);
+  uint64_t built_time = realtime_ns();
+  push_frame(new_frame);
+  n_frames_made_++;
+  publish_frame_stats();
+  record_latency(image, dispatch_time, built_time, realtime_ns());
+  return retained;
+}
+
+/** @brief Sends a frame downstream, through the compression threads if they are running
  * 
+ * Called from the single thread pushing frames. With compression on the frame is
+ * pushed by a compression thread, in the same order.
  */
-void AravisDetectorPlugin::process_buffer(ArvBuffer *buffer){
+void AravisDetectorPlugin::push_frame(boost::shared_ptr<Frame> frame){
+  if(frame_compressor_.running())
+    frame_compressor_.submit(frame);
+  else
+    process_frame(frame);
+}
 
-  data_type_ = pixel_format_to_datatype(pixel_format_);
+/** @brief Dark and flat field maps to apply to a frame, taking up any new ones
+ * 
+ * Called from the thread making frames, which keeps its own reference to the maps
+ * so a config replacing them never waits on a frame.
+ * 
+ * @param n_pixels number of pixels in the frame
+ * @return the maps, NULL if there are none, the pixels cannot be corrected or the
+ * maps are for another frame size
+ */
+const FrameCorrection::Maps *AravisDetectorPlugin::correction_maps(size_t n_pixels){
+  if(correction_changed_.load(std::memory_order_acquire)){
+    boost::mutex::scoped_lock lock(correction_mutex_);
+    correction_maps_ = pending_correction_;
+    correction_changed_ = false;
+    correction_mismatch_logged_ = false;
+  }
+  if(!correction_maps_ || correction_kernel_ == NULL)
+    return NULL;
+  if(correction_maps_->dark.size() != n_pixels){
+    n_correction_mismatches_++;
+    if(!correction_mismatch_logged_){
+      log_warning("Correction maps of " + std::to_string(correction_maps_->dark.size()) + " pixels do not match frames of " +
+                  std::to_string(n_pixels) + " pixels, frames are sent uncorrected");
+      correction_mismatch_logged_ = true;
+    }
+    return NULL;
+  }
+  return correction_maps_.get();
+}
 
-  // Will need to change this at some point 
-  image_height_px_ = arv_buffer_get_image_height(buffer);
-  image_width_px_ = arv_buffer_get_image_width(buffer);
-  if(frame_dimensions_.empty()){
-    frame_dimensions_.push_back(image_height_px_);
-    frame_dimensions_.push_back(image_width_px_);
+/** @brief Adds the raw pixels of a frame to the dark capture under way, if any
+ * 
+ * Called from the thread making frames before the frame is corrected. A capture 
+ * requested by capture_dark starts on the next frame; once its last frame is added
+ * the average becomes the dark frame in use. A change of frame size starts the 
+ * capture again.
+ * 
+ * @param pixels raw 8 or 16 bit pixels, the depth of the current stream
+ * @param n_pixels number of pixels
+ */
+void AravisDetectorPlugin::add_to_dark(const void *pixels, size_t n_pixels){
+  unsigned int request = dark_capture_request_.exchange(0);
+  if(request != 0){
+    if(correction_kernel_ == NULL){
+      log_warning("A dark frame can only be captured from monochrome or Bayer frames");
+      return;
+    }
+    dark_capture_target_ = request;
+    dark_capture_frames_ = 0;
+    dark_sum_.assign(n_pixels, 0);
+  }
+  if(dark_capture_target_ == 0 || correction_kernel_ == NULL)
+    return;
+  if(dark_sum_.size() != n_pixels){
+    log_warning("Frame size changed during the dark capture, starting it again");
+    dark_capture_frames_ = 0;
+    dark_sum_.assign(n_pixels, 0);
+  }
+
+  if(bytes_per_pixel_ == 1){
+    const uint8_t *values = static_cast<const uint8_t*>(pixels);
+    for(size_t i = 0; i < n_pixels; i++)
+      dark_sum_[i] += values[i];
   }else{
-    frame_dimensions_[0]=image_height_px_;
-    frame_dimensions_[1]=image_width_px_;
+    const uint16_t *values = static_cast<const uint16_t*>(pixels);
+    for(size_t i = 0; i < n_pixels; i++)
+      dark_sum_[i] += values[i];
   }
+  if(++dark_capture_frames_ < dark_capture_target_)
+    return;
 
-  
-  FrameMetaData metadata(n_frames_made_, "data", data_type_, "", frame_dimensions_, compression_type_);
-  boost::shared_ptr<DataBlockFrame> new_frame(new DataBlockFrame(metadata, arv_buffer_get_image_data(buffer, &payload_), payload_, image_data_offset_));
-
-  if (frame_count_ > 0){
-    if (n_frames_made_ >= frame_count_){
-      // Multi frame mode and we have already processed the correct number of frames
-      // Do not push this frame and stop the streaming
-      boost::thread *task_ptr = new boost::thread(&AravisDetectorPlugin::auto_stop_stream, this);
+  std::vector<float> dark(n_pixels);
+  for(size_t i = 0; i < n_pixels; i++)
+    dark[i] = static_cast<float>(dark_sum_[i]) / dark_capture_frames_;
+  dark_capture_target_ = 0;
+  std::vector<uint32_t>().swap(dark_sum_);
+
+  std::string error;
+  boost::mutex::scoped_lock lock(correction_mutex_);
+  if(!update_correction(dark, gain_map_, error)){
+    log_warning("Captured dark frame was not applied: " + error);
+    return;
+  }
+  dark_file_ = "";
+  LOG4CXX_INFO(logger_, "Dark frame captured from " << dark_capture_frames_ << " frames of " << n_pixels << " pixels");
+}
+
+/** @brief Checks the camera frame id of an image against the previous one
+ * 
+ * Ids that jump forward are counted as a gap of the ids skipped. GigE Vision 1.x 
+ * block ids are 16 bit and go from 65535 back to 1, so a drop from the last
+ * GVSP_WRAP_MARGIN ids of that range to one of its first is a wrap around, possibly
+ * with a gap. Any other drop means the camera restarted its ids and is counted as a
+ * reset, without a gap.
+ * 
+ * The frames lost with the camera before a recovered stream are the difference
+ * between the ids either side of it, or, if the camera restarted its ids, the time
+ * without a camera times its frame rate.
+ * 
+ * @param frame_id frame id given by the camera, 0 if unknown
+ * @return number of frames missing before this one
+ */
+uint64_t AravisDetectorPlugin::check_frame_id(uint64_t frame_id){
+  // the first frame of a recovered stream tells how many were lost with the camera
+  if(resumed_stream_){
+    resumed_stream_ = false;
+    if(frame_id != 0 && lost_frame_id_ != 0 && frame_id > lost_frame_id_)
+      n_recovery_dropped_frames_ += frame_id - lost_frame_id_ - 1;
+    else
+      n_recovery_dropped_frames_ += lost_frames_estimate_;
+  }
+
+  if(frame_id == 0)
+    return 0;
+
+  uint64_t last = last_frame_id_;
+  last_frame_id_ = frame_id;
+  if(last == 0)
+    return 0;
+
+  uint64_t n_missing = 0;
+  if(frame_id > last){
+    n_missing = frame_id - last - 1;
+  }else if(last <= GVSP_MAX_BLOCK_ID && last > GVSP_MAX_BLOCK_ID - GVSP_WRAP_MARGIN && frame_id <= GVSP_WRAP_MARGIN){
+    n_missing = (GVSP_MAX_BLOCK_ID - last) + (frame_id - 1);
+    n_frame_id_wraps_++;
+  }else{
+    n_frame_id_resets_++;
+    LOG4CXX_WARN(logger_, "Camera frame id went back from " << last << " to " << frame_id);
+    return 0;
+  }
+
+  if(n_missing > 0){
+    n_frame_gaps_++;
+    n_missing_frames_ += n_missing;
+    longest_frame_gap_ = std::max(longest_frame_gap_, static_cast<long unsigned int>(n_missing));
+  }
+  return n_missing;
+}
+
+/** @brief Pushes a blank frame for each missing camera frame
+ * 
+ * Keeps the frame numbers, and so the offsets in the output file, in step with the
+ * camera frame ids. Placeholders have the size and dimensions of the previous frame,
+ * are filled with zeros and carry the missing_frame parameter. When batching, each
+ * placeholder is a blank image of the batch instead. Nothing is pushed before the
+ * first frame of a stream, whose size is not known yet.
+ * 
+ * @param previous_id camera frame id of the last frame received before the gap
+ * @param n_missing number of frames missing
+ */
+void AravisDetectorPlugin::push_placeholder_frames(uint64_t previous_id, uint64_t n_missing){
+  if(last_frame_bytes_ == 0)
+    return;
+  if(n_missing > MAX_PLACEHOLDER_FRAMES){
+    log_warning("Gap of " + std::to_string(n_missing) + " camera frames is too long to fill with placeholder frames");
+    return;
+  }
+
+  bool wrapped = last_frame_id_ < previous_id;
+  FrameMetaData placeholder_metadata = frame_metadata_;
+  placeholder_metadata.set_parameter<uint8_t>(PARAM_MISSING_FRAME, 1);
+  for(uint64_t i = 0; i < n_missing; i++){
+    if(frame_count_ > 0 && n_frames_made_ >= frame_count_)
       return;
+    // a missing frame only needs a placeholder if decimation would have kept it
+    if(!keep_frame())
+      continue;
+    uint64_t frame_id = previous_id + 1 + i;
+    if(wrapped && frame_id > GVSP_MAX_BLOCK_ID)
+      frame_id -= GVSP_MAX_BLOCK_ID;
+    if(stream_batch_size_ > 1){
+      // a blank slot of the batch, told apart by its system timestamp of 0
+      std::memset(add_to_batch(frame_id, 0, 0, 0), 0, last_frame_bytes_);
+      if(batch_images_ == stream_batch_size_)
+        flush_batch();
+      n_frames_made_++;
+      n_placeholder_frames_++;
+      continue;
     }
+    placeholder_metadata.set_parameter<uint64_t>(PARAM_FRAME_ID, frame_id);
+    placeholder_metadata.set_frame_number(n_frames_made_);
+    boost::shared_ptr<DataBlockFrame> placeholder = boost::make_shared<DataBlockFrame>(placeholder_metadata, last_frame_bytes_, image_data_offset_);
+    std::memset(placeholder->get_data_ptr(), 0, last_frame_bytes_);
+    push_frame(placeholder);
+    n_frames_made_++;
+    n_placeholder_frames_++;
   }
-  process_frame(new_frame);
-  n_frames_made_++;
+}
+
+/** @brief Decides whether the next camera frame, received or missing, is pushed
+ * 
+ * With decimation n only the first frame of every n since the stream started is
+ * kept, counting missing frames so the kept frames stay evenly spaced.
+ * 
+ * @return false if decimation drops the frame
+ */
+bool AravisDetectorPlugin::keep_frame(){
+  int decimation = decimation_.load(std::memory_order_relaxed);
+  if(decimation <= 1)
+    return true;
+  return decimation_phase_++ % decimation == 0;
+}
+
+/** @brief Adds the image statistics of a frame to its parameters and to the window for status()
+ * 
+ * Reads the image where the frame holds it, the camera buffer itself in zero copy 
+ * mode, before it is compressed. The window is published once a second.
+ * 
+ * @param image pixels of a frame of the current size, as built
+ * @param metadata parameters of the frame, NULL for an image in a batch, which only adds to the window
+ * @param now host time in ns, to end the window
+ */
+void AravisDetectorPlugin::measure_image(const void *image, FrameMetaData *metadata, uint64_t now){
+  ImageStatistics::Result result;
+  image_statistics_.measure(image, frame_dimensions_[0], frame_dimensions_[1], result);
+  const std::vector<uint32_t>& histogram = image_statistics_.histogram();
+
+  if(metadata != NULL){
+    metadata->set_parameter<uint64_t>(PARAM_STATS_SUM, result.sum);
+    metadata->set_parameter<uint32_t>(PARAM_STATS_MIN, result.min);
+    metadata->set_parameter<uint32_t>(PARAM_STATS_MAX, result.max);
+    metadata->set_parameter<double>(PARAM_STATS_CENTROID_X, result.centroid_x);
+    metadata->set_parameter<double>(PARAM_STATS_CENTROID_Y, result.centroid_y);
+    metadata->set_parameter<double>(PARAM_STATS_RMS_X, result.rms_x);
+    metadata->set_parameter<double>(PARAM_STATS_RMS_Y, result.rms_y);
+    if(!histogram.empty())
+      metadata->set_parameter<std::vector<uint32_t>>(PARAM_STATS_HISTOGRAM, histogram);
+  }
+  n_measured_frames_++;
+
+  // the window keeps totals until it ends, then they become means
+  if(image_window_.frames == 0){
+    image_window_.min = result.min;
+    image_window_.max = result.max;
+  }
+  image_window_.frames++;
+  image_window_.mean_sum += result.sum;
+  image_window_.mean_centroid_x += result.centroid_x;
+  image_window_.mean_centroid_y += result.centroid_y;
+  image_window_.mean_rms_x += result.rms_x;
+  image_window_.mean_rms_y += result.rms_y;
+  image_window_.min = std::min(image_window_.min, result.min);
+  image_window_.max = std::max(image_window_.max, result.max);
+  image_window_.histogram_bins = histogram.size();
+  for(size_t bin = 0; bin < histogram.size(); bin++)
+    image_window_.histogram[bin] += histogram[bin];
+
+  if(now - image_window_start_ >= FPS_WINDOW_NS){
+    if(image_window_start_ != 0){
+      double frames = image_window_.frames;
+      image_window_.mean_sum /= frames;
+      image_window_.mean_centroid_x /= frames;
+      image_window_.mean_centroid_y /= frames;
+      image_window_.mean_rms_x /= frames;
+      image_window_.mean_rms_y /= frames;
+      image_summary_.write(image_window_);
+    }
+    image_window_ = ImageSummary();
+    image_window_start_ = now;
+  }
+}
+
+/** @brief Takes the slot of the next image in the batch frame, starting a new batch if needed
+ * 
+ * Only called from the thread making frames, after the frame size is known.
+ * 
+ * @param frame_id camera frame id of the image
+ * @param system_timestamp host time the image was received, 0 for a placeholder
+ * @param camera_timestamp camera time the image was taken
+ * @param utc_timestamp camera time mapped onto the host clock
+ * @return where to write the image, last_frame_bytes_ long
+ */
+void *AravisDetectorPlugin::add_to_batch(uint64_t frame_id, uint64_t system_timestamp, uint64_t camera_timestamp, uint64_t utc_timestamp){
+  if(!batch_frame_){
+    batch_frame_ = boost::make_shared<DataBlockFrame>(batch_metadata_, stream_batch_size_ * last_frame_bytes_, image_data_offset_);
+    batch_images_ = 0;
+    batch_start_ = realtime_ns();
+  }
+  batch_frame_ids_.push_back(frame_id);
+  batch_system_timestamps_.push_back(system_timestamp);
+  batch_camera_timestamps_.push_back(camera_timestamp);
+  batch_utc_timestamps_.push_back(utc_timestamp);
+  return static_cast<uint8_t*>(batch_frame_->get_data_ptr()) + batch_images_++ * last_frame_bytes_;
+}
+
+/** @brief Pushes the batch being filled, full or not
+ * 
+ * The per image frame ids and timestamps go with it as arrays. The slots of a batch
+ * pushed before it is full are left blank.
+ */
+void AravisDetectorPlugin::flush_batch(){
+  if(!batch_frame_)
+    return;
+  if(batch_images_ < stream_batch_size_){
+    std::memset(static_cast<uint8_t*>(batch_frame_->get_data_ptr()) + batch_images_ * last_frame_bytes_, 0,
+                (stream_batch_size_ - batch_images_) * last_frame_bytes_);
+    n_partial_batches_++;
+  }
+
+  FrameMetaData& metadata = batch_frame_->meta_data();
+  metadata.set_frame_number(n_batches_made_);
+  metadata.set_parameter<uint32_t>(PARAM_BATCH_IMAGES, batch_images_);
+  metadata.set_parameter<std::vector<uint64_t>>(PARAM_BATCH_FRAME_IDS, batch_frame_ids_);
+  metadata.set_parameter<std::vector<uint64_t>>(PARAM_BATCH_SYSTEM_TIMESTAMPS, batch_system_timestamps_);
+  metadata.set_parameter<std::vector<uint64_t>>(PARAM_BATCH_CAMERA_TIMESTAMPS, batch_camera_timestamps_);
+  metadata.set_parameter<std::vector<uint64_t>>(PARAM_BATCH_UTC_TIMESTAMPS, batch_utc_timestamps_);
+
+  // reset before the push, which may hand the frame to another thread
+  boost::shared_ptr<DataBlockFrame> batch = batch_frame_;
+  batch_frame_.reset();
+  batch_images_ = 0;
+  batch_frame_ids_.clear();
+  batch_system_timestamps_.clear();
+  batch_camera_timestamps_.clear();
+  batch_utc_timestamps_.clear();
+  n_batches_made_++;
+  push_frame(batch);
+}
+
+/** @brief Pushes the batch being filled if it is older than the batch timeout
+ * 
+ * Called by the thread making frames while it waits for the next image.
+ */
+void AravisDetectorPlugin::flush_stale_batch(){
+  size_t batch_timeout_ms = batch_timeout_ms_.load(std::memory_order_relaxed);
+  if(batch_frame_ && batch_timeout_ms > 0 && realtime_ns() - batch_start_ >= batch_timeout_ms * 1000000){
+    flush_batch();
+    publish_frame_stats();
+  }
+}
+
+/** @brief Adds a pushed frame to the latency histograms and the rolling frame rate
+ * 
+ * Only called from the thread pushing frames, which is the single writer of the
+ * histograms. Intervals that would be negative because the wall clock was stepped 
+ * are skipped.
+ * 
+ * @param image the image the frame was made from, with its receive and callback times
+ * @param dispatch_time when the image reached process_image
+ * @param built_time when its frame was ready to push
+ * @param pushed_time when push() returned
+ */
+void AravisDetectorPlugin::record_latency(const ImageView& image, uint64_t dispatch_time, uint64_t built_time, uint64_t pushed_time){
+  if(image.callback_time != 0){
+    if(image.system_timestamp != 0 && image.callback_time >= image.system_timestamp)
+      latency_[LATENCY_ARAVIS].record(image.callback_time - image.system_timestamp);
+    if(dispatch_time >= image.callback_time)
+      latency_[LATENCY_QUEUE].record(dispatch_time - image.callback_time);
+  }
+  latency_[LATENCY_BUILD].record(built_time - dispatch_time);
+  latency_[LATENCY_PUSH].record(pushed_time - built_time);
+  if(image.system_timestamp != 0 && pushed_time >= image.system_timestamp)
+    latency_[LATENCY_TOTAL].record(pushed_time - image.system_timestamp);
+
+  // the camera and host clocks differ, but over one frame their intervals should match
+  if(image.camera_timestamp != 0 && last_camera_timestamp_ != 0 && image.camera_timestamp > last_camera_timestamp_){
+    int64_t camera_interval = image.camera_timestamp - last_camera_timestamp_;
+    int64_t system_interval = image.system_timestamp - last_system_timestamp_;
+    latency_[LATENCY_JITTER].record(std::abs(system_interval - camera_interval));
+  }
+  last_camera_timestamp_ = image.camera_timestamp;
+  last_system_timestamp_ = image.system_timestamp;
+
+  fps_window_frames_++;
+  if(pushed_time - fps_window_start_ >= FPS_WINDOW_NS){
+    if(fps_window_start_ != 0)
+      rolling_fps_ = fps_window_frames_ * 1e9 / (pushed_time - fps_window_start_);
+    fps_window_start_ = pushed_time;
+    fps_window_frames_ = 0;
+  }
+}
+
+/** @brief Builds a frame from an image for one pixel layout
+ * 
+ * Selected once per stream by select_frame_builder. The frame meta data is prepared
+ * up front, so apart from a change of image size no strings or dimensions are built
+ * here and the only allocations are the frame itself.
+ * 
+ * In zero copy mode the buffer is wrapped in an AravisBufferFrame. If that would leave
+ * fewer than n_zero_copy_reserve_ buffers to the stream the image is copied into a 
+ * DataBlockFrame instead. Packed layouts are always unpacked into a new frame, and
+ * images without a buffer are always copied. Frames dark and flat field corrected
+ * are written by the correction kernel straight from the buffer, or in place after
+ * unpacking, and are never zero copy. Reduced frames are cropped and binned into a
+ * smaller frame, straight from the buffer unless the full frame had to be unpacked or
+ * corrected first.
+ * 
+ * When batching, every path writes the image into the next slot of the batch frame
+ * instead of a frame of its own, and the batch frame is returned without being full.
+ * 
+ * @param image a completed image
+ * @param[out] retained true if the frame now owns the buffer
+ * @return the new frame or the batch frame, empty if the buffer is too small for its image
+ */
+template <class Layout>
+boost::shared_ptr<Frame> AravisDetectorPlugin::build_frame(const ImageView& image, bool& retained){
+  const void *image_data = image.data;
+  size_t image_size = image.size;
+  unsigned long long height = image.height;
+  unsigned long long width = image.width;
+
+  if(height != image_height_px_ || width != image_width_px_)
+    set_frame_dimensions(height, width);
+
+  size_t n_pixels = height * width;
+  size_t frame_bytes = Layout::bytes_per_pixel ? n_pixels * Layout::bytes_per_pixel : image_size;
+  size_t needed_bytes = Layout::packed ? PixelUnpack::packed_bytes(unpack_format_, n_pixels) : frame_bytes;
+  if(image_size < needed_bytes){
+    log_error("Buffer of " + std::to_string(image_size) + " bytes is too small for a " + pixel_format_ + " frame of " + std::to_string(n_pixels) + " pixels");
+    return boost::shared_ptr<Frame>();
+  }
+
+  uint64_t utc_timestamp = clock_mapper_.map(image.camera_timestamp);
+  last_frame_bytes_ = reduce_frames_ ? frame_reduction_.frame_bytes() : frame_bytes;
+  // a batched image is written straight into its slot of the batch frame
+  void *batch_slot = NULL;
+  if(stream_batch_size_ > 1){
+    batch_slot = add_to_batch(image.frame_id, image.system_timestamp, image.camera_timestamp, utc_timestamp);
+  }
+  const FrameCorrection::Maps *maps = correction_maps(n_pixels);
+
+  if(!Layout::packed)
+    add_to_dark(image_data, n_pixels);
+
+  if(Layout::packed || maps != NULL || reduce_frames_){
+    // unpacking, correcting and reducing double as the copy out of the buffer, so they
+    // rule out zero copy. A full frame that is then reduced is made in scratch memory
+    boost::shared_ptr<DataBlockFrame> frame;
+    void *full_frame = NULL;
+    if(Layout::packed || maps != NULL){
+      if(reduce_frames_){
+        reduction_scratch_.resize(frame_bytes);
+        full_frame = reduction_scratch_.data();
+      }else if(batch_slot != NULL){
+        full_frame = batch_slot;
+      }else{
+        frame = boost::make_shared<DataBlockFrame>(frame_metadata_, frame_bytes, image_data_offset_);
+        full_frame = frame->get_data_ptr();
+      }
+    }
+
+    const void *pixels = image_data;
+    if(Layout::packed){
+      unpack_kernel_(static_cast<const uint8_t*>(image_data), static_cast<uint16_t*>(full_frame), n_pixels);
+      n_unpacked_frames_++;
+      add_to_dark(full_frame, n_pixels);
+      pixels = full_frame;
+    }
+    if(maps != NULL){
+      correction_kernel_(pixels, full_frame, maps->dark.data(), maps->gain.data(), n_pixels);
+      n_corrected_frames_++;
+      pixels = full_frame;
+    }
+    if(reduce_frames_){
+      if(batch_slot == NULL)
+        frame = boost::make_shared<DataBlockFrame>(frame_metadata_, frame_reduction_.frame_bytes(), image_data_offset_);
+      frame_reduction_.reduce(pixels, batch_slot != NULL ? batch_slot : frame->get_data_ptr());
+      n_reduced_frames_++;
+    }
+    if(batch_slot != NULL)
+      return batch_frame_;
+    set_image_parameters(frame->meta_data(), image, utc_timestamp);
+    return frame;
+  }
+
+  if(batch_slot != NULL){
+    std::memcpy(batch_slot, image_data, frame_bytes);
+    n_copied_frames_++;
+    return batch_frame_;
+  }
+
+  if(stream_zero_copy_ && image.buffer != NULL && n_buffers_in_flight_ < zero_copy_limit_ + n_extra_buffers_){
+    // the frame keeps the stream alive until it hands the buffer back
+    n_buffers_in_flight_++;
+    g_object_ref(stream_);
+    n_zero_copy_frames_++;
+    retained = true;
+    boost::shared_ptr<Frame> frame = boost::make_shared<AravisBufferFrame>(frame_metadata_, stream_, image.buffer, image_data, frame_bytes,
+      boost::bind(&AravisDetectorPlugin::release_buffer, this, boost::placeholders::_1, boost::placeholders::_2), image_data_offset_);
+    set_image_parameters(frame->meta_data(), image, utc_timestamp);
+    return frame;
+  }
+
+  n_copied_frames_++;
+  boost::shared_ptr<Frame> frame = boost::make_shared<DataBlockFrame>(frame_metadata_, image_data, frame_bytes, image_data_offset_);
+  set_image_parameters(frame->meta_data(), image, utc_timestamp);
+  return frame;
+}
+
+/** @brief Sets the frame number, timestamps and camera frame id of a single image frame
+ * 
+ * Set on the frame's own meta data, so frame_metadata_, which batches and placeholders
+ * are copied from, never carries the values of an earlier image. Unknown values are
+ * left out.
+ * 
+ * @param metadata meta data of the new frame
+ * @param image the image the frame was made from
+ * @param utc_timestamp camera time mapped onto the host clock, 0 if unknown
+ */
+void AravisDetectorPlugin::set_image_parameters(FrameMetaData& metadata, const ImageView& image, uint64_t utc_timestamp){
+  metadata.set_frame_number(n_frames_made_);
+  if(image.system_timestamp != 0)
+    metadata.set_parameter<uint64_t>(PARAM_SYSTEM_TIMESTAMP, image.system_timestamp);
+  if(image.camera_timestamp != 0)
+    metadata.set_parameter<uint64_t>(PARAM_CAMERA_TIMESTAMP, image.camera_timestamp);
+  if(utc_timestamp != 0)
+    metadata.set_parameter<uint64_t>(PARAM_UTC_TIMESTAMP, utc_timestamp);
+  if(image.frame_id != 0)
+    metadata.set_parameter<uint64_t>(PARAM_FRAME_ID, image.frame_id);
+}
+
+/** @brief Makes build_frame<Layout> the frame builder of the stream */
+template <class Layout>
+void AravisDetectorPlugin::use_frame_builder(){
+  frame_builder_ = &AravisDetectorPlugin::build_frame<Layout>;
+  data_type_ = Layout::data_type;
+  image_channels_ = Layout::channels;
+  bytes_per_pixel_ = Layout::bytes_per_pixel;
+}
+
+/** @brief Resolves the frame builder and frame meta data for a pixel format
+ * 
+ * Called when a stream starts, so the per frame path does no string comparisons.
+ * Mono8 and 8 bit Bayer frames are 8 bit, Mono10 to Mono16 and the matching Bayer 
+ * formats arrive in 16 bit containers. Packed formats are unpacked into 16 bit frames 
+ * (see PixelUnpack). RGB8/BGR8 frames get a third dimension of 3 and YUV422 frames
+ * one of 2. Anything else is sent as raw_unknown. Only the single channel 8 and 16
+ * bit frames get a correction kernel (see FrameCorrection) and can be cropped and
+ * binned (see FrameReduction).
+ * 
+ * @param pixel_format string representation of the format (eg, Mono8, Mono12p, RGB8)
+ */
+void AravisDetectorPlugin::select_frame_builder(const std::string& pixel_format){
+  unpack_kernel_ = NULL;
+  correction_kernel_ = NULL;
+
+  if(pixel_format == "Mono8" || (boost::starts_with(pixel_format, "Bayer") && boost::ends_with(pixel_format, "8"))){
+    use_frame_builder<Mono8Layout>();
+    correction_kernel_ = FrameCorrection::kernel(FrameCorrection::DEPTH_8);
+  }else if(pixel_format == "Mono10" || pixel_format == "Mono12" || pixel_format == "Mono14" || pixel_format == "Mono16" ||
+           (boost::starts_with(pixel_format, "Bayer") && (boost::ends_with(pixel_format, "10") ||
+            boost::ends_with(pixel_format, "12") || boost::ends_with(pixel_format, "16")))){
+    use_frame_builder<Mono16Layout>();
+    correction_kernel_ = FrameCorrection::kernel(FrameCorrection::DEPTH_16);
+  }else if(PixelUnpack::format_from_string(pixel_format, unpack_format_)){
+    use_frame_builder<PackedLayout>();
+    unpack_kernel_ = PixelUnpack::kernel(unpack_format_);
+    correction_kernel_ = FrameCorrection::kernel(FrameCorrection::DEPTH_16);
+    LOG4CXX_INFO(logger_, "Unpacking " << pixel_format << " frames to 16 bit using " 
+      << PixelUnpack::isa_name(PixelUnpack::best_isa()) << " kernels");
+  }else if(pixel_format == "RGB8" || pixel_format == "BGR8" || pixel_format == "RGB8Packed" || pixel_format == "BGR8Packed"){
+    use_frame_builder<Rgb8Layout>();
+  }else if(pixel_format == "YUV422_8" || pixel_format == "YUV422_8_UYVY" || pixel_format == "YUV422Packed" || pixel_format == "YUV422_YUYV_Packed"){
+    use_frame_builder<Yuv422Layout>();
+  }else{
+    use_frame_builder<UnknownLayout>();
+    log_warning("Pixel format " + pixel_format + " is not supported, frames are sent as raw_unknown");
+  }
+  if(correction_kernel_ == NULL && correction_pixels_ != 0)
+    log_warning("Dark and flat field correction only applies to monochrome and Bayer frames, " + pixel_format + " frames are sent uncorrected");
+
+  // binning would mix the colours of a Bayer mosaic, and an odd offset would shift it
+  FrameReduction::Settings reduction = reduction_settings_;
+  if(boost::starts_with(pixel_format, "Bayer") &&
+     (reduction.bin_x != 1 || reduction.bin_y != 1 || reduction.x % 2 != 0 || reduction.y % 2 != 0)){
+    log_warning("Bayer frames can only be cropped at even offsets and cannot be binned, " + pixel_format + " frames are sent whole");
+    reduction = FrameReduction::Settings {0, 0, 0, 0, 1, 1, reduction.mode};
+  }
+  frame_reduction_.configure(reduction, bytes_per_pixel_);
+  reduce_frames_ = false;
+  decimation_phase_ = 0;
+  if(frame_reduction_.active() && correction_kernel_ == NULL)
+    log_warning("Region of interest and binning only apply to monochrome and Bayer frames, " + pixel_format + " frames are sent whole");
+
+  measure_stream_ = measure_images_ && correction_kernel_ != NULL && image_statistics_.configure(bytes_per_pixel_, histogram_bins_);
+  measure_frames_ = false;
+  image_window_ = ImageSummary();
+  image_window_start_ = 0;
+  if(measure_images_ && !measure_stream_)
+    log_warning("Image statistics only apply to monochrome and Bayer frames, " + pixel_format + " frames are not measured");
+
+  // configure may change these while frames are made
+  stream_zero_copy_ = zero_copy_;
+  zero_copy_limit_ = n_empty_buffers_ - n_zero_copy_reserve_;
+
+  stream_batch_size_ = batch_size_;
+  if(stream_batch_size_ > 1 && bytes_per_pixel_ == 0){
+    // every slot of a batch is the size of its first image, which only a known layout guarantees
+    log_warning("Images of unknown layout can vary in size and are not batched, " + pixel_format + " frames are sent one by one");
+    stream_batch_size_ = 1;
+  }
+  batch_frame_.reset();
+  batch_images_ = 0;
+  batch_frame_ids_.clear();
+  batch_system_timestamps_.clear();
+  batch_camera_timestamps_.clear();
+  batch_utc_timestamps_.clear();
+  if(stream_batch_size_ > 1){
+    batch_frame_ids_.reserve(stream_batch_size_);
+    batch_system_timestamps_.reserve(stream_batch_size_);
+    batch_camera_timestamps_.reserve(stream_batch_size_);
+    batch_utc_timestamps_.reserve(stream_batch_size_);
+    LOG4CXX_INFO(logger_, "Stacking " << stream_batch_size_ << " images into each frame" << (zero_copy_ ? ", batched images are copied" : ""));
+  }
+
+  // dimensions are filled in from the first buffer
+  image_height_px_ = 0;
+  image_width_px_ = 0;
+  frame_dimensions_.clear();
+  frame_metadata_ = FrameMetaData(0, data_set_name_, data_type_, "", frame_dimensions_, compression_type_);
+}
+
+/** @brief Updates the frame dimensions after a change of image size
+ * 
+ * Frames are height x width, or height x width x channels for multi channel formats.
+ * When the region of interest and binning fit the new size, frames take the reduced
+ * size and depth instead. Image statistics are then set up for the size and depth
+ * of the frames. When batching, the batch under way is pushed and batch frames take
+ * the new size.
+ */
+void AravisDetectorPlugin::set_frame_dimensions(unsigned long long height, unsigned long long width){
+  image_height_px_ = height;
+  image_width_px_ = width;
+
+  reduce_frames_ = false;
+  if(frame_reduction_.active() && correction_kernel_ != NULL){
+    std::string error;
+    if(frame_reduction_.fit(height, width, error)){
+      reduce_frames_ = true;
+      height = frame_reduction_.height();
+      width = frame_reduction_.width();
+    }else{
+      log_warning(error + ", frames are sent whole");
+    }
+  }
+  static const DataType REDUCED_TYPES[] = {raw_unknown, raw_8bit, raw_16bit, raw_unknown, raw_32bit};
+  frame_metadata_.set_data_type(reduce_frames_ ? REDUCED_TYPES[frame_reduction_.bytes_per_pixel()] : data_type_);
+
+  frame_dimensions_.clear();
+  frame_dimensions_.push_back(height);
+  frame_dimensions_.push_back(width);
+  if(image_channels_ > 1)
+    frame_dimensions_.push_back(image_channels_);
+  frame_metadata_.set_dimensions(frame_dimensions_);
+
+  if(stream_batch_size_ > 1){
+    // a batch holds images of one size
+    flush_batch();
+    std::vector<unsigned long long> batch_dimensions(1, stream_batch_size_);
+    batch_dimensions.insert(batch_dimensions.end(), frame_dimensions_.begin(), frame_dimensions_.end());
+    batch_metadata_ = frame_metadata_;
+    batch_metadata_.set_dimensions(batch_dimensions);
+  }
+
+  measure_frames_ = false;
+  if(measure_stream_){
+    size_t depth = reduce_frames_ ? frame_reduction_.bytes_per_pixel() : bytes_per_pixel_;
+    if(height > ImageStatistics::MAX_HEIGHT)
+      log_warning("Image statistics only apply to frames up to " + std::to_string(ImageStatistics::MAX_HEIGHT) + " rows, frames are not measured");
+    else if(!image_statistics_.configure(depth, image_statistics_.histogram().size()))
+      log_warning("Image statistics only apply to 8 and 16 bit frames, " + std::to_string(8 * depth) + " bit binned frames are not measured");
+    else
+      measure_frames_ = true;
+  }
+}
+
+/** @brief Returns a buffer released by a zero copy frame to its stream
+ * 
+ * Called from whichever plugin thread drops the last reference to the frame.
+ * 
+ * @param stream the stream the buffer was popped from, referenced when the frame was made
+ * @param buffer the buffer to re-queue
+ */
+void AravisDetectorPlugin::release_buffer(ArvStream *stream, ArvBuffer *buffer){
+  requeue_buffer(stream, buffer);
+  n_buffers_in_flight_--;
+  g_object_unref(stream);
 }
 
 
@@ -1188,6 +4564,77 @@ void AravisDetectorPlugin::get_stream_state(){
 
   arv_stream_get_n_buffers(stream_, &n_input_buff_, &n_output_buff_);
   arv_stream_get_statistics(stream_, &n_completed_buff_, &n_failed_buff_, &n_underrun_buff_);
+
+  if(adaptive_buffers_ && streaming_)
+    adapt_buffer_pool();
+}
+
+/** @brief Grows the buffer pool under pressure and shrinks it back when idle
+ * 
+ * Called with fresh stream statistics. If fewer than buffer_low_watermark_ buffers are
+ * waiting for the camera, or buffers were underrun since the last check, a quarter of
+ * n_empty_buffers_ is added to the stream, as long as the pool stays under 
+ * buffer_memory_limit_mb_. Once there has been no pressure for buffer_idle_ms_ the extra
+ * buffers are freed as they come back from the camera (see requeue_buffer).
+ */
+void AravisDetectorPlugin::adapt_buffer_pool(){
+  boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+
+  // statistics may have been reset since the last check
+  if(n_underrun_buff_ < last_underrun_count_)
+    last_underrun_count_ = n_underrun_buff_;
+  bool underrun = n_underrun_buff_ > last_underrun_count_;
+  last_underrun_count_ = n_underrun_buff_;
+
+  if(underrun || n_input_buff_ < buffer_low_watermark_){
+    last_pool_pressure_ = now;
+    n_buffers_to_shrink_ = 0;
+
+    int n_pool = n_empty_buffers_ + n_extra_buffers_;
+    long long n_allowed = payload_ == 0 ? 0 :
+      static_cast<long long>(buffer_memory_limit_mb_ * 1024 * 1024 / payload_) - n_pool;
+    if(n_allowed <= 0){
+      n_pool_limit_hits_++;
+      return;
+    }
+
+    int n_grow = std::min<long long>(std::max(n_empty_buffers_ / 4, 1), n_allowed);
+    for(int i = 0; i < n_grow; i++){
+      arv_stream_push_buffer(stream_, arv_buffer_new_full(payload_, NULL, &ADAPTIVE_BUFFER_TAG, NULL));
+    }
+    n_extra_buffers_ += n_grow;
+    n_pool_grows_++;
+    LOG4CXX_INFO(logger_, "Buffer pool under pressure (" << n_input_buff_ << " free), added " 
+      << n_grow << " buffers for a total of " << n_pool + n_grow);
+    return;
+  }
+
+  if(n_extra_buffers_ > n_buffers_to_shrink_ &&
+     (now - last_pool_pressure_).total_milliseconds() > static_cast<long>(buffer_idle_ms_)){
+    n_buffers_to_shrink_ = n_extra_buffers_.load();
+    n_pool_shrinks_++;
+    LOG4CXX_INFO(logger_, "Buffer pool idle, releasing " << n_buffers_to_shrink_ << " extra buffers");
+  }
+}
+
+/** @brief Hands a buffer back to the camera
+ * 
+ * Every buffer returned to the stream goes through here. Buffers added by the adaptive
+ * pool are freed instead while the pool is shrinking.
+ * 
+ * @param stream the stream the buffer belongs to
+ * @param buffer the buffer to re-queue
+ */
+void AravisDetectorPlugin::requeue_buffer(ArvStream *stream, ArvBuffer *buffer){
+  if(n_buffers_to_shrink_ > 0 && arv_buffer_get_user_data(buffer) == &ADAPTIVE_BUFFER_TAG){
+    int n_shrink = n_buffers_to_shrink_;
+    if(n_shrink > 0 && n_buffers_to_shrink_.compare_exchange_strong(n_shrink, n_shrink - 1)){
+      n_extra_buffers_--;
+      g_object_unref(buffer);
+      return;
+    }
+  }
+  arv_stream_push_buffer(stream, buffer);
 }
 
 
@@ -1204,27 +4651,6 @@ void AravisDetectorPlugin::save_genicam_xml(std::string filepath){
 
 }
 
-/** @brief Translates from the available pixel format to datatype
- * 
- * TODO: add support for more pixel formats
- * 
- * @param pixel_form 
- * @return DataType 
- */
-DataType AravisDetectorPlugin::pixel_format_to_datatype(std::string pixel_form){
-  if(pixel_form == "Mono8")
-    return DataType::raw_8bit;
-  if(pixel_form == "Mono12")
-    log_error("Pixel type unsupported, return unkown");
-  if(pixel_form == "Mono16")
-    return DataType::raw_16bit;
-  if(pixel_form == "RGB8")
-    return DataType::raw_8bit;
-  
-
-  return DataType::raw_unknown;
-}
-
 /********************************
 **          Version            **
 *********************************/
@@ -0,0 +1,181 @@
+/**
+ * @file BufferArena.cpp
+ * @brief Pre-allocated memory region that backs the stream buffers
+ * @date 2026-10-15
+ */
+
+#include "BufferArena.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace FrameProcessor
+{
+
+const size_t BufferArena::HUGEPAGE_SIZE = 2 * 1024 * 1024;
+
+/** @brief Mapped memory shared between the arena and its buffers */
+struct ArenaRegion
+{
+  void *base;                                         ///< Start of the mapping
+  size_t size;                                        ///< Length of the mapping in bytes
+  bool hugepages;                                     ///< Was the mapping made with MAP_HUGETLB?
+  bool locked;                                        ///< Is the mapping locked into RAM?
+  std::atomic<int> refs;                              ///< Arena plus one per live buffer
+};
+
+/** @brief Drops one reference to a region, unmapping it with the last one
+ *
+ * Also used as the destroy notify of every buffer cut from the region.
+ */
+static void region_unref(void *data)
+{
+  ArenaRegion *region = static_cast<ArenaRegion*>(data);
+  if(--region->refs > 0)
+    return;
+  if(region->locked)
+    munlock(region->base, region->size);
+  munmap(region->base, region->size);
+  delete region;
+}
+
+/** @brief Rounds size up to a multiple of alignment */
+static size_t round_up(size_t size, size_t alignment)
+{
+  return ((size + alignment - 1) / alignment) * alignment;
+}
+
+BufferArena::BufferArena() :
+  region_(NULL),
+  payload_(0),
+  hugepages_requested_(false),
+  lock_requested_(false)
+{
+}
+
+BufferArena::~BufferArena()
+{
+  release();
+}
+
+/** @brief Maps a new region and cuts it into buffers, replacing any previous one
+ *
+ * Hugepages fall back to normal pages with transparent hugepage advice when none
+ * are reserved, and a failed lock leaves the region unlocked. Neither is an error.
+ *
+ * @param payload size of each buffer in bytes
+ * @param n_buffers number of buffers to create
+ * @param use_hugepages map the region on hugepages if possible
+ * @param lock_memory lock the region into RAM
+ * @param[out] error description of the failure
+ * @return false if the region could not be mapped
+ */
+bool BufferArena::allocate(size_t payload, size_t n_buffers, bool use_hugepages, bool lock_memory, std::string& error)
+{
+  release();
+
+  if(payload == 0 || n_buffers == 0){
+    error = "Cannot allocate a buffer arena of " + std::to_string(n_buffers) + " buffers of " + std::to_string(payload) + " bytes";
+    return false;
+  }
+
+  // page aligned slots keep every buffer on its own pages
+  size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t slot_size = round_up(payload, page_size);
+  size_t region_size = slot_size * n_buffers;
+
+  void *base = MAP_FAILED;
+  bool hugepages = false;
+  if(use_hugepages){
+    base = mmap(NULL, round_up(region_size, HUGEPAGE_SIZE), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+    if(base != MAP_FAILED){
+      region_size = round_up(region_size, HUGEPAGE_SIZE);
+      hugepages = true;
+    }
+  }
+  if(base == MAP_FAILED){
+    base = mmap(NULL, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if(base == MAP_FAILED){
+      error = "Failed to map " + std::to_string(region_size) + " bytes for the buffer arena: " + std::strerror(errno);
+      return false;
+    }
+    if(use_hugepages)
+      madvise(base, region_size, MADV_HUGEPAGE);
+  }
+
+  region_ = new ArenaRegion();
+  region_->base = base;
+  region_->size = region_size;
+  region_->hugepages = hugepages;
+  region_->locked = lock_memory && mlock(base, region_size) == 0;
+  region_->refs = 1;
+
+  char *slot = static_cast<char*>(base);
+  for(size_t i = 0; i < n_buffers; i++, slot += slot_size){
+    region_->refs++;
+    buffers_.push_back(arv_buffer_new_full(payload, slot, region_, region_unref));
+  }
+
+  payload_ = payload;
+  hugepages_requested_ = use_hugepages;
+  lock_requested_ = lock_memory;
+  return true;
+}
+
+/** @brief Checks whether the current buffers can be reused for a new stream
+ *
+ * @return true if the arena holds n_buffers buffers of payload bytes allocated with the same options
+ */
+bool BufferArena::matches(size_t payload, size_t n_buffers, bool use_hugepages, bool lock_memory) const
+{
+  return region_ != NULL && payload_ == payload && buffers_.size() == n_buffers &&
+         hugepages_requested_ == use_hugepages && lock_requested_ == lock_memory;
+}
+
+/** @brief Drops the arena's references to its buffers and region
+ *
+ * Memory still used by a stream or a downstream frame stays mapped until that
+ * buffer is finalised.
+ */
+void BufferArena::release()
+{
+  for(ArvBuffer *buffer : buffers_)
+    g_object_unref(buffer);
+  buffers_.clear();
+
+  if(region_ != NULL){
+    region_unref(region_);
+    region_ = NULL;
+  }
+  payload_ = 0;
+}
+
+/** @brief Buffers cut from the region, still owned by the arena */
+const std::vector<ArvBuffer*>& BufferArena::buffers() const
+{
+  return buffers_;
+}
+
+/** @brief Size of the mapped region in bytes, 0 when nothing is allocated */
+size_t BufferArena::mapped_bytes() const
+{
+  return region_ ? region_->size : 0;
+}
+
+/** @brief Is the region mapped on hugepages? */
+bool BufferArena::on_hugepages() const
+{
+  return region_ && region_->hugepages;
+}
+
+/** @brief Is the region locked into RAM? */
+bool BufferArena::locked() const
+{
+  return region_ && region_->locked;
+}
+
+} // namespace FrameProcessor
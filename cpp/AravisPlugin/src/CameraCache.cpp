@@ -0,0 +1,200 @@
+/**
+ * @file CameraCache.cpp
+ * @brief On disk cache of each camera's description and last applied configuration
+ * @date 2026-10-15
+ */
+
+#include "CameraCache.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace FrameProcessor
+{
+
+/** @brief Path of the state file of a camera */
+std::string CameraCache::state_path(const std::string& directory, const std::string& serial)
+{
+  return directory + "/" + serial + ".state";
+}
+
+/** @brief Creates the cache directory if it does not exist yet */
+bool CameraCache::make_directory(const std::string& directory, std::string& error)
+{
+  if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST){
+    error = "Failed to create camera cache directory " + directory + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+/** @brief Reads the cached state of a camera
+ *
+ * @param directory cache directory
+ * @param serial serial number of the camera
+ * @param[out] state cached state
+ * @param[out] error description of the failure
+ * @return false if there is no usable state for this camera
+ */
+bool CameraCache::load(const std::string& directory, const std::string& serial, CameraState& state, std::string& error)
+{
+  std::string path = state_path(directory, serial);
+  std::ifstream file(path.c_str());
+  if(!file){
+    error = "No cached state for camera " + serial;
+    return false;
+  }
+
+  state = CameraState();
+  std::string line;
+  try{
+    while(std::getline(file, line)){
+      std::istringstream fields(line);
+      std::string key;
+      if(!std::getline(fields, key, '\t'))
+        continue;
+      std::string rest;
+      std::getline(fields, rest);
+
+      if(key == "serial")                 state.serial = rest;
+      else if(key == "model")             state.model = rest;
+      else if(key == "id")                state.id = rest;
+      else if(key == "exposure_bounds")   std::istringstream(rest) >> state.min_exposure_time >> state.max_exposure_time;
+      else if(key == "exposure_time_us")  state.exposure_time_us = std::stod(rest);
+      else if(key == "frame_rate_bounds") std::istringstream(rest) >> state.min_frame_rate >> state.max_frame_rate;
+      else if(key == "frame_rate_hz")     state.frame_rate_hz = std::stod(rest);
+      else if(key == "available_format")  state.pixel_formats.push_back(rest);
+      else if(key == "pixel_format")      state.pixel_format = rest;
+      else if(key == "acquisition_mode")  state.acquisition_mode = rest;
+      else if(key == "width")             state.width = std::stoi(rest);
+      else if(key == "height")            state.height = std::stoi(rest);
+      else if(key == "payload")           state.payload = std::stoul(rest);
+      else if(key == "feature"){
+        // feature<TAB>name<TAB>kind<TAB>value
+        std::istringstream feature(rest);
+        std::string name, kind, value;
+        std::getline(feature, name, '\t');
+        std::getline(feature, kind, '\t');
+        std::getline(feature, value);
+        FeatureTable::Input input;
+        input.kind = FeatureTable::Input::INPUT_TEXT;
+        input.integer = 0;
+        input.number = 0;
+        input.boolean = false;
+        if(kind == "integer"){      input.kind = FeatureTable::Input::INPUT_INTEGER; input.integer = std::stoll(value); }
+        else if(kind == "number"){  input.kind = FeatureTable::Input::INPUT_NUMBER;  input.number = std::stod(value); }
+        else if(kind == "boolean"){ input.kind = FeatureTable::Input::INPUT_BOOLEAN; input.boolean = value == "1"; }
+        else                        input.text = value;
+        state.features.push_back(std::make_pair(name, input));
+      }
+    }
+  }
+  catch(std::exception& e){
+    error = "Failed to parse camera cache file " + path + ": " + e.what();
+    return false;
+  }
+
+  if(state.serial != serial || state.pixel_format.empty() || state.width <= 0 || state.height <= 0){
+    error = "The cached state for camera " + serial + " in " + path + " is incomplete";
+    return false;
+  }
+  return true;
+}
+
+/** @brief Writes the state of a camera, replacing any previous one
+ *
+ * @param directory cache directory, created if needed
+ * @param state state to save
+ * @param[out] error description of the failure
+ * @return false if the state could not be written
+ */
+bool CameraCache::save(const std::string& directory, const CameraState& state, std::string& error)
+{
+  if(state.serial.empty()){
+    error = "Cannot cache the state of a camera without a serial number";
+    return false;
+  }
+  if(!make_directory(directory, error))
+    return false;
+
+  std::string path = state_path(directory, state.serial);
+  std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path.c_str());
+    if(!file){
+      error = "Failed to write camera cache file " + temp_path + ": " + std::strerror(errno);
+      return false;
+    }
+    file << std::setprecision(17);
+    file << "serial\t" << state.serial << "\n";
+    file << "model\t" << state.model << "\n";
+    file << "id\t" << state.id << "\n";
+    file << "exposure_bounds\t" << state.min_exposure_time << " " << state.max_exposure_time << "\n";
+    file << "exposure_time_us\t" << state.exposure_time_us << "\n";
+    file << "frame_rate_bounds\t" << state.min_frame_rate << " " << state.max_frame_rate << "\n";
+    file << "frame_rate_hz\t" << state.frame_rate_hz << "\n";
+    for(const std::string& format : state.pixel_formats)
+      file << "available_format\t" << format << "\n";
+    file << "pixel_format\t" << state.pixel_format << "\n";
+    file << "acquisition_mode\t" << state.acquisition_mode << "\n";
+    file << "width\t" << state.width << "\n";
+    file << "height\t" << state.height << "\n";
+    file << "payload\t" << state.payload << "\n";
+    for(const std::pair<std::string, FeatureTable::Input>& feature : state.features){
+      const FeatureTable::Input& input = feature.second;
+      file << "feature\t" << feature.first << "\t";
+      switch(input.kind){
+        case FeatureTable::Input::INPUT_INTEGER: file << "integer\t" << input.integer; break;
+        case FeatureTable::Input::INPUT_NUMBER:  file << "number\t" << input.number;   break;
+        case FeatureTable::Input::INPUT_BOOLEAN: file << "boolean\t" << input.boolean; break;
+        case FeatureTable::Input::INPUT_TEXT:    file << "text\t" << input.text;       break;
+      }
+      file << "\n";
+    }
+    if(!file.flush()){
+      error = "Failed to write camera cache file " + temp_path;
+      return false;
+    }
+  }
+
+  if(std::rename(temp_path.c_str(), path.c_str()) != 0){
+    error = "Failed to replace camera cache file " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  return true;
+}
+
+/** @brief Keeps a copy of a camera's GenICam description next to its state
+ *
+ * @param directory cache directory, created if needed
+ * @param serial serial number of the camera
+ * @param xml GenICam XML as downloaded from the camera
+ * @param length length of the XML in bytes
+ * @param[out] error description of the failure
+ * @return false if the file could not be written
+ */
+bool CameraCache::save_xml(const std::string& directory, const std::string& serial, const char *xml, size_t length, std::string& error)
+{
+  if(xml == NULL){
+    error = "No GenICam XML to cache for camera " + serial;
+    return false;
+  }
+  if(!make_directory(directory, error))
+    return false;
+
+  std::string path = directory + "/" + serial + ".xml";
+  std::ofstream file(path.c_str(), std::ios::binary);
+  file.write(xml, length);
+  if(!file){
+    error = "Failed to write " + path;
+    return false;
+  }
+  return true;
+}
+
+} // namespace FrameProcessor
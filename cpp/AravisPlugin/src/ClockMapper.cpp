@@ -0,0 +1,188 @@
+/**
+ * @file ClockMapper.cpp
+ * @brief Online estimate of the camera clock's offset and drift against the host clock
+ * @date 2026-10-15
+ */
+
+#include "ClockMapper.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace FrameProcessor
+{
+
+ClockMapper::ClockMapper() :
+  weight_(1.0 / 1000),
+  block_size_(1),
+  resets_(0)
+{
+  reset();
+}
+
+/** @brief Sets the number of frames the fit is averaged over, applied from the next pair
+ *
+ * The window is split into WINDOW_BLOCKS blocks, each giving the fit one point.
+ */
+void ClockMapper::set_window(size_t window)
+{
+  window = std::max<size_t>(window, 2);
+  block_size_ = std::max<size_t>(window / WINDOW_BLOCKS, 1);
+  weight_ = 1.0 / std::max<size_t>(window / block_size_, 2);
+}
+
+/** @brief Drops the fit, its counters included */
+void ClockMapper::reset()
+{
+  camera0_ = 0;
+  system0_ = 0;
+  last_camera_ = 0;
+  sum_weights_ = 0;
+  mean_x_ = 0;
+  mean_y_ = 0;
+  var_x_ = 0;
+  cov_xy_ = 0;
+  mean_r2_ = 0;
+  max_residual_ = 0;
+  last_x_ = 0;
+  block_pairs_ = 0;
+  block_x_ = 0;
+  block_y_ = 0;
+  samples_ = 0;
+  minima_ = 0;
+  outliers_ = 0;
+  consecutive_outliers_ = 0;
+}
+
+/** @brief Starts a new fit from one pair */
+void ClockMapper::restart(uint64_t camera_ns, uint64_t system_ns)
+{
+  uint64_t resets = resets_;
+  reset();
+  resets_ = resets;
+  camera0_ = camera_ns;
+  system0_ = system_ns;
+}
+
+/** @brief Offset from the first pair predicted by the fit at camera time x, in ns */
+double ClockMapper::predict(double x) const
+{
+  double slope = var_x_ > 0 ? cov_xy_ / var_x_ : 0;
+  return mean_y_ + slope * (x - mean_x_);
+}
+
+/** @brief Adds a pair of timestamps of one frame
+ *
+ * @param camera_ns camera time the image was taken
+ * @param system_ns host time the image was received
+ */
+void ClockMapper::add(uint64_t camera_ns, uint64_t system_ns)
+{
+  if(camera_ns == 0 || system_ns == 0)
+    return;
+
+  if(samples_ == 0 || camera_ns < last_camera_){
+    if(samples_ != 0)
+      resets_++;
+    restart(camera_ns, system_ns);
+  }
+
+  int64_t camera_delta = static_cast<int64_t>(camera_ns - camera0_);
+  double x = camera_delta * 1e-9;
+  double y = static_cast<double>(static_cast<int64_t>(system_ns - system0_) - camera_delta);
+
+  if(minima_ >= MIN_MINIMA && std::fabs(y - predict(x)) > RESET_NS){
+    resets_++;
+    restart(camera_ns, system_ns);
+    x = 0;
+    y = 0;
+  }
+
+  // the pair with the lowest offset in a block is the one delayed least
+  if(block_pairs_ == 0 || y < block_y_){
+    block_x_ = x;
+    block_y_ = y;
+  }
+  last_camera_ = camera_ns;
+  last_x_ = x;
+  samples_++;
+  if(++block_pairs_ < block_size_)
+    return;
+  block_pairs_ = 0;
+
+  // a block whose quickest pair is still well above the fit is skipped, once a full
+  // window has settled the fit; a window of them in a row means the host clock was
+  // stepped and starts a new fit from this pair
+  double window_minima = 1 / weight_;
+  if(minima_ >= window_minima){
+    double residual = block_y_ - predict(block_x_);
+    if(residual > std::max(4 * std::sqrt(mean_r2_), static_cast<double>(MIN_OUTLIER_NS))){
+      outliers_++;
+      if(++consecutive_outliers_ < window_minima)
+        return;
+      resets_++;
+      restart(camera_ns, system_ns);
+      last_camera_ = camera_ns;
+      samples_ = 1;
+      block_x_ = 0;
+      block_y_ = 0;
+    }
+  }
+  consecutive_outliers_ = 0;
+  fit(block_x_, block_y_);
+}
+
+/** @brief Adds the quickest pair of a block to the fit
+ *
+ * @param x camera time, in seconds from camera0_
+ * @param y offset from the first pair, in ns
+ */
+void ClockMapper::fit(double x, double y)
+{
+  // exponentially weighted mean and covariance, updated in place
+  sum_weights_ = sum_weights_ * (1 - weight_) + 1;
+  double w = std::max(weight_, 1 / sum_weights_);
+  if(minima_ >= MIN_MINIMA){
+    double residual = y - predict(x);
+    mean_r2_ = (1 - w) * mean_r2_ + w * residual * residual;
+    max_residual_ = std::max(max_residual_, std::fabs(residual));
+  }
+  double dx = x - mean_x_;
+  double dy = y - mean_y_;
+  mean_x_ += w * dx;
+  mean_y_ += w * dy;
+  var_x_ = (1 - w) * (var_x_ + w * dx * dx);
+  cov_xy_ = (1 - w) * (cov_xy_ + w * dx * dy);
+  minima_++;
+}
+
+/** @brief Host time at which the camera took an image
+ *
+ * @param camera_ns camera time the image was taken
+ * @return host time in ns, 0 while there are not enough pairs
+ */
+uint64_t ClockMapper::map(uint64_t camera_ns) const
+{
+  if(minima_ < MIN_MINIMA || camera_ns == 0)
+    return 0;
+  int64_t camera_delta = static_cast<int64_t>(camera_ns - camera0_);
+  return system0_ + camera_delta + static_cast<int64_t>(std::llround(predict(camera_delta * 1e-9)));
+}
+
+/** @brief Current state of the fit */
+ClockMapper::Estimate ClockMapper::estimate() const
+{
+  Estimate estimate;
+  estimate.ready = minima_ >= MIN_MINIMA;
+  estimate.offset_ns = static_cast<int64_t>(system0_ - camera0_) + static_cast<int64_t>(std::llround(predict(last_x_)));
+  // the slope is in ns of offset per second of camera time, 1000 ns/s is 1 ppm
+  estimate.drift_ppm = var_x_ > 0 ? cov_xy_ / var_x_ / 1000 : 0;
+  estimate.jitter_ns = std::sqrt(mean_r2_);
+  estimate.max_residual_ns = max_residual_;
+  estimate.samples = samples_;
+  estimate.outliers = outliers_;
+  estimate.resets = resets_;
+  return estimate;
+}
+
+} // namespace FrameProcessor
@@ -0,0 +1,293 @@
+/**
+ * @file FeatureTable.cpp
+ * @brief Cached GenICam feature nodes, resolved once per camera connection
+ * @date 2026-10-15
+ */
+
+#include "FeatureTable.h"
+
+#include <cmath>
+
+namespace FrameProcessor
+{
+
+/** @brief Moves a GError into an error string
+ *
+ * @return true if there was an error
+ */
+static bool take_error(GError *gerror, const std::string& what, std::string& error)
+{
+  if(gerror == NULL)
+    return false;
+  error = what + ": " + gerror->message;
+  g_error_free(gerror);
+  return true;
+}
+
+FeatureTable::FeatureTable() :
+  device_(NULL)
+{
+}
+
+/** @brief Drops every resolved node and binds the table to a new device
+ *
+ * @param device device of the connected camera, NULL when disconnected
+ */
+void FeatureTable::reset(ArvDevice *device)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  device_ = device;
+  entries_.clear();
+  index_.clear();
+}
+
+/** @brief Finds a feature in the table, looking its node up on first use
+ *
+ * A newly resolved feature is read once so its value and bounds are known.
+ *
+ * @param name GenICam feature name
+ * @param[out] error description of the failure
+ * @return position of the feature in the table, -1 if it does not exist or is not supported
+ */
+int FeatureTable::resolve(const std::string& name, std::string& error)
+{
+  Entry entry;
+  int index;
+  {
+    // held from the lookup to the insert so a name is only ever added once
+    boost::mutex::scoped_lock lock(mutex_);
+    std::unordered_map<std::string, int>::const_iterator found = index_.find(name);
+    if(found != index_.end())
+      return found->second;
+
+    if(device_ == NULL){
+      error = "Cannot access feature " + name + " without connecting to a camera";
+      return -1;
+    }
+
+    ArvGcNode *node = arv_device_get_feature(device_, name.c_str());
+    if(node == NULL){
+      error = "The camera has no feature " + name;
+      return -1;
+    }
+
+    entry.node = node;
+    entry.value.name = name;
+    entry.value.known = false;
+    entry.value.integer = 0;
+    entry.value.number = 0;
+    entry.value.boolean = false;
+    entry.value.min = 0;
+    entry.value.max = 0;
+    if(ARV_IS_GC_ENUMERATION(node))      entry.value.type = FEATURE_ENUMERATION;
+    else if(ARV_IS_GC_INTEGER(node))     entry.value.type = FEATURE_INTEGER;
+    else if(ARV_IS_GC_FLOAT(node))       entry.value.type = FEATURE_FLOAT;
+    else if(ARV_IS_GC_BOOLEAN(node))     entry.value.type = FEATURE_BOOLEAN;
+    else if(ARV_IS_GC_STRING(node))      entry.value.type = FEATURE_STRING;
+    else if(ARV_IS_GC_COMMAND(node))     entry.value.type = FEATURE_COMMAND;
+    else{
+      error = "The feature " + name + " is not a value or command node";
+      return -1;
+    }
+
+    index = static_cast<int>(entries_.size());
+    entries_.push_back(entry);
+    index_[name] = index;
+  }
+
+  if(entry.value.type != FEATURE_COMMAND && !read(index, error))
+    return -1;
+  return index;
+}
+
+/** @brief Reads the value, and the bounds of a numeric feature, from the camera
+ *
+ * @param index position returned by resolve()
+ * @param[out] error description of the failure
+ * @return false if the camera could not be read
+ */
+bool FeatureTable::read(int index, std::string& error)
+{
+  Entry entry;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    // the table may have been reset since the feature was resolved
+    if(index < 0 || index >= static_cast<int>(entries_.size())){
+      error = "The feature table was reset, the camera was disconnected";
+      return false;
+    }
+    entry = entries_[index];
+  }
+
+  GError *gerror = NULL;
+  Value& value = entry.value;
+  switch(value.type){
+    case FEATURE_INTEGER:
+      value.integer = arv_gc_integer_get_value(ARV_GC_INTEGER(entry.node), &gerror);
+      if(gerror == NULL) value.min = arv_gc_integer_get_min(ARV_GC_INTEGER(entry.node), &gerror);
+      if(gerror == NULL) value.max = arv_gc_integer_get_max(ARV_GC_INTEGER(entry.node), &gerror);
+      break;
+    case FEATURE_FLOAT:
+      value.number = arv_gc_float_get_value(ARV_GC_FLOAT(entry.node), &gerror);
+      if(gerror == NULL) value.min = arv_gc_float_get_min(ARV_GC_FLOAT(entry.node), &gerror);
+      if(gerror == NULL) value.max = arv_gc_float_get_max(ARV_GC_FLOAT(entry.node), &gerror);
+      break;
+    case FEATURE_BOOLEAN:
+      value.boolean = arv_gc_boolean_get_value(ARV_GC_BOOLEAN(entry.node), &gerror);
+      break;
+    case FEATURE_ENUMERATION: {
+      const char *text = arv_gc_enumeration_get_string_value(ARV_GC_ENUMERATION(entry.node), &gerror);
+      value.text = text ? text : "";
+      break;
+    }
+    case FEATURE_STRING: {
+      const char *text = arv_gc_string_get_value(ARV_GC_STRING(entry.node), &gerror);
+      value.text = text ? text : "";
+      break;
+    }
+    case FEATURE_COMMAND:
+      return true;
+  }
+
+  if(take_error(gerror, "When reading feature " + value.name, error))
+    return false;
+
+  value.known = true;
+  boost::mutex::scoped_lock lock(mutex_);
+  if(index < static_cast<int>(entries_.size()) && entries_[index].node == entry.node)
+    entries_[index].value = value;
+  return true;
+}
+
+/** @brief Writes a value to a feature and reads back what the camera applied
+ *
+ * Numbers are checked against the bounds of the last read, and must match the
+ * feature's type: integers are accepted by float features, but integer features
+ * only accept whole numbers. A command feature is executed by writing true.
+ *
+ * @param index position returned by resolve()
+ * @param input value to write
+ * @param[out] error description of the failure
+ * @return false if the value was rejected or could not be written
+ */
+bool FeatureTable::write(int index, const Input& input, std::string& error)
+{
+  Entry entry;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    // the table may have been reset since the feature was resolved
+    if(index < 0 || index >= static_cast<int>(entries_.size())){
+      error = "The feature table was reset, the camera was disconnected";
+      return false;
+    }
+    entry = entries_[index];
+  }
+  const Value& value = entry.value;
+
+  double number = 0;
+  bool numeric = true;
+  if(input.kind == Input::INPUT_INTEGER)     number = static_cast<double>(input.integer);
+  else if(input.kind == Input::INPUT_NUMBER) number = input.number;
+  else numeric = false;
+
+  bool accepted = false;
+  switch(value.type){
+    case FEATURE_INTEGER:
+      accepted = numeric && number == std::floor(number);
+      break;
+    case FEATURE_FLOAT:
+      accepted = numeric;
+      break;
+    case FEATURE_BOOLEAN:
+    case FEATURE_COMMAND:
+      accepted = input.kind == Input::INPUT_BOOLEAN;
+      break;
+    case FEATURE_ENUMERATION:
+    case FEATURE_STRING:
+      accepted = input.kind == Input::INPUT_TEXT;
+      break;
+  }
+  if(!accepted){
+    error = "The feature " + value.name + " takes a value of type " + type_name(value.type);
+    return false;
+  }
+  if(numeric && value.known && (number < value.min || number > value.max)){
+    error = "The value for feature " + value.name + " is out of bounds: min=" +
+            std::to_string(value.min) + " max=" + std::to_string(value.max);
+    return false;
+  }
+
+  GError *gerror = NULL;
+  switch(value.type){
+    case FEATURE_INTEGER:
+      arv_gc_integer_set_value(ARV_GC_INTEGER(entry.node),
+        input.kind == Input::INPUT_INTEGER ? input.integer : static_cast<gint64>(number), &gerror);
+      break;
+    case FEATURE_FLOAT:
+      arv_gc_float_set_value(ARV_GC_FLOAT(entry.node), number, &gerror);
+      break;
+    case FEATURE_BOOLEAN:
+      arv_gc_boolean_set_value(ARV_GC_BOOLEAN(entry.node), input.boolean, &gerror);
+      break;
+    case FEATURE_ENUMERATION:
+      arv_gc_enumeration_set_string_value(ARV_GC_ENUMERATION(entry.node), input.text.c_str(), &gerror);
+      break;
+    case FEATURE_STRING:
+      arv_gc_string_set_value(ARV_GC_STRING(entry.node), input.text.c_str(), &gerror);
+      break;
+    case FEATURE_COMMAND:
+      if(input.boolean)
+        arv_gc_command_execute(ARV_GC_COMMAND(entry.node), &gerror);
+      return !take_error(gerror, "When executing feature " + value.name, error);
+  }
+
+  if(take_error(gerror, "When writing feature " + value.name, error))
+    return false;
+  return read(index, error);
+}
+
+/** @brief Number of resolved features */
+size_t FeatureTable::size() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return entries_.size();
+}
+
+/** @brief Type of a resolved feature
+ *
+ * @return false if index is not in the table
+ */
+bool FeatureTable::type(int index, Type& type) const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  if(index < 0 || index >= static_cast<int>(entries_.size()))
+    return false;
+  type = entries_[index].value.type;
+  return true;
+}
+
+/** @brief Copies the cached state of every resolved feature, without touching the camera */
+void FeatureTable::snapshot(std::vector<Value>& values) const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  values.clear();
+  values.reserve(entries_.size());
+  for(const Entry& entry : entries_)
+    values.push_back(entry.value);
+}
+
+/** @brief Name of a feature type, as used in error messages */
+const char *FeatureTable::type_name(Type type)
+{
+  switch(type){
+    case FEATURE_INTEGER:     return "integer";
+    case FEATURE_FLOAT:       return "float";
+    case FEATURE_BOOLEAN:     return "boolean";
+    case FEATURE_ENUMERATION: return "enumeration";
+    case FEATURE_STRING:      return "string";
+    case FEATURE_COMMAND:     return "command";
+  }
+  return "unknown";
+}
+
+} // namespace FrameProcessor
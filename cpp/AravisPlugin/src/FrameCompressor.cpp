@@ -0,0 +1,294 @@
+/**
+ * @file FrameCompressor.cpp
+ * @brief Pool of threads compressing frames with Blosc, delivering them in order
+ * @date 2026-10-15
+ */
+
+#include "FrameCompressor.h"
+#include "DataBlockFrame.h"
+
+#include <time.h>
+
+#ifdef HAVE_BLOSC
+#include <blosc.h>
+#endif
+
+namespace FrameProcessor
+{
+
+/** @brief Monotonic clock in nanoseconds, for compression times */
+static uint64_t monotonic_ns()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+FrameCompressor::FrameCompressor() :
+  shuffle_(0),
+  level_(0),
+  stopping_(false),
+  next_sequence_(0),
+  next_output_(0),
+  delivering_(false),
+  max_in_flight_(0)
+{
+  reset_statistics();
+}
+
+FrameCompressor::~FrameCompressor()
+{
+  stop();
+}
+
+/** @brief Was the plugin built with Blosc? */
+bool FrameCompressor::available()
+{
+#ifdef HAVE_BLOSC
+  return true;
+#else
+  return false;
+#endif
+}
+
+/** @brief Checks compression settings without starting anything
+ *
+ * @param codec Blosc compressor: blosclz, lz4, lz4hc, zlib or zstd
+ * @param shuffle none, byte or bit
+ * @param level 0 (no compression) to 9
+ * @param[out] error description of the invalid setting
+ * @return false if a setting is invalid
+ */
+bool FrameCompressor::check_settings(const std::string& codec, const std::string& shuffle, int level, std::string& error)
+{
+  if(codec != "blosclz" && codec != "lz4" && codec != "lz4hc" && codec != "zlib" && codec != "zstd"){
+    error = "Unknown compression codec " + codec + ", expected blosclz, lz4, lz4hc, zlib or zstd";
+    return false;
+  }
+  if(shuffle != "none" && shuffle != "byte" && shuffle != "bit"){
+    error = "Unknown compression shuffle " + shuffle + ", expected none, byte or bit";
+    return false;
+  }
+  if(level < 0 || level > 9){
+    error = "Compression level must be between 0 and 9";
+    return false;
+  }
+  return true;
+}
+
+/** @brief Starts the workers, after delivering any frames still in flight
+ *
+ * @param n_threads number of worker threads
+ * @param codec Blosc compressor name
+ * @param shuffle none, byte or bit
+ * @param level 0 to 9
+ * @param sink receives the frames in submission order
+ * @param[out] error description of the failure
+ * @return false if the settings are invalid or the plugin was built without Blosc
+ */
+bool FrameCompressor::start(unsigned int n_threads, const std::string& codec, const std::string& shuffle, int level, Sink sink, std::string& error)
+{
+  stop();
+  if(!available()){
+    error = "Compression in the plugin needs it to be built with Blosc";
+    return false;
+  }
+  if(n_threads == 0){
+    error = "Compression needs at least one thread";
+    return false;
+  }
+  if(!check_settings(codec, shuffle, level, error))
+    return false;
+
+#ifdef HAVE_BLOSC
+  shuffle_ = shuffle == "bit" ? BLOSC_BITSHUFFLE : shuffle == "byte" ? BLOSC_SHUFFLE : BLOSC_NOSHUFFLE;
+#endif
+  codec_ = codec;
+  level_ = level;
+  sink_ = sink;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    stopping_ = false;
+    next_sequence_ = 0;
+    next_output_ = 0;
+    max_in_flight_ = 2 * n_threads;
+  }
+  for(unsigned int i = 0; i < n_threads; i++)
+    workers_.push_back(new boost::thread(&FrameCompressor::worker_task, this));
+  return true;
+}
+
+/** @brief Waits for every submitted frame to be delivered, then stops the workers */
+void FrameCompressor::stop()
+{
+  if(workers_.empty())
+    return;
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    while(next_output_ != next_sequence_)
+      done_cond_.wait(lock);
+    stopping_ = true;
+  }
+  jobs_cond_.notify_all();
+  for(boost::thread *worker : workers_){
+    worker->join();
+    delete worker;
+  }
+  workers_.clear();
+  sink_.clear();
+}
+
+/** @brief Are the workers running? Only changes with start() and stop() */
+bool FrameCompressor::running() const
+{
+  return !workers_.empty();
+}
+
+/** @brief Queues a frame for compression, waiting while too many are in flight */
+void FrameCompressor::submit(boost::shared_ptr<Frame> frame)
+{
+  {
+    boost::mutex::scoped_lock lock(mutex_);
+    while(next_sequence_ - next_output_ >= max_in_flight_)
+      done_cond_.wait(lock);
+    Job job = {next_sequence_++, frame};
+    jobs_.push_back(job);
+  }
+  jobs_cond_.notify_one();
+}
+
+/** @brief Worker thread, compresses frames until stopped */
+void FrameCompressor::worker_task()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  while(true){
+    if(jobs_.empty()){
+      if(stopping_)
+        return;
+      jobs_cond_.wait(lock);
+      continue;
+    }
+    Job job = jobs_.front();
+    jobs_.pop_front();
+    lock.unlock();
+
+    uint64_t start = monotonic_ns();
+    bool compressed = false;
+    size_t bytes_in = job.frame->get_image_size();
+    boost::shared_ptr<Frame> output = compress(job.frame, compressed);
+    uint64_t elapsed = monotonic_ns() - start;
+    // drop our reference so a zero copy buffer goes back to the stream now
+    job.frame.reset();
+
+    lock.lock();
+    if(compressed){
+      stats_.frames++;
+      stats_.bytes_in += bytes_in;
+      stats_.bytes_out += output->get_image_size();
+      compress_time_.record(elapsed);
+    }else{
+      stats_.failures++;
+    }
+    lock.unlock();
+
+    deliver(job.sequence, output);
+    lock.lock();
+  }
+}
+
+/** @brief Compresses the image of a frame into a new frame
+ *
+ * The new frame has the meta data of the original with the blosc compression type,
+ * and only the compressed image as its data.
+ *
+ * @param frame frame to compress
+ * @param[out] compressed false if the original frame is returned instead
+ * @return the compressed frame, or the original one if compression failed
+ */
+boost::shared_ptr<Frame> FrameCompressor::compress(const boost::shared_ptr<Frame>& frame, bool& compressed)
+{
+  compressed = false;
+#ifdef HAVE_BLOSC
+  FrameMetaData meta_data = frame->get_meta_data_copy();
+  size_t type_size = meta_data.get_data_type() == raw_unknown ? 1 : get_size_from_enum(meta_data.get_data_type());
+  if(type_size == 0)
+    type_size = 1;
+
+  size_t image_size = frame->get_image_size();
+  size_t capacity = image_size + BLOSC_MAX_OVERHEAD;
+  meta_data.set_compression_type(blosc);
+  boost::shared_ptr<DataBlockFrame> output(new DataBlockFrame(meta_data, capacity));
+
+  int compressed_size = blosc_compress_ctx(level_, shuffle_, type_size, image_size, frame->get_image_ptr(),
+                                           output->get_data_ptr(), capacity, codec_.c_str(), 0, 1);
+  if(compressed_size <= 0)
+    return frame;
+
+  output->set_data_size(compressed_size);
+  output->set_image_size(compressed_size);
+  compressed = true;
+  return output;
+#else
+  return frame;
+#endif
+}
+
+/** @brief Hands a finished frame, and any ready after it, to the sink in order
+ *
+ * The first worker to find the next frame ready delivers the whole run; others only
+ * leave their frame in done_.
+ */
+void FrameCompressor::deliver(uint64_t sequence, boost::shared_ptr<Frame> frame)
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  done_[sequence] = frame;
+  if(delivering_)
+    return;
+
+  delivering_ = true;
+  std::map<uint64_t, boost::shared_ptr<Frame> >::iterator next;
+  while((next = done_.find(next_output_)) != done_.end()){
+    boost::shared_ptr<Frame> ready = next->second;
+    done_.erase(next);
+    lock.unlock();
+    sink_(ready);
+    ready.reset();
+    lock.lock();
+    next_output_++;
+    done_cond_.notify_all();
+  }
+  delivering_ = false;
+}
+
+/** @brief Totals since the last reset */
+FrameCompressor::Stats FrameCompressor::stats() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return stats_;
+}
+
+/** @brief Frames submitted but not yet handed to the sink */
+size_t FrameCompressor::in_flight() const
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  return next_sequence_ - next_output_;
+}
+
+/** @brief Histogram of the time taken to compress each frame, in ns */
+const LatencyHistogram& FrameCompressor::compress_time() const
+{
+  return compress_time_;
+}
+
+/** @brief Clears the totals and the compression time histogram */
+void FrameCompressor::reset_statistics()
+{
+  boost::mutex::scoped_lock lock(mutex_);
+  stats_.frames = 0;
+  stats_.bytes_in = 0;
+  stats_.bytes_out = 0;
+  stats_.failures = 0;
+  compress_time_.reset();
+}
+
+} // namespace FrameProcessor
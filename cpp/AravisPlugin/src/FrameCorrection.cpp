@@ -0,0 +1,278 @@
+/**
+ * @file FrameCorrection.cpp
+ * @brief Kernels applying dark frame subtraction and flat field correction to 8 and 16 bit pixels
+ * @date 2026-10-15
+ *
+ * The vector kernels widen the pixels to 32 bit integers and then to floats,
+ * subtract the dark and multiply by the gain a whole register at a time, clamp to
+ * the top of the pixel range (cvtps_epi32 would wrap larger values) and narrow back
+ * with the saturating packs, which also turn negative results into 0. Pixels left
+ * over at the end of a frame are finished by the scalar kernel.
+ */
+
+#include "FrameCorrection.h"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FRAME_CORRECTION_X86
+#include <immintrin.h>
+#endif
+
+namespace FrameProcessor
+{
+
+/*********************************
+**        Scalar kernels        **
+**********************************/
+
+template <class Pixel>
+static void correct_scalar(const void *src, void *dst, const float *dark, const float *gain, size_t n_pixels)
+{
+  const Pixel *in = static_cast<const Pixel*>(src);
+  Pixel *out = static_cast<Pixel*>(dst);
+  const float top = std::numeric_limits<Pixel>::max();
+  for(size_t i = 0; i < n_pixels; i++){
+    float value = (in[i] - dark[i]) * gain[i];
+    value = value < 0 ? 0 : value > top ? top : value;
+    out[i] = static_cast<Pixel>(std::nearbyint(value));
+  }
+}
+
+#ifdef FRAME_CORRECTION_X86
+
+/*********************************
+**        SSE4.1 kernels        **
+**********************************/
+
+/** @brief Corrects 4 pixels widened to 32 bit, returning them as 32 bit integers */
+__attribute__((target("sse4.1")))
+static inline __m128i correct_4px(__m128i pixels, const float *dark, const float *gain, __m128 top)
+{
+  __m128 value = _mm_sub_ps(_mm_cvtepi32_ps(pixels), _mm_loadu_ps(dark));
+  value = _mm_min_ps(_mm_mul_ps(value, _mm_loadu_ps(gain)), top);
+  return _mm_cvtps_epi32(value);
+}
+
+__attribute__((target("sse4.1")))
+static void correct_8bit_sse41(const void *src, void *dst, const float *dark, const float *gain, size_t n_pixels)
+{
+  const uint8_t *in = static_cast<const uint8_t*>(src);
+  uint8_t *out = static_cast<uint8_t*>(dst);
+  const __m128 top = _mm_set1_ps(255);
+
+  size_t i = 0;
+  for(; i + 8 <= n_pixels; i += 8){
+    __m128i pixels = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+    __m128i low = correct_4px(_mm_cvtepu8_epi32(pixels), dark + i, gain + i, top);
+    __m128i high = correct_4px(_mm_cvtepu8_epi32(_mm_srli_si128(pixels, 4)), dark + i + 4, gain + i + 4, top);
+    __m128i words = _mm_packus_epi32(low, high);
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(words, words));
+  }
+  correct_scalar<uint8_t>(in + i, out + i, dark + i, gain + i, n_pixels - i);
+}
+
+__attribute__((target("sse4.1")))
+static void correct_16bit_sse41(const void *src, void *dst, const float *dark, const float *gain, size_t n_pixels)
+{
+  const uint16_t *in = static_cast<const uint16_t*>(src);
+  uint16_t *out = static_cast<uint16_t*>(dst);
+  const __m128 top = _mm_set1_ps(65535);
+
+  size_t i = 0;
+  for(; i + 8 <= n_pixels; i += 8){
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i low = correct_4px(_mm_cvtepu16_epi32(pixels), dark + i, gain + i, top);
+    __m128i high = correct_4px(_mm_cvtepu16_epi32(_mm_srli_si128(pixels, 8)), dark + i + 4, gain + i + 4, top);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi32(low, high));
+  }
+  correct_scalar<uint16_t>(in + i, out + i, dark + i, gain + i, n_pixels - i);
+}
+
+/*********************************
+**         AVX2 kernels         **
+**********************************/
+
+/** @brief Corrects 8 pixels widened to 32 bit, returning them as 32 bit integers */
+__attribute__((target("avx2")))
+static inline __m256i correct_8px(__m256i pixels, const float *dark, const float *gain, __m256 top)
+{
+  __m256 value = _mm256_sub_ps(_mm256_cvtepi32_ps(pixels), _mm256_loadu_ps(dark));
+  value = _mm256_min_ps(_mm256_mul_ps(value, _mm256_loadu_ps(gain)), top);
+  return _mm256_cvtps_epi32(value);
+}
+
+__attribute__((target("avx2")))
+static void correct_8bit_avx2(const void *src, void *dst, const float *dark, const float *gain, size_t n_pixels)
+{
+  const uint8_t *in = static_cast<const uint8_t*>(src);
+  uint8_t *out = static_cast<uint8_t*>(dst);
+  const __m256 top = _mm256_set1_ps(255);
+
+  size_t i = 0;
+  for(; i + 16 <= n_pixels; i += 16){
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m256i low = correct_8px(_mm256_cvtepu8_epi32(pixels), dark + i, gain + i, top);
+    __m256i high = correct_8px(_mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8)), dark + i + 8, gain + i + 8, top);
+    // the packs work within 128 bit lanes, the permute puts the words back in order
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+    __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(words), _mm256_extracti128_si256(words, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+  }
+  correct_8bit_sse41(in + i, out + i, dark + i, gain + i, n_pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void correct_16bit_avx2(const void *src, void *dst, const float *dark, const float *gain, size_t n_pixels)
+{
+  const uint16_t *in = static_cast<const uint16_t*>(src);
+  uint16_t *out = static_cast<uint16_t*>(dst);
+  const __m256 top = _mm256_set1_ps(65535);
+
+  size_t i = 0;
+  for(; i + 16 <= n_pixels; i += 16){
+    __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+    __m256i low = correct_8px(_mm256_cvtepu16_epi32(lower), dark + i, gain + i, top);
+    __m256i high = correct_8px(_mm256_cvtepu16_epi32(upper), dark + i + 8, gain + i + 8, top);
+    __m256i words = _mm256_permute4x64_epi64(_mm256_packus_epi32(low, high), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), words);
+  }
+  correct_16bit_sse41(in + i, out + i, dark + i, gain + i, n_pixels - i);
+}
+
+#endif /* FRAME_CORRECTION_X86 */
+
+/*********************************
+**           Dispatch           **
+**********************************/
+
+/** @brief Kernel for a depth using a given instruction set
+ *
+ * Falls back to the scalar kernel when the instruction set is not compiled in.
+ * The caller must make sure the CPU supports isa, see PixelUnpack::best_isa().
+ */
+FrameCorrection::Kernel FrameCorrection::kernel(Depth depth, PixelUnpack::Isa isa)
+{
+#ifdef FRAME_CORRECTION_X86
+  if(isa == PixelUnpack::ISA_AVX2)
+    return depth == DEPTH_8 ? correct_8bit_avx2 : correct_16bit_avx2;
+  if(isa == PixelUnpack::ISA_SSE41)
+    return depth == DEPTH_8 ? correct_8bit_sse41 : correct_16bit_sse41;
+#endif
+  return depth == DEPTH_8 ? correct_scalar<uint8_t> : correct_scalar<uint16_t>;
+}
+
+/** @brief Fastest kernel for a depth on the running CPU */
+FrameCorrection::Kernel FrameCorrection::kernel(Depth depth)
+{
+  return kernel(depth, PixelUnpack::best_isa());
+}
+
+/** @brief Index of the first NaN or infinite value of a map, or its size if there is none
+ *
+ * The kernels round every corrected value to an integer, which is undefined for
+ * values that are not finite, so no map with one is ever applied.
+ */
+static size_t find_non_finite(const std::vector<float>& map)
+{
+  for(size_t i = 0; i < map.size(); i++){
+    if(!std::isfinite(map[i]))
+      return i;
+  }
+  return map.size();
+}
+
+/** @brief Reads a map of raw 32 bit floats, one per pixel in row order
+ *
+ * @param path file to read
+ * @param[out] map the values read
+ * @param[out] error description of the failure
+ * @return false if the file could not be read, is not a whole number of floats or
+ *         holds a NaN or infinite value
+ */
+bool FrameCorrection::load_map(const std::string& path, std::vector<float>& map, std::string& error)
+{
+  std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+  if(!file){
+    error = "Could not open correction map " + path;
+    return false;
+  }
+  std::streamoff n_bytes = file.tellg();
+  if(n_bytes <= 0 || n_bytes % sizeof(float) != 0){
+    error = "Correction map " + path + " is not a whole number of 32 bit floats";
+    return false;
+  }
+  map.resize(n_bytes / sizeof(float));
+  file.seekg(0);
+  if(!file.read(reinterpret_cast<char*>(map.data()), n_bytes)){
+    error = "Could not read correction map " + path;
+    return false;
+  }
+  size_t bad = find_non_finite(map);
+  if(bad != map.size()){
+    error = "Correction map " + path + " holds a value that is not finite at pixel " + std::to_string(bad);
+    map.clear();
+    return false;
+  }
+  return true;
+}
+
+/** @brief Writes a map as raw 32 bit floats, in the format load_map reads
+ *
+ * @param path file to write
+ * @param map values to write
+ * @param[out] error description of the failure
+ * @return false if the file could not be written
+ */
+bool FrameCorrection::save_map(const std::string& path, const std::vector<float>& map, std::string& error)
+{
+  std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+  if(!file || !file.write(reinterpret_cast<const char*>(map.data()), map.size() * sizeof(float))){
+    error = "Could not write correction map " + path;
+    return false;
+  }
+  return true;
+}
+
+/** @brief Builds the maps applied to frames from a dark frame and a gain map
+ *
+ * Either may be empty: a missing dark frame subtracts nothing and a missing gain
+ * map multiplies by one.
+ *
+ * @param dark dark frame, or empty
+ * @param gain gain map, or empty
+ * @param[out] maps the maps, both the size of the frame
+ * @param[out] error description of the failure
+ * @return false if both are empty, their sizes differ or either holds a NaN or
+ *         infinite value
+ */
+bool FrameCorrection::make_maps(const std::vector<float>& dark, const std::vector<float>& gain, Maps& maps, std::string& error)
+{
+  if(dark.empty() && gain.empty()){
+    error = "Correction needs a dark frame or a gain map";
+    return false;
+  }
+  if(!dark.empty() && !gain.empty() && dark.size() != gain.size()){
+    error = "The dark frame has " + std::to_string(dark.size()) + " pixels but the gain map has " + std::to_string(gain.size());
+    return false;
+  }
+  size_t bad = find_non_finite(dark);
+  if(bad != dark.size()){
+    error = "The dark frame holds a value that is not finite at pixel " + std::to_string(bad);
+    return false;
+  }
+  bad = find_non_finite(gain);
+  if(bad != gain.size()){
+    error = "The gain map holds a value that is not finite at pixel " + std::to_string(bad);
+    return false;
+  }
+  size_t n_pixels = dark.empty() ? gain.size() : dark.size();
+  maps.dark = dark.empty() ? std::vector<float>(n_pixels, 0.0f) : dark;
+  maps.gain = gain.empty() ? std::vector<float>(n_pixels, 1.0f) : gain;
+  return true;
+}
+
+} // namespace FrameProcessor
@@ -0,0 +1,295 @@
+/**
+ * @file FrameReduction.cpp
+ * @brief Crops a region of interest out of 8 and 16 bit frames and bins its pixels
+ * @date 2026-10-15
+ *
+ * The vector kernels only do the vertical part of the binning, which is where the
+ * data is: they widen each source row to 32 bits and add it into the row of sums.
+ * The horizontal part reads bin_x times fewer values from the sums, in L1, and is
+ * left to the compiler.
+ */
+
+#include "FrameReduction.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FRAME_REDUCTION_X86
+#include <immintrin.h>
+#endif
+
+namespace FrameProcessor
+{
+
+/*********************************
+**         Row kernels          **
+**********************************/
+
+template <class Pixel>
+static void add_row_scalar(const void *src, uint32_t *sums, size_t n_pixels)
+{
+  const Pixel *in = static_cast<const Pixel*>(src);
+  for(size_t i = 0; i < n_pixels; i++)
+    sums[i] += in[i];
+}
+
+#ifdef FRAME_REDUCTION_X86
+
+__attribute__((target("sse4.1")))
+static void add_row_8bit_sse41(const void *src, uint32_t *sums, size_t n_pixels)
+{
+  const uint8_t *in = static_cast<const uint8_t*>(src);
+  size_t i = 0;
+  for(; i + 4 <= n_pixels; i += 4){
+    uint32_t packed;
+    std::memcpy(&packed, in + i, sizeof(packed));
+    __m128i pixels = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+    __m128i *sum = reinterpret_cast<__m128i*>(sums + i);
+    _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), pixels));
+  }
+  add_row_scalar<uint8_t>(in + i, sums + i, n_pixels - i);
+}
+
+__attribute__((target("sse4.1")))
+static void add_row_16bit_sse41(const void *src, uint32_t *sums, size_t n_pixels)
+{
+  const uint16_t *in = static_cast<const uint16_t*>(src);
+  size_t i = 0;
+  for(; i + 4 <= n_pixels; i += 4){
+    __m128i pixels = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i)));
+    __m128i *sum = reinterpret_cast<__m128i*>(sums + i);
+    _mm_storeu_si128(sum, _mm_add_epi32(_mm_loadu_si128(sum), pixels));
+  }
+  add_row_scalar<uint16_t>(in + i, sums + i, n_pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void add_row_8bit_avx2(const void *src, uint32_t *sums, size_t n_pixels)
+{
+  const uint8_t *in = static_cast<const uint8_t*>(src);
+  size_t i = 0;
+  for(; i + 16 <= n_pixels; i += 16){
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m256i *low = reinterpret_cast<__m256i*>(sums + i);
+    __m256i *high = reinterpret_cast<__m256i*>(sums + i + 8);
+    _mm256_storeu_si256(low, _mm256_add_epi32(_mm256_loadu_si256(low), _mm256_cvtepu8_epi32(pixels)));
+    _mm256_storeu_si256(high, _mm256_add_epi32(_mm256_loadu_si256(high), _mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8))));
+  }
+  add_row_8bit_sse41(in + i, sums + i, n_pixels - i);
+}
+
+__attribute__((target("avx2")))
+static void add_row_16bit_avx2(const void *src, uint32_t *sums, size_t n_pixels)
+{
+  const uint16_t *in = static_cast<const uint16_t*>(src);
+  size_t i = 0;
+  for(; i + 16 <= n_pixels; i += 16){
+    __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+    __m256i *low = reinterpret_cast<__m256i*>(sums + i);
+    __m256i *high = reinterpret_cast<__m256i*>(sums + i + 8);
+    _mm256_storeu_si256(low, _mm256_add_epi32(_mm256_loadu_si256(low), _mm256_cvtepu16_epi32(lower)));
+    _mm256_storeu_si256(high, _mm256_add_epi32(_mm256_loadu_si256(high), _mm256_cvtepu16_epi32(upper)));
+  }
+  add_row_16bit_sse41(in + i, sums + i, n_pixels - i);
+}
+
+#endif /* FRAME_REDUCTION_X86 */
+
+/** @brief Adds the bin_x neighbours of each sum and writes the output row
+ *
+ * @param divisor pixels per block for a mean, 1 for a sum
+ */
+template <class Out>
+static void finish_row(const uint32_t *sums, size_t n_out, unsigned int bin_x, uint32_t divisor, Out *dst)
+{
+  if(bin_x == 1 && divisor == 1){
+    for(size_t i = 0; i < n_out; i++)
+      dst[i] = static_cast<Out>(sums[i]);
+    return;
+  }
+  for(size_t i = 0; i < n_out; i++, sums += bin_x){
+    uint32_t sum = 0;
+    for(unsigned int j = 0; j < bin_x; j++)
+      sum += sums[j];
+    dst[i] = static_cast<Out>(divisor == 1 ? sum : (sum + divisor / 2) / divisor);
+  }
+}
+
+/*********************************
+**          Reduction           **
+**********************************/
+
+FrameReduction::FrameReduction() :
+  in_bytes_(1),
+  out_bytes_(1),
+  add_row_(add_row_scalar<uint8_t>),
+  src_width_(0),
+  out_height_(0),
+  out_width_(0)
+{
+  Settings settings = {0, 0, 0, 0, 1, 1, BIN_SUM};
+  settings_ = settings;
+}
+
+/** @brief Translates "sum" or "mean" into a binning mode
+ *
+ * @return false if the name is not a mode
+ */
+bool FrameReduction::mode_from_string(const std::string& name, Mode& mode)
+{
+  if(name == "sum"){
+    mode = BIN_SUM;
+  }else if(name == "mean"){
+    mode = BIN_MEAN;
+  }else{
+    return false;
+  }
+  return true;
+}
+
+const char *FrameReduction::mode_name(Mode mode)
+{
+  return mode == BIN_MEAN ? "mean" : "sum";
+}
+
+/** @brief Sets the region and binning, and the depth of the source frames
+ *
+ * The caller must make sure the CPU supports isa, see PixelUnpack::best_isa().
+ *
+ * @param settings region of interest and binning, bins of 0 are taken as 1
+ * @param bytes_per_pixel 1 or 2
+ * @param isa instruction set of the row kernel
+ */
+void FrameReduction::configure(const Settings& settings, size_t bytes_per_pixel, PixelUnpack::Isa isa)
+{
+  settings_ = settings;
+  if(settings_.bin_x == 0) settings_.bin_x = 1;
+  if(settings_.bin_y == 0) settings_.bin_y = 1;
+  in_bytes_ = bytes_per_pixel == 1 ? 1 : 2;
+  src_width_ = 0;
+  out_height_ = 0;
+  out_width_ = 0;
+
+  uint64_t block = static_cast<uint64_t>(settings_.bin_x) * settings_.bin_y;
+  if(settings_.mode == BIN_MEAN || block == 1)
+    out_bytes_ = in_bytes_;
+  else if(in_bytes_ == 1 && block * 255 <= 65535)
+    out_bytes_ = 2;
+  else
+    out_bytes_ = 4;
+
+  add_row_ = in_bytes_ == 1 ? add_row_scalar<uint8_t> : add_row_scalar<uint16_t>;
+#ifdef FRAME_REDUCTION_X86
+  if(isa == PixelUnpack::ISA_AVX2)
+    add_row_ = in_bytes_ == 1 ? add_row_8bit_avx2 : add_row_16bit_avx2;
+  else if(isa == PixelUnpack::ISA_SSE41)
+    add_row_ = in_bytes_ == 1 ? add_row_8bit_sse41 : add_row_16bit_sse41;
+#endif
+}
+
+/** @brief Sets the region and binning, using the fastest row kernel on the running CPU */
+void FrameReduction::configure(const Settings& settings, size_t bytes_per_pixel)
+{
+  configure(settings, bytes_per_pixel, PixelUnpack::best_isa());
+}
+
+/** @brief Does the reduction change the image at all? */
+bool FrameReduction::active() const
+{
+  return settings_.x != 0 || settings_.y != 0 || settings_.width != 0 || settings_.height != 0 ||
+         settings_.bin_x > 1 || settings_.bin_y > 1;
+}
+
+/** @brief Fits the region to a source image size, done again whenever it changes
+ *
+ * @param height rows of the source image
+ * @param width columns of the source image
+ * @param[out] error description of the failure
+ * @return false if the region is not inside the image or smaller than one block
+ */
+bool FrameReduction::fit(size_t height, size_t width, std::string& error)
+{
+  if(settings_.x >= width || settings_.y >= height){
+    error = "Region of interest starts outside the " + std::to_string(width) + "x" + std::to_string(height) + " image";
+    return false;
+  }
+  size_t roi_width = settings_.width ? settings_.width : width - settings_.x;
+  size_t roi_height = settings_.height ? settings_.height : height - settings_.y;
+  if(settings_.x + roi_width > width || settings_.y + roi_height > height){
+    error = "Region of interest goes past the edge of the " + std::to_string(width) + "x" + std::to_string(height) + " image";
+    return false;
+  }
+  if(roi_width < settings_.bin_x || roi_height < settings_.bin_y){
+    error = "Region of interest is smaller than one bin";
+    return false;
+  }
+
+  src_width_ = width;
+  out_width_ = roi_width / settings_.bin_x;
+  out_height_ = roi_height / settings_.bin_y;
+  sums_.assign(out_width_ * settings_.bin_x, 0);
+  return true;
+}
+
+/** Rows of the reduced image, after fit() */
+size_t FrameReduction::height() const
+{
+  return out_height_;
+}
+
+/** Columns of the reduced image, after fit() */
+size_t FrameReduction::width() const
+{
+  return out_width_;
+}
+
+/** Bytes per pixel of the reduced image: 1, 2 or 4 */
+size_t FrameReduction::bytes_per_pixel() const
+{
+  return out_bytes_;
+}
+
+/** Bytes of the reduced image, after fit() */
+size_t FrameReduction::frame_bytes() const
+{
+  return out_height_ * out_width_ * out_bytes_;
+}
+
+/** @brief Reduces a source image of the fitted size
+ *
+ * @param src source image, rows back to back
+ * @param dst reduced image, frame_bytes() long
+ */
+void FrameReduction::reduce(const void *src, void *dst)
+{
+  const size_t stride = src_width_ * in_bytes_;
+  const uint8_t *region = static_cast<const uint8_t*>(src) + settings_.y * stride + settings_.x * in_bytes_;
+  uint8_t *out = static_cast<uint8_t*>(dst);
+  const size_t out_stride = out_width_ * out_bytes_;
+
+  if(settings_.bin_x == 1 && settings_.bin_y == 1){
+    for(size_t row = 0; row < out_height_; row++)
+      std::memcpy(out + row * out_stride, region + row * stride, out_stride);
+    return;
+  }
+
+  const uint32_t divisor = settings_.mode == BIN_MEAN ? settings_.bin_x * settings_.bin_y : 1;
+  const size_t n_sums = sums_.size();
+  for(size_t row = 0; row < out_height_; row++){
+    std::fill(sums_.begin(), sums_.end(), 0);
+    for(unsigned int k = 0; k < settings_.bin_y; k++)
+      add_row_(region + (row * settings_.bin_y + k) * stride, sums_.data(), n_sums);
+
+    void *line = out + row * out_stride;
+    if(out_bytes_ == 1)
+      finish_row(sums_.data(), out_width_, settings_.bin_x, divisor, static_cast<uint8_t*>(line));
+    else if(out_bytes_ == 2)
+      finish_row(sums_.data(), out_width_, settings_.bin_x, divisor, static_cast<uint16_t*>(line));
+    else
+      finish_row(sums_.data(), out_width_, settings_.bin_x, divisor, static_cast<uint32_t*>(line));
+  }
+}
+
+} // namespace FrameProcessor
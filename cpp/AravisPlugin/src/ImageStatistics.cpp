@@ -0,0 +1,311 @@
+/**
+ * @file ImageStatistics.cpp
+ * @brief Total intensity, range, centroid, rms width and histogram of a frame in one pass
+ * @date 2026-10-16
+ *
+ * The vector kernels keep the smallest and largest pixel in registers of pixel
+ * width, and widen the pixels to 32 bits once to add them both into the column sums
+ * and into a register of row totals. A row of up to 65536 16 bit pixels cannot
+ * overflow the 32 bit lanes of the row totals.
+ */
+
+#include "ImageStatistics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IMAGE_STATISTICS_X86
+#include <immintrin.h>
+#endif
+
+namespace FrameProcessor
+{
+
+/*********************************
+**         Row kernels          **
+**********************************/
+
+template <class Pixel>
+static void scan_row_scalar(const void *row, size_t n_pixels, uint32_t *column_sums, ImageStatistics::RowTotals& totals)
+{
+  const Pixel *in = static_cast<const Pixel*>(row);
+  for(size_t i = 0; i < n_pixels; i++){
+    Pixel value = in[i];
+    column_sums[i] += value;
+    totals.sum += value;
+    totals.min = std::min<uint32_t>(totals.min, value);
+    totals.max = std::max<uint32_t>(totals.max, value);
+  }
+}
+
+#ifdef IMAGE_STATISTICS_X86
+
+/** @brief Adds 4 widened pixels into the column sums and the row totals */
+__attribute__((target("sse4.1")))
+static inline void add_4px(__m128i pixels, uint32_t *column_sums, __m128i& row_sums)
+{
+  __m128i *sums = reinterpret_cast<__m128i*>(column_sums);
+  _mm_storeu_si128(sums, _mm_add_epi32(_mm_loadu_si128(sums), pixels));
+  row_sums = _mm_add_epi32(row_sums, pixels);
+}
+
+/** @brief Adds the lanes of the row totals and range into the scalar totals */
+template <class Lane>
+static void fold_totals(const uint32_t *row_sums, size_t n_sums, const Lane *mins, const Lane *maxs, size_t n_lanes,
+                        ImageStatistics::RowTotals& totals)
+{
+  for(size_t i = 0; i < n_sums; i++)
+    totals.sum += row_sums[i];
+  for(size_t i = 0; i < n_lanes; i++){
+    totals.min = std::min<uint32_t>(totals.min, mins[i]);
+    totals.max = std::max<uint32_t>(totals.max, maxs[i]);
+  }
+}
+
+__attribute__((target("sse4.1")))
+static void scan_row_8bit_sse41(const void *row, size_t n_pixels, uint32_t *column_sums, ImageStatistics::RowTotals& totals)
+{
+  const uint8_t *in = static_cast<const uint8_t*>(row);
+  __m128i mins = _mm_set1_epi8(-1), maxs = _mm_setzero_si128(), row_sums = _mm_setzero_si128();
+
+  size_t i = 0;
+  for(; i + 16 <= n_pixels; i += 16){
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    mins = _mm_min_epu8(mins, pixels);
+    maxs = _mm_max_epu8(maxs, pixels);
+    add_4px(_mm_cvtepu8_epi32(pixels), column_sums + i, row_sums);
+    add_4px(_mm_cvtepu8_epi32(_mm_srli_si128(pixels, 4)), column_sums + i + 4, row_sums);
+    add_4px(_mm_cvtepu8_epi32(_mm_srli_si128(pixels, 8)), column_sums + i + 8, row_sums);
+    add_4px(_mm_cvtepu8_epi32(_mm_srli_si128(pixels, 12)), column_sums + i + 12, row_sums);
+  }
+
+  uint32_t sums[4];
+  uint8_t lane_mins[16], lane_maxs[16];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), row_sums);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_mins), mins);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_maxs), maxs);
+  fold_totals(sums, 4, lane_mins, lane_maxs, i ? 16 : 0, totals);
+  scan_row_scalar<uint8_t>(in + i, n_pixels - i, column_sums + i, totals);
+}
+
+__attribute__((target("sse4.1")))
+static void scan_row_16bit_sse41(const void *row, size_t n_pixels, uint32_t *column_sums, ImageStatistics::RowTotals& totals)
+{
+  const uint16_t *in = static_cast<const uint16_t*>(row);
+  __m128i mins = _mm_set1_epi16(-1), maxs = _mm_setzero_si128(), row_sums = _mm_setzero_si128();
+
+  size_t i = 0;
+  for(; i + 8 <= n_pixels; i += 8){
+    __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    mins = _mm_min_epu16(mins, pixels);
+    maxs = _mm_max_epu16(maxs, pixels);
+    add_4px(_mm_cvtepu16_epi32(pixels), column_sums + i, row_sums);
+    add_4px(_mm_cvtepu16_epi32(_mm_srli_si128(pixels, 8)), column_sums + i + 4, row_sums);
+  }
+
+  uint32_t sums[4];
+  uint16_t lane_mins[8], lane_maxs[8];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(sums), row_sums);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_mins), mins);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lane_maxs), maxs);
+  fold_totals(sums, 4, lane_mins, lane_maxs, i ? 8 : 0, totals);
+  scan_row_scalar<uint16_t>(in + i, n_pixels - i, column_sums + i, totals);
+}
+
+/** @brief Adds 8 widened pixels into the column sums and the row totals */
+__attribute__((target("avx2")))
+static inline void add_8px(__m256i pixels, uint32_t *column_sums, __m256i& row_sums)
+{
+  __m256i *sums = reinterpret_cast<__m256i*>(column_sums);
+  _mm256_storeu_si256(sums, _mm256_add_epi32(_mm256_loadu_si256(sums), pixels));
+  row_sums = _mm256_add_epi32(row_sums, pixels);
+}
+
+__attribute__((target("avx2")))
+static void scan_row_8bit_avx2(const void *row, size_t n_pixels, uint32_t *column_sums, ImageStatistics::RowTotals& totals)
+{
+  const uint8_t *in = static_cast<const uint8_t*>(row);
+  __m256i mins = _mm256_set1_epi8(-1), maxs = _mm256_setzero_si256(), row_sums = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for(; i + 32 <= n_pixels; i += 32){
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    mins = _mm256_min_epu8(mins, pixels);
+    maxs = _mm256_max_epu8(maxs, pixels);
+    __m128i lower = _mm256_castsi256_si128(pixels);
+    __m128i upper = _mm256_extracti128_si256(pixels, 1);
+    add_8px(_mm256_cvtepu8_epi32(lower), column_sums + i, row_sums);
+    add_8px(_mm256_cvtepu8_epi32(_mm_srli_si128(lower, 8)), column_sums + i + 8, row_sums);
+    add_8px(_mm256_cvtepu8_epi32(upper), column_sums + i + 16, row_sums);
+    add_8px(_mm256_cvtepu8_epi32(_mm_srli_si128(upper, 8)), column_sums + i + 24, row_sums);
+  }
+
+  uint32_t sums[8];
+  uint8_t lane_mins[32], lane_maxs[32];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), row_sums);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_mins), mins);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_maxs), maxs);
+  fold_totals(sums, 8, lane_mins, lane_maxs, i ? 32 : 0, totals);
+  scan_row_8bit_sse41(in + i, n_pixels - i, column_sums + i, totals);
+}
+
+__attribute__((target("avx2")))
+static void scan_row_16bit_avx2(const void *row, size_t n_pixels, uint32_t *column_sums, ImageStatistics::RowTotals& totals)
+{
+  const uint16_t *in = static_cast<const uint16_t*>(row);
+  __m256i mins = _mm256_set1_epi16(-1), maxs = _mm256_setzero_si256(), row_sums = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for(; i + 16 <= n_pixels; i += 16){
+    __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+    mins = _mm256_min_epu16(mins, pixels);
+    maxs = _mm256_max_epu16(maxs, pixels);
+    add_8px(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(pixels)), column_sums + i, row_sums);
+    add_8px(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(pixels, 1)), column_sums + i + 8, row_sums);
+  }
+
+  uint32_t sums[8];
+  uint16_t lane_mins[16], lane_maxs[16];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), row_sums);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_mins), mins);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_maxs), maxs);
+  fold_totals(sums, 8, lane_mins, lane_maxs, i ? 16 : 0, totals);
+  scan_row_16bit_sse41(in + i, n_pixels - i, column_sums + i, totals);
+}
+
+#endif /* IMAGE_STATISTICS_X86 */
+
+/** @brief Adds a row to four interleaved histograms */
+template <class Pixel>
+static void add_to_histogram(const void *row, size_t n_pixels, unsigned int shift, size_t n_bins, uint32_t *histograms)
+{
+  const Pixel *in = static_cast<const Pixel*>(row);
+  size_t i = 0;
+  for(; i + 4 <= n_pixels; i += 4){
+    histograms[in[i] >> shift]++;
+    histograms[n_bins + (in[i + 1] >> shift)]++;
+    histograms[2 * n_bins + (in[i + 2] >> shift)]++;
+    histograms[3 * n_bins + (in[i + 3] >> shift)]++;
+  }
+  for(; i < n_pixels; i++)
+    histograms[in[i] >> shift]++;
+}
+
+/*********************************
+**          Statistics          **
+**********************************/
+
+ImageStatistics::ImageStatistics() :
+  bytes_per_pixel_(1),
+  histogram_shift_(0),
+  scan_row_(scan_row_scalar<uint8_t>)
+{
+}
+
+/** @brief Is this a number of histogram bins configure() accepts? 0 or a power of two up to 256 */
+bool ImageStatistics::valid_histogram_bins(unsigned int histogram_bins)
+{
+  return histogram_bins <= MAX_HISTOGRAM_BINS && (histogram_bins & (histogram_bins - 1)) == 0;
+}
+
+/** @brief Sets the depth of the images and the histogram size
+ *
+ * The caller must make sure the CPU supports isa, see PixelUnpack::best_isa().
+ *
+ * @param bytes_per_pixel 1 or 2
+ * @param histogram_bins 0 for no histogram, or a power of two up to 256
+ * @param isa instruction set of the row kernel
+ * @return false if the depth or number of bins is not supported
+ */
+bool ImageStatistics::configure(size_t bytes_per_pixel, unsigned int histogram_bins, PixelUnpack::Isa isa)
+{
+  if((bytes_per_pixel != 1 && bytes_per_pixel != 2) || !valid_histogram_bins(histogram_bins))
+    return false;
+
+  bytes_per_pixel_ = bytes_per_pixel;
+  unsigned int bin_bits = 0;
+  while((1u << bin_bits) < histogram_bins)
+    bin_bits++;
+  histogram_shift_ = 8 * bytes_per_pixel - bin_bits;
+  histogram_.assign(histogram_bins, 0);
+  partial_histograms_.assign(4 * histogram_bins, 0);
+
+  scan_row_ = bytes_per_pixel == 1 ? scan_row_scalar<uint8_t> : scan_row_scalar<uint16_t>;
+#ifdef IMAGE_STATISTICS_X86
+  if(isa == PixelUnpack::ISA_AVX2)
+    scan_row_ = bytes_per_pixel == 1 ? scan_row_8bit_avx2 : scan_row_16bit_avx2;
+  else if(isa == PixelUnpack::ISA_SSE41)
+    scan_row_ = bytes_per_pixel == 1 ? scan_row_8bit_sse41 : scan_row_16bit_sse41;
+#endif
+  return true;
+}
+
+/** @brief Sets the depth and histogram size, using the fastest row kernel on the running CPU */
+bool ImageStatistics::configure(size_t bytes_per_pixel, unsigned int histogram_bins)
+{
+  return configure(bytes_per_pixel, histogram_bins, PixelUnpack::best_isa());
+}
+
+/** @brief Measures one image
+ *
+ * @param image pixels, rows back to back, of the configured depth
+ * @param height rows, at most MAX_HEIGHT
+ * @param width columns
+ * @param[out] result the statistics; the histogram is left in histogram()
+ */
+void ImageStatistics::measure(const void *image, size_t height, size_t width, Result& result)
+{
+  column_sums_.assign(width, 0);
+  std::fill(partial_histograms_.begin(), partial_histograms_.end(), 0);
+  const size_t n_bins = histogram_.size();
+  const uint8_t *row = static_cast<const uint8_t*>(image);
+  const size_t stride = width * bytes_per_pixel_;
+
+  uint64_t sum = 0;
+  uint32_t min = UINT32_MAX, max = 0;
+  double sum_y = 0, sum_y2 = 0;
+  for(size_t y = 0; y < height; y++, row += stride){
+    RowTotals totals = {0, UINT32_MAX, 0};
+    scan_row_(row, width, column_sums_.data(), totals);
+    if(n_bins != 0){
+      if(bytes_per_pixel_ == 1)
+        add_to_histogram<uint8_t>(row, width, histogram_shift_, n_bins, partial_histograms_.data());
+      else
+        add_to_histogram<uint16_t>(row, width, histogram_shift_, n_bins, partial_histograms_.data());
+    }
+    sum += totals.sum;
+    min = std::min(min, totals.min);
+    max = std::max(max, totals.max);
+    sum_y += static_cast<double>(y) * totals.sum;
+    sum_y2 += static_cast<double>(y) * y * totals.sum;
+  }
+
+  double sum_x = 0, sum_x2 = 0;
+  for(size_t x = 0; x < width; x++){
+    sum_x += static_cast<double>(x) * column_sums_[x];
+    sum_x2 += static_cast<double>(x) * x * column_sums_[x];
+  }
+  for(size_t bin = 0; bin < n_bins; bin++)
+    histogram_[bin] = partial_histograms_[bin] + partial_histograms_[n_bins + bin] +
+                      partial_histograms_[2 * n_bins + bin] + partial_histograms_[3 * n_bins + bin];
+
+  result.sum = sum;
+  result.min = height != 0 && width != 0 ? min : 0;
+  result.max = max;
+  result.centroid_x = result.centroid_y = result.rms_x = result.rms_y = 0;
+  if(sum != 0){
+    result.centroid_x = sum_x / sum;
+    result.centroid_y = sum_y / sum;
+    result.rms_x = std::sqrt(std::max(0.0, sum_x2 / sum - result.centroid_x * result.centroid_x));
+    result.rms_y = std::sqrt(std::max(0.0, sum_y2 / sum - result.centroid_y * result.centroid_y));
+  }
+}
+
+/** Histogram of the last image measured, empty if configured without one */
+const std::vector<uint32_t>& ImageStatistics::histogram() const
+{
+  return histogram_;
+}
+
+} // namespace FrameProcessor
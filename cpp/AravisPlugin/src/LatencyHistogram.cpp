@@ -0,0 +1,98 @@
+/**
+ * @file LatencyHistogram.cpp
+ * @brief Fixed size log-linear histogram for per-frame latencies
+ * @date 2026-10-15
+ */
+
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FrameProcessor
+{
+
+LatencyHistogram::LatencyHistogram()
+{
+  reset();
+}
+
+/** @brief Adds one sample. Only one thread may record. */
+void LatencyHistogram::record(uint64_t value_ns)
+{
+  std::atomic<uint64_t>& bucket = buckets_[bucket_of(value_ns)];
+  bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  count_.store(count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if(value_ns > max_.load(std::memory_order_relaxed))
+    max_.store(value_ns, std::memory_order_relaxed);
+}
+
+/** @brief Drops every sample */
+void LatencyHistogram::reset()
+{
+  for(size_t i = 0; i < N_BUCKETS; i++)
+    buckets_[i].store(0, std::memory_order_relaxed);
+  count_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+/** @brief Number of samples recorded since the last reset */
+uint64_t LatencyHistogram::count() const
+{
+  return count_.load(std::memory_order_relaxed);
+}
+
+/** @brief Largest sample recorded since the last reset, exact */
+uint64_t LatencyHistogram::max() const
+{
+  return max_.load(std::memory_order_relaxed);
+}
+
+/** @brief Value at or below which the given fraction of the samples lie
+ *
+ * @param fraction between 0 and 1, eg 0.99 for the 99th percentile
+ * @return the midpoint of the bucket holding that sample in ns, 0 if there are no samples
+ */
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+  uint64_t total = 0;
+  for(size_t i = 0; i < N_BUCKETS; i++)
+    total += buckets_[i].load(std::memory_order_relaxed);
+  if(total == 0)
+    return 0;
+
+  uint64_t target = static_cast<uint64_t>(std::ceil(fraction * total));
+  if(target == 0)
+    target = 1;
+  uint64_t seen = 0;
+  for(size_t i = 0; i < N_BUCKETS; i++){
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if(seen >= target)
+      return std::min(value_of(i), max());
+  }
+  return max();
+}
+
+/** @brief Bucket holding value_ns */
+size_t LatencyHistogram::bucket_of(uint64_t value_ns)
+{
+  if(value_ns < SUB_BUCKETS)
+    return static_cast<size_t>(value_ns);
+  int msb = 63 - __builtin_clzll(value_ns);
+  if(msb >= MAX_BITS)
+    return N_BUCKETS - 1;
+  int shift = msb - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value_ns >> shift) - SUB_BUCKETS);
+}
+
+/** @brief Midpoint of the values held by bucket */
+uint64_t LatencyHistogram::value_of(size_t bucket)
+{
+  if(bucket < SUB_BUCKETS)
+    return bucket;
+  int shift = static_cast<int>(bucket / SUB_BUCKETS) - 1;
+  uint64_t lowest = static_cast<uint64_t>(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  return lowest + ((uint64_t(1) << shift) >> 1);
+}
+
+} // namespace FrameProcessor
@@ -0,0 +1,293 @@
+/**
+ * @file PixelUnpack.cpp
+ * @brief Kernels that unpack Mono10/Mono12 packed pixel formats into 16 bit pixels
+ * @date 2026-10-15
+ *
+ * All the vector kernels follow the same pattern: a byte shuffle places the two
+ * source bytes holding each pixel in its 16 bit lane, a per lane multiply lines the
+ * pixel bits up against the top of the lane and a shift brings them back down. The
+ * AVX2 kernels run the SSE4.1 algorithm on two 128 bit lanes at once. Pixels left
+ * over at the end of a frame are finished by the scalar kernel.
+ */
+
+#include "PixelUnpack.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_UNPACK_X86
+#include <immintrin.h>
+#endif
+
+namespace FrameProcessor
+{
+
+/*********************************
+**        Scalar kernels        **
+**********************************/
+
+/** @brief Mono10p/Mono12p: pixels packed back to back, least significant bit first */
+template <unsigned BITS>
+static void unpack_lsb_scalar(const uint8_t *src, uint16_t *dst, size_t n_pixels)
+{
+  const unsigned mask = (1u << BITS) - 1;
+  size_t bit = 0;
+  for(size_t i = 0; i < n_pixels; i++, bit += BITS){
+    const uint8_t *p = src + (bit >> 3);
+    dst[i] = ((p[0] | (p[1] << 8)) >> (bit & 7)) & mask;
+  }
+}
+
+/** @brief Mono10Packed/Mono12Packed: high bits in bytes 0 and 2, low bits of both pixels in byte 1 */
+template <unsigned BITS>
+static void unpack_gige_scalar(const uint8_t *src, uint16_t *dst, size_t n_pixels)
+{
+  const unsigned shift = BITS - 8;
+  const unsigned mask = (1u << shift) - 1;
+  size_t i = 0;
+  for(; i + 1 < n_pixels; i += 2, src += 3){
+    dst[i] = (src[0] << shift) | (src[1] & mask);
+    dst[i + 1] = (src[2] << shift) | ((src[1] >> 4) & mask);
+  }
+  if(i < n_pixels)
+    dst[i] = (src[0] << shift) | (src[1] & mask);
+}
+
+#ifdef PIXEL_UNPACK_X86
+
+/*********************************
+**        Vector layouts        **
+**********************************/
+
+/** @brief Shuffle tables and multipliers for 8 pixels held in one 128 bit lane
+ *
+ * step is the number of source bytes consumed per 8 pixels. For the lsb formats
+ * the shuffle picks the two bytes holding each pixel. For the GigE formats the
+ * first shuffle picks the high byte and the second the shared low bits byte.
+ */
+template <unsigned BITS, bool GIGE> struct VectorLayout;
+
+template <> struct VectorLayout<10, false>
+{
+  static const size_t step = 10;
+  static __m128i shuffle() { return _mm_setr_epi8(0,1, 1,2, 2,3, 3,4, 5,6, 6,7, 7,8, 8,9); }
+  static __m128i multiplier() { return _mm_setr_epi16(64, 16, 4, 1, 64, 16, 4, 1); }
+};
+
+template <> struct VectorLayout<12, false>
+{
+  static const size_t step = 12;
+  static __m128i shuffle() { return _mm_setr_epi8(0,1, 1,2, 3,4, 4,5, 6,7, 7,8, 9,10, 10,11); }
+  static __m128i multiplier() { return _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1); }
+};
+
+template <unsigned BITS> struct VectorLayout<BITS, true>
+{
+  static const size_t step = 12;
+  static __m128i shuffle_high() { return _mm_setr_epi8(0,-1, 2,-1, 3,-1, 5,-1, 6,-1, 8,-1, 9,-1, 11,-1); }
+  static __m128i shuffle_low() { return _mm_setr_epi8(1,-1, 1,-1, 4,-1, 4,-1, 7,-1, 7,-1, 10,-1, 10,-1); }
+  static __m128i multiplier() { return _mm_setr_epi16(16, 1, 16, 1, 16, 1, 16, 1); }
+};
+
+/*********************************
+**        SSE4.1 kernels        **
+**********************************/
+
+template <unsigned BITS>
+__attribute__((target("sse4.1")))
+static inline __m128i unpack_lsb_8px(__m128i packed)
+{
+  typedef VectorLayout<BITS, false> Layout;
+  __m128i words = _mm_shuffle_epi8(packed, Layout::shuffle());
+  return _mm_srli_epi16(_mm_mullo_epi16(words, Layout::multiplier()), 16 - BITS);
+}
+
+template <unsigned BITS>
+__attribute__((target("sse4.1")))
+static inline __m128i unpack_gige_8px(__m128i packed)
+{
+  typedef VectorLayout<BITS, true> Layout;
+  const __m128i mask = _mm_set1_epi16((1 << (BITS - 8)) - 1);
+  __m128i high = _mm_shuffle_epi8(packed, Layout::shuffle_high());
+  __m128i low = _mm_shuffle_epi8(packed, Layout::shuffle_low());
+  // even lanes keep the low nibble, odd lanes the high nibble of the shared byte
+  low = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(low, Layout::multiplier()), 4), mask);
+  return _mm_or_si128(_mm_slli_epi16(high, BITS - 8), low);
+}
+
+template <unsigned BITS, bool GIGE>
+__attribute__((target("sse4.1")))
+static void unpack_sse41(const uint8_t *src, uint16_t *dst, size_t n_pixels)
+{
+  typedef VectorLayout<BITS, GIGE> Layout;
+  const size_t n_bytes = PixelUnpack::packed_bytes(
+    GIGE ? (BITS == 10 ? PixelUnpack::MONO10_PACKED : PixelUnpack::MONO12_PACKED)
+         : (BITS == 10 ? PixelUnpack::MONO10_P : PixelUnpack::MONO12_P), n_pixels);
+
+  size_t i = 0, offset = 0;
+  // every step loads 16 bytes but only consumes Layout::step of them
+  for(; i + 8 <= n_pixels && offset + 16 <= n_bytes; i += 8, offset += Layout::step){
+    __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset));
+    __m128i pixels = GIGE ? unpack_gige_8px<BITS>(packed) : unpack_lsb_8px<BITS>(packed);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), pixels);
+  }
+
+  if(GIGE)
+    unpack_gige_scalar<BITS>(src + offset, dst + i, n_pixels - i);
+  else
+    unpack_lsb_scalar<BITS>(src + offset, dst + i, n_pixels - i);
+}
+
+/*********************************
+**         AVX2 kernels         **
+**********************************/
+
+template <unsigned BITS, bool GIGE>
+__attribute__((target("avx2")))
+static void unpack_avx2(const uint8_t *src, uint16_t *dst, size_t n_pixels)
+{
+  typedef VectorLayout<BITS, GIGE> Layout;
+  const size_t n_bytes = PixelUnpack::packed_bytes(
+    GIGE ? (BITS == 10 ? PixelUnpack::MONO10_PACKED : PixelUnpack::MONO12_PACKED)
+         : (BITS == 10 ? PixelUnpack::MONO10_P : PixelUnpack::MONO12_P), n_pixels);
+
+  const __m256i mask = _mm256_set1_epi16((1 << (BITS - 8)) - 1);
+  __m256i shuffle_a, shuffle_b, multiplier;
+  if(GIGE){
+    shuffle_a = _mm256_broadcastsi128_si256(VectorLayout<BITS, true>::shuffle_high());
+    shuffle_b = _mm256_broadcastsi128_si256(VectorLayout<BITS, true>::shuffle_low());
+  }else{
+    shuffle_a = _mm256_broadcastsi128_si256(VectorLayout<BITS, false>::shuffle());
+    shuffle_b = shuffle_a;
+  }
+  multiplier = _mm256_broadcastsi128_si256(Layout::multiplier());
+
+  size_t i = 0, offset = 0;
+  // the upper lane starts Layout::step bytes in and loads 16 bytes from there
+  for(; i + 16 <= n_pixels && offset + Layout::step + 16 <= n_bytes; i += 16, offset += 2 * Layout::step){
+    __m128i lower = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset));
+    __m128i upper = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset + Layout::step));
+    __m256i packed = _mm256_inserti128_si256(_mm256_castsi128_si256(lower), upper, 1);
+    __m256i pixels;
+    if(GIGE){
+      __m256i high = _mm256_shuffle_epi8(packed, shuffle_a);
+      __m256i low = _mm256_shuffle_epi8(packed, shuffle_b);
+      low = _mm256_and_si256(_mm256_srli_epi16(_mm256_mullo_epi16(low, multiplier), 4), mask);
+      pixels = _mm256_or_si256(_mm256_slli_epi16(high, BITS - 8), low);
+    }else{
+      __m256i words = _mm256_shuffle_epi8(packed, shuffle_a);
+      pixels = _mm256_srli_epi16(_mm256_mullo_epi16(words, multiplier), 16 - BITS);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), pixels);
+  }
+
+  // finish with the 128 bit kernel, which hands the last few pixels to the scalar one
+  unpack_sse41<BITS, GIGE>(src + offset, dst + i, n_pixels - i);
+}
+
+#endif /* PIXEL_UNPACK_X86 */
+
+/*********************************
+**           Dispatch           **
+**********************************/
+
+/** @brief Translates a GenICam pixel format name into a packed format
+ *
+ * @param pixel_format pixel format name, eg Mono12p
+ * @param[out] format the matching packed format
+ * @return false if the pixel format is not a supported packed format
+ */
+bool PixelUnpack::format_from_string(const std::string& pixel_format, Format& format)
+{
+  if(pixel_format == "Mono10p"){
+    format = MONO10_P;
+  }else if(pixel_format == "Mono12p"){
+    format = MONO12_P;
+  }else if(pixel_format == "Mono10Packed"){
+    format = MONO10_PACKED;
+  }else if(pixel_format == "Mono12Packed"){
+    format = MONO12_PACKED;
+  }else{
+    return false;
+  }
+  return true;
+}
+
+/** @brief Number of bytes n_pixels pixels take up in the packed format */
+size_t PixelUnpack::packed_bytes(Format format, size_t n_pixels)
+{
+  switch(format){
+    case MONO10_P:
+      return (n_pixels * 10 + 7) / 8;
+    case MONO12_P:
+      return (n_pixels * 12 + 7) / 8;
+    case MONO10_PACKED:
+    case MONO12_PACKED:
+      return (n_pixels * 3 + 1) / 2;
+  }
+  return 0;
+}
+
+/** @brief Most capable instruction set supported by the running CPU */
+PixelUnpack::Isa PixelUnpack::best_isa()
+{
+#ifdef PIXEL_UNPACK_X86
+  if(__builtin_cpu_supports("avx2"))
+    return ISA_AVX2;
+  if(__builtin_cpu_supports("sse4.1"))
+    return ISA_SSE41;
+#endif
+  return ISA_SCALAR;
+}
+
+const char *PixelUnpack::isa_name(Isa isa)
+{
+  switch(isa){
+    case ISA_AVX2:
+      return "avx2";
+    case ISA_SSE41:
+      return "sse4.1";
+    default:
+      return "scalar";
+  }
+}
+
+/** @brief Kernel for a format using a given instruction set
+ *
+ * Falls back to the scalar kernel when the instruction set is not compiled in.
+ * The caller must make sure the CPU supports isa, see best_isa().
+ */
+PixelUnpack::Kernel PixelUnpack::kernel(Format format, Isa isa)
+{
+#ifdef PIXEL_UNPACK_X86
+  if(isa == ISA_AVX2){
+    switch(format){
+      case MONO10_P:      return unpack_avx2<10, false>;
+      case MONO12_P:      return unpack_avx2<12, false>;
+      case MONO10_PACKED: return unpack_avx2<10, true>;
+      case MONO12_PACKED: return unpack_avx2<12, true>;
+    }
+  }
+  if(isa == ISA_SSE41){
+    switch(format){
+      case MONO10_P:      return unpack_sse41<10, false>;
+      case MONO12_P:      return unpack_sse41<12, false>;
+      case MONO10_PACKED: return unpack_sse41<10, true>;
+      case MONO12_PACKED: return unpack_sse41<12, true>;
+    }
+  }
+#endif
+  switch(format){
+    case MONO10_P:      return unpack_lsb_scalar<10>;
+    case MONO12_P:      return unpack_lsb_scalar<12>;
+    case MONO10_PACKED: return unpack_gige_scalar<10>;
+    case MONO12_PACKED: return unpack_gige_scalar<12>;
+  }
+  return NULL;
+}
+
+/** @brief Fastest kernel for a format on the running CPU */
+PixelUnpack::Kernel PixelUnpack::kernel(Format format)
+{
+  return kernel(format, best_isa());
+}
+
+} // namespace FrameProcessor
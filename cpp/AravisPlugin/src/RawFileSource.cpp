@@ -0,0 +1,118 @@
+/**
+ * @file RawFileSource.cpp
+ * @brief Memory mapped file of raw frames replayed by the virtual camera
+ * @date 2026-10-15
+ */
+
+#include "RawFileSource.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace FrameProcessor
+{
+
+RawFileSource::RawFileSource() :
+  base_(NULL),
+  size_(0),
+  frame_bytes_(0),
+  n_frames_(0)
+{
+}
+
+RawFileSource::~RawFileSource()
+{
+  close();
+}
+
+/** @brief Maps a file of frames, replacing any previous one
+ *
+ * @param path file to map
+ * @param frame_bytes size of one frame in bytes
+ * @param[out] error description of the failure
+ * @return false if the file could not be mapped or holds less than one frame
+ */
+bool RawFileSource::open(const std::string& path, size_t frame_bytes, std::string& error)
+{
+  close();
+
+  if(frame_bytes == 0){
+    error = "Cannot replay " + path + " without a frame size";
+    return false;
+  }
+
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0){
+    error = "Failed to open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+
+  struct stat file_stat;
+  if(fstat(fd, &file_stat) != 0){
+    error = "Failed to read the size of " + path + ": " + std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  if(size < frame_bytes){
+    error = path + " holds " + std::to_string(size) + " bytes, less than one frame of " + std::to_string(frame_bytes) + " bytes";
+    ::close(fd);
+    return false;
+  }
+
+  void *base = mmap(NULL, size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+  ::close(fd);
+  if(base == MAP_FAILED){
+    error = "Failed to map " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  madvise(base, size, MADV_SEQUENTIAL);
+
+  base_ = base;
+  size_ = size;
+  frame_bytes_ = frame_bytes;
+  n_frames_ = size / frame_bytes;
+  return true;
+}
+
+/** @brief Unmaps the file */
+void RawFileSource::close()
+{
+  if(base_ != NULL)
+    munmap(base_, size_);
+  base_ = NULL;
+  size_ = 0;
+  frame_bytes_ = 0;
+  n_frames_ = 0;
+}
+
+/** @brief Is a file mapped? */
+bool RawFileSource::is_open() const
+{
+  return base_ != NULL;
+}
+
+/** @brief Number of whole frames in the file */
+size_t RawFileSource::n_frames() const
+{
+  return n_frames_;
+}
+
+/** @brief Size of each frame in bytes */
+size_t RawFileSource::frame_bytes() const
+{
+  return frame_bytes_;
+}
+
+/** @brief Start of frame index, which must be below n_frames() */
+const void *RawFileSource::frame(size_t index) const
+{
+  return static_cast<const char*>(base_) + index * frame_bytes_;
+}
+
+} // namespace FrameProcessor
@@ -0,0 +1,117 @@
+/**
+ * @file ClockMapperBenchmark.cpp
+ * @brief Checks the clock mapper against a simulated drifting camera clock
+ * @date 2026-10-16
+ *
+ * Feeds the mapper camera and host timestamps of a simulated camera whose clock
+ * drifts against the host, with a fixed transfer delay plus an exponential one, and
+ * prints one JSON object per case with how late the mapped times are against the
+ * true capture times, the drift found and the cost of a pair. A case also delays
+ * whole blocks, each of which has to be skipped as an outlier, or steps the host
+ * clock, which has to start exactly one new fit. Exits with 1 when a case misses its
+ * limits.
+ *
+ * Usage: ClockMapperBenchmark [frames] [drift_ppm] [mean_delay_us]
+ */
+
+#include "ClockMapper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace FrameProcessor;
+
+/** One simulated acquisition */
+struct Case
+{
+  const char *name;
+  int late_block_every;                                 ///< every nth block is delayed once the fit has settled, 0 for none
+  double host_step_ns;                                  ///< host clock step half way through
+  uint64_t expected_resets;
+};
+
+static const size_t WINDOW = 1000;
+static const double FRAME_RATE_HZ = 100;
+static const double MIN_DELAY_NS = 200e3;               ///< transfer delay every frame has
+static const double LATE_BLOCK_NS = 20e6;               ///< extra delay of a late block
+static const double MAX_LATE_NS = 1e6;                  ///< mapped times may be this much later than the capture
+static const double MAX_DRIFT_ERROR_PPM = 2;
+
+int main(int argc, char **argv)
+{
+  int frames = argc > 1 ? std::atoi(argv[1]) : 30000;
+  double drift_ppm = argc > 2 ? std::atof(argv[2]) : 50;
+  double mean_delay_ns = (argc > 3 ? std::atof(argv[3]) : 2700) * 1e3;
+
+  const Case cases[] = {
+    {"drift", 0, 0, 0},
+    {"late_blocks", 7, 0, 0},
+    {"host_step", 0, 50e6, 1},
+  };
+  // the mapper splits the window into blocks of this many frames
+  const int block_size = WINDOW / 16;
+  const uint64_t camera0 = 123456789000ull, host0 = 1700000000000000000ull;
+  int status = 0;
+
+  for(const Case& test : cases){
+    std::mt19937_64 generator(1);
+    std::exponential_distribution<double> delay(1 / mean_delay_ns);
+    ClockMapper mapper;
+    mapper.set_window(WINDOW);
+
+    // lateness is measured over the last quarter, once the fit has settled again after any step
+    double late_sum = 0, late_max = 0;
+    int late_count = 0;
+    uint64_t late_blocks = 0;
+    double seconds = 0;
+
+    for(int i = 0; i < frames; i++){
+      double t = i / FRAME_RATE_HZ * 1e9;
+      uint64_t camera_ns = camera0 + static_cast<uint64_t>(t);
+      double capture_ns = host0 + t * (1 + drift_ppm * 1e-6);
+      if(i > frames / 2)
+        capture_ns += test.host_step_ns;
+      double received_ns = capture_ns + MIN_DELAY_NS + delay(generator);
+      int block = i / block_size;
+      if(test.late_block_every && i >= static_cast<int>(2 * WINDOW) && block % test.late_block_every == 0){
+        received_ns += LATE_BLOCK_NS;
+        // a block is only judged once its last pair is in
+        if(i % block_size == block_size - 1)
+          late_blocks++;
+      }
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      mapper.add(camera_ns, static_cast<uint64_t>(received_ns));
+      uint64_t mapped_ns = mapper.map(camera_ns);
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      if(i > frames * 3 / 4 && mapped_ns){
+        double late = static_cast<double>(static_cast<int64_t>(mapped_ns - static_cast<uint64_t>(capture_ns)));
+        late_sum += late;
+        late_max = std::max(late_max, std::fabs(late));
+        late_count++;
+      }
+    }
+
+    ClockMapper::Estimate estimate = mapper.estimate();
+    double mean_late = late_count ? late_sum / late_count : 0;
+    bool pass = late_count > 0 && estimate.ready && std::fabs(mean_late) < MAX_LATE_NS &&
+                std::fabs(estimate.drift_ppm - drift_ppm) < MAX_DRIFT_ERROR_PPM &&
+                estimate.resets == test.expected_resets && estimate.outliers >= late_blocks;
+    if(!pass)
+      status = 1;
+
+    std::printf("{\"case\": \"%s\", \"frames\": %d, \"mean_late_us\": %.1f, \"max_late_us\": %.1f, "
+                "\"drift_ppm\": %.2f, \"jitter_us\": %.1f, \"late_blocks\": %llu, \"outliers\": %llu, \"resets\": %llu, "
+                "\"ns_per_pair\": %.1f, \"pass\": %s}\n",
+                test.name, frames, mean_late / 1e3, late_max / 1e3,
+                estimate.drift_ppm, estimate.jitter_ns / 1e3,
+                static_cast<unsigned long long>(late_blocks), static_cast<unsigned long long>(estimate.outliers), static_cast<unsigned long long>(estimate.resets),
+                seconds / frames * 1e9, pass ? "true" : "false");
+  }
+  return status;
+}
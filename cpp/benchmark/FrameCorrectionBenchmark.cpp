@@ -0,0 +1,77 @@
+/**
+ * @file FrameCorrectionBenchmark.cpp
+ * @brief Measures single core throughput of the dark and flat field correction kernels
+ * @date 2026-10-15
+ *
+ * Corrects a full frame repeatedly with every kernel the CPU supports and prints
+ * one JSON object per depth and instruction set with the throughput in megapixels
+ * per second. The maps are chosen so some pixels saturate at both ends. Every vector
+ * kernel is also checked against the scalar kernel first.
+ *
+ * Usage: FrameCorrectionBenchmark [width] [height] [iterations]
+ */
+
+#include "FrameCorrection.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace FrameProcessor;
+
+int main(int argc, char **argv)
+{
+  size_t width = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2448;
+  size_t height = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 2048;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+  size_t n_pixels = width * height;
+
+  const FrameCorrection::Depth depths[] = {FrameCorrection::DEPTH_8, FrameCorrection::DEPTH_16};
+  const char *depth_names[] = {"8bit", "16bit"};
+  const size_t pixel_bytes[] = {1, 2};
+  const PixelUnpack::Isa isas[] = {PixelUnpack::ISA_SCALAR, PixelUnpack::ISA_SSE41, PixelUnpack::ISA_AVX2};
+  PixelUnpack::Isa best = PixelUnpack::best_isa();
+
+  std::mt19937 generator(42);
+  std::vector<float> dark(n_pixels), gain(n_pixels);
+  for(size_t i = 0; i < n_pixels; i++){
+    dark[i] = std::uniform_real_distribution<float>(0, 40)(generator);
+    gain[i] = std::uniform_real_distribution<float>(0.5f, 2.5f)(generator);
+  }
+  int status = 0;
+
+  for(int d = 0; d < 2; d++){
+    size_t n_bytes = n_pixels * pixel_bytes[d];
+    std::vector<uint8_t> raw(n_bytes), reference(n_bytes), output(n_bytes);
+    for(size_t i = 0; i < n_bytes; i++)
+      raw[i] = static_cast<uint8_t>(generator());
+
+    FrameCorrection::kernel(depths[d], PixelUnpack::ISA_SCALAR)(raw.data(), reference.data(), dark.data(), gain.data(), n_pixels);
+
+    for(PixelUnpack::Isa isa : isas){
+      if(isa > best)
+        continue;
+      FrameCorrection::Kernel kernel = FrameCorrection::kernel(depths[d], isa);
+
+      std::fill(output.begin(), output.end(), 0xAA);
+      kernel(raw.data(), output.data(), dark.data(), gain.data(), n_pixels);
+      bool match = std::memcmp(output.data(), reference.data(), n_bytes) == 0;
+      if(!match)
+        status = 1;
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for(int i = 0; i < iterations; i++)
+        kernel(raw.data(), output.data(), dark.data(), gain.data(), n_pixels);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::printf("{\"depth\": \"%s\", \"isa\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                  "\"mpixel_per_s\": %.1f, \"matches_scalar\": %s}\n",
+                  depth_names[d], PixelUnpack::isa_name(isa), width, height,
+                  n_pixels * iterations / seconds / 1e6, match ? "true" : "false");
+    }
+  }
+  return status;
+}
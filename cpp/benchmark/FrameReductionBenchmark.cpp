@@ -0,0 +1,93 @@
+/**
+ * @file FrameReductionBenchmark.cpp
+ * @brief Measures single core throughput of the region of interest and binning kernels
+ * @date 2026-10-15
+ *
+ * Reduces a full frame repeatedly with a few binning settings and every row kernel
+ * the CPU supports, and prints one JSON object per case and instruction set with the
+ * throughput in megapixels of source image per second. Every vector kernel is also
+ * checked against the scalar kernel first.
+ *
+ * Usage: FrameReductionBenchmark [width] [height] [iterations]
+ */
+
+#include "FrameReduction.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace FrameProcessor;
+
+/** One binning setting to measure */
+struct Case
+{
+  const char *name;
+  size_t bytes_per_pixel;
+  unsigned int bin_x;
+  unsigned int bin_y;
+  FrameReduction::Mode mode;
+};
+
+int main(int argc, char **argv)
+{
+  size_t width = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2448;
+  size_t height = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 2048;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+  size_t n_pixels = width * height;
+
+  const Case cases[] = {
+    {"8bit_2x2_sum", 1, 2, 2, FrameReduction::BIN_SUM},
+    {"8bit_4x4_mean", 1, 4, 4, FrameReduction::BIN_MEAN},
+    {"16bit_2x2_sum", 2, 2, 2, FrameReduction::BIN_SUM},
+    {"16bit_3x1_mean", 2, 3, 1, FrameReduction::BIN_MEAN},
+  };
+  const PixelUnpack::Isa isas[] = {PixelUnpack::ISA_SCALAR, PixelUnpack::ISA_SSE41, PixelUnpack::ISA_AVX2};
+  PixelUnpack::Isa best = PixelUnpack::best_isa();
+
+  std::mt19937 generator(42);
+  std::vector<uint8_t> image(n_pixels * 2);
+  for(size_t i = 0; i < image.size(); i++)
+    image[i] = static_cast<uint8_t>(generator());
+  int status = 0;
+
+  for(const Case& test : cases){
+    // a region one pixel in from each edge, so the rows do not start aligned
+    FrameReduction::Settings settings = {1, 1, width - 2, height - 2, test.bin_x, test.bin_y, test.mode};
+    std::vector<uint8_t> reference, output;
+
+    for(PixelUnpack::Isa isa : isas){
+      if(isa > best)
+        continue;
+      FrameReduction reduction;
+      reduction.configure(settings, test.bytes_per_pixel, isa);
+      std::string error;
+      if(!reduction.fit(height, width, error)){
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+      }
+
+      output.assign(reduction.frame_bytes(), 0xAA);
+      reduction.reduce(image.data(), output.data());
+      if(isa == PixelUnpack::ISA_SCALAR)
+        reference = output;
+      bool match = output == reference;
+      if(!match)
+        status = 1;
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for(int i = 0; i < iterations; i++)
+        reduction.reduce(image.data(), output.data());
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::printf("{\"case\": \"%s\", \"isa\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                  "\"mpixel_per_s\": %.1f, \"matches_scalar\": %s}\n",
+                  test.name, PixelUnpack::isa_name(isa), width, height,
+                  n_pixels * iterations / seconds / 1e6, match ? "true" : "false");
+    }
+  }
+  return status;
+}
@@ -0,0 +1,96 @@
+/**
+ * @file ImageStatisticsBenchmark.cpp
+ * @brief Measures single core throughput of the image statistics pass
+ * @date 2026-10-16
+ *
+ * Measures a full frame repeatedly at each depth with every row kernel the CPU
+ * supports, and prints one JSON object per case and instruction set with the
+ * throughput in megapixels per second. Every vector kernel is also checked against
+ * the scalar kernel first.
+ *
+ * Usage: ImageStatisticsBenchmark [width] [height] [iterations]
+ */
+
+#include "ImageStatistics.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace FrameProcessor;
+
+/** One depth and histogram size to measure */
+struct Case
+{
+  const char *name;
+  size_t bytes_per_pixel;
+  unsigned int histogram_bins;
+};
+
+static bool same_result(const ImageStatistics::Result& a, const ImageStatistics::Result& b)
+{
+  return a.sum == b.sum && a.min == b.min && a.max == b.max &&
+         a.centroid_x == b.centroid_x && a.centroid_y == b.centroid_y &&
+         a.rms_x == b.rms_x && a.rms_y == b.rms_y;
+}
+
+int main(int argc, char **argv)
+{
+  // an odd width, so every kernel also runs its tail
+  size_t width = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2447;
+  size_t height = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 2048;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+  size_t n_pixels = width * height;
+
+  const Case cases[] = {
+    {"8bit_no_histogram", 1, 0},
+    {"8bit_16_bins", 1, 16},
+    {"16bit_no_histogram", 2, 0},
+    {"16bit_256_bins", 2, 256},
+  };
+  const PixelUnpack::Isa isas[] = {PixelUnpack::ISA_SCALAR, PixelUnpack::ISA_SSE41, PixelUnpack::ISA_AVX2};
+  PixelUnpack::Isa best = PixelUnpack::best_isa();
+
+  std::mt19937 generator(42);
+  std::vector<uint8_t> image(n_pixels * 2);
+  for(size_t i = 0; i < image.size(); i++)
+    image[i] = static_cast<uint8_t>(generator());
+  int status = 0;
+
+  for(const Case& test : cases){
+    ImageStatistics::Result reference = {}, result = {};
+    std::vector<uint32_t> reference_histogram;
+
+    for(PixelUnpack::Isa isa : isas){
+      if(isa > best)
+        continue;
+      ImageStatistics statistics;
+      if(!statistics.configure(test.bytes_per_pixel, test.histogram_bins, isa)){
+        std::fprintf(stderr, "Cannot configure %s\n", test.name);
+        return 1;
+      }
+
+      statistics.measure(image.data(), height, width, result);
+      if(isa == PixelUnpack::ISA_SCALAR){
+        reference = result;
+        reference_histogram = statistics.histogram();
+      }
+      bool match = same_result(result, reference) && statistics.histogram() == reference_histogram;
+      if(!match)
+        status = 1;
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for(int i = 0; i < iterations; i++)
+        statistics.measure(image.data(), height, width, result);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::printf("{\"case\": \"%s\", \"isa\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                  "\"mpixel_per_s\": %.1f, \"centroid_x\": %.3f, \"rms_x\": %.3f, \"matches_scalar\": %s}\n",
+                  test.name, PixelUnpack::isa_name(isa), width, height,
+                  n_pixels * iterations / seconds / 1e6, result.centroid_x, result.rms_x, match ? "true" : "false");
+    }
+  }
+  return status;
+}
@@ -0,0 +1,74 @@
+/**
+ * @file PixelUnpackBenchmark.cpp
+ * @brief Measures single core throughput of the packed pixel unpack kernels
+ * @date 2026-10-15
+ *
+ * Unpacks a full frame repeatedly with every kernel the CPU supports and prints
+ * one JSON object per format and instruction set with the throughput in GB/s of
+ * packed input and in megapixels per second. Every vector kernel is also checked
+ * against the scalar kernel first.
+ *
+ * Usage: PixelUnpackBenchmark [width] [height] [iterations]
+ */
+
+#include "PixelUnpack.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace FrameProcessor;
+
+int main(int argc, char **argv)
+{
+  size_t width = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2448;
+  size_t height = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 2048;
+  int iterations = argc > 3 ? std::atoi(argv[3]) : 200;
+  size_t n_pixels = width * height;
+
+  const PixelUnpack::Format formats[] = {PixelUnpack::MONO10_P, PixelUnpack::MONO12_P,
+                                         PixelUnpack::MONO10_PACKED, PixelUnpack::MONO12_PACKED};
+  const char *format_names[] = {"Mono10p", "Mono12p", "Mono10Packed", "Mono12Packed"};
+  const PixelUnpack::Isa isas[] = {PixelUnpack::ISA_SCALAR, PixelUnpack::ISA_SSE41, PixelUnpack::ISA_AVX2};
+  PixelUnpack::Isa best = PixelUnpack::best_isa();
+
+  std::mt19937 generator(42);
+  std::vector<uint16_t> reference(n_pixels), output(n_pixels);
+  int status = 0;
+
+  for(int f = 0; f < 4; f++){
+    size_t n_bytes = PixelUnpack::packed_bytes(formats[f], n_pixels);
+    std::vector<uint8_t> packed(n_bytes);
+    for(size_t i = 0; i < n_bytes; i++)
+      packed[i] = static_cast<uint8_t>(generator());
+
+    PixelUnpack::kernel(formats[f], PixelUnpack::ISA_SCALAR)(packed.data(), reference.data(), n_pixels);
+
+    for(PixelUnpack::Isa isa : isas){
+      if(isa > best)
+        continue;
+      PixelUnpack::Kernel kernel = PixelUnpack::kernel(formats[f], isa);
+
+      std::fill(output.begin(), output.end(), 0xFFFF);
+      kernel(packed.data(), output.data(), n_pixels);
+      bool match = std::memcmp(output.data(), reference.data(), n_pixels * sizeof(uint16_t)) == 0;
+      if(!match)
+        status = 1;
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      for(int i = 0; i < iterations; i++)
+        kernel(packed.data(), output.data(), n_pixels);
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+      std::printf("{\"format\": \"%s\", \"isa\": \"%s\", \"width\": %zu, \"height\": %zu, "
+                  "\"input_gb_per_s\": %.3f, \"mpixel_per_s\": %.1f, \"matches_scalar\": %s}\n",
+                  format_names[f], PixelUnpack::isa_name(isa), width, height,
+                  n_bytes * iterations / seconds / 1e9, n_pixels * iterations / seconds / 1e6,
+                  match ? "true" : "false");
+    }
+  }
+  return status;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file StreamBenchmark.cpp
+ * @brief Measures sustained frame rate, CPU cost and latency of the plugin against a fake camera
+ * @date 2026-10-15
+ *
+ * Connects an AravisDetectorPlugin to Aravis' fake camera and streams for a fixed
+ * time at every combination of image size, pixel format and frame rate given. A
+ * blocking sink plugin is registered downstream, so a frame reaches the sink when
+ * push() is called and the latency measured is from the host receiving the buffer
+ * (the system_timestamp frame parameter) to the frame leaving the plugin.
+ *
+ * One JSON object is printed per run with the requested and achieved frame rate,
+ * process CPU time per frame, p50/p99/p999 latency and the stream's underrun and
+ * failed buffer counts (these include the warmup).
+ *
+ * By default the in process fake camera (Fake_1) is used, which also spends CPU
+ * filling its own buffers. Pass the name of a running arv-fake-gv-camera to go
+ * through the GigE Vision stream instead.
+ *
+ * Usage: StreamBenchmark [--camera Fake_1] [--sizes 512x512,1024x1024] [--formats Mono8,Mono16]
+ *                        [--rates 50,100] [--duration 5] [--warmup 1]
+ */
+
+#include "AravisDetectorPlugin.h"
+
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <sys/resource.h>
+#include <vector>
+
+using namespace FrameProcessor;
+namespace po = boost::program_options;
+
+/** @brief Downstream plugin that records when each frame arrives */
+class LatencySink : public FrameProcessorPlugin
+{
+
+public:
+
+  /** @brief Drops the samples of the previous run */
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_ns_.clear();
+    n_frames_ = 0;
+  }
+
+  /** @brief Number of frames received and their latencies since the last reset */
+  size_t collect(std::vector<uint64_t>& latencies_ns)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    latencies_ns = latencies_ns_;
+    return n_frames_;
+  }
+
+  int get_version_major() { return 0; }
+  int get_version_minor() { return 0; }
+  int get_version_patch() { return 0; }
+  std::string get_version_short() { return ""; }
+  std::string get_version_long() { return ""; }
+
+private:
+
+  void process_frame(boost::shared_ptr<Frame> frame)
+  {
+    uint64_t now = static_cast<uint64_t>(g_get_real_time()) * 1000;
+    std::lock_guard<std::mutex> lock(mutex_);
+    n_frames_++;
+    if(frame->meta_data().has_parameter(AravisDetectorPlugin::PARAM_SYSTEM_TIMESTAMP)){
+      uint64_t received = frame->meta_data().get_parameter<uint64_t>(AravisDetectorPlugin::PARAM_SYSTEM_TIMESTAMP);
+      if(now > received)
+        latencies_ns_.push_back(now - received);
+    }
+  }
+
+  std::mutex mutex_;
+  std::vector<uint64_t> latencies_ns_;
+  size_t n_frames_ {0};
+};
+
+/** @brief Value below which the given fraction of the sorted samples lie, in microseconds */
+static double percentile_us(const std::vector<uint64_t>& sorted, double fraction)
+{
+  if(sorted.empty())
+    return 0;
+  size_t index = std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()));
+  return sorted[index] / 1e3;
+}
+
+/** @brief User plus system CPU time of the whole process in seconds */
+static double process_cpu_seconds()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}
+
+/** @brief Sends a single configuration value to the plugin */
+template <typename T>
+static void configure(AravisDetectorPlugin& plugin, const std::string& name, const T& value)
+{
+  OdinData::IpcMessage config, reply;
+  config.set_param(name, value);
+  plugin.configure(config, reply);
+}
+
+int main(int argc, char **argv)
+{
+  std::string camera, sizes, formats, rates;
+  double duration, warmup;
+
+  po::options_description options("StreamBenchmark options");
+  options.add_options()
+    ("help,h", "Print this help message")
+    ("camera", po::value<std::string>(&camera)->default_value("Fake_1"), "Camera to connect to, Fake_1 is the in process fake camera")
+    ("sizes", po::value<std::string>(&sizes)->default_value("512x512,1024x1024,2048x2048"), "Comma separated image sizes, WIDTHxHEIGHT")
+    ("formats", po::value<std::string>(&formats)->default_value("Mono8,Mono16"), "Comma separated pixel formats")
+    ("rates", po::value<std::string>(&rates)->default_value("50,100,200"), "Comma separated frame rates in Hz")
+    ("duration", po::value<double>(&duration)->default_value(5), "Measured time per run in seconds")
+    ("warmup", po::value<double>(&warmup)->default_value(1), "Time streamed before measuring in seconds");
+
+  po::variables_map vm;
+  po::store(po::parse_command_line(argc, argv, options), vm);
+  po::notify(vm);
+  if(vm.count("help")){
+    std::cout << options << std::endl;
+    return 0;
+  }
+
+  if(boost::starts_with(camera, "Fake"))
+    arv_enable_interface("Fake");
+
+  boost::shared_ptr<AravisDetectorPlugin> plugin(new AravisDetectorPlugin());
+  boost::shared_ptr<LatencySink> sink(new LatencySink());
+  plugin->set_name("camera");
+  sink->set_name("sink");
+  plugin->register_callback("sink", sink, true);
+
+  // every step below expects the previous one to have finished
+  configure(*plugin, AravisDetectorPlugin::CONFIG_ASYNC_COMMANDS, false);
+  configure(*plugin, AravisDetectorPlugin::CONFIG_CAMERA_IP, camera);
+  {
+    OdinData::IpcMessage status;
+    plugin->status(status);
+    if(!status.get_param<bool>("camera/camera_connected")){
+      std::fprintf(stderr, "Could not connect to camera %s\n", camera.c_str());
+      return 1;
+    }
+  }
+
+  std::vector<std::string> size_list, format_list, rate_list;
+  boost::split(size_list, sizes, boost::is_any_of(","));
+  boost::split(format_list, formats, boost::is_any_of(","));
+  boost::split(rate_list, rates, boost::is_any_of(","));
+
+  for(const std::string& size : size_list){
+    int width = 0, height = 0;
+    if(std::sscanf(size.c_str(), "%dx%d", &width, &height) != 2){
+      std::fprintf(stderr, "Invalid size %s, expected WIDTHxHEIGHT\n", size.c_str());
+      return 1;
+    }
+    for(const std::string& format : format_list){
+      for(const std::string& rate : rate_list){
+        double frame_rate = std::stod(rate);
+
+        configure(*plugin, AravisDetectorPlugin::CONFIG_IMAGE_WIDTH, width);
+        configure(*plugin, AravisDetectorPlugin::CONFIG_IMAGE_HEIGHT, height);
+        configure(*plugin, AravisDetectorPlugin::CONFIG_PIXEL_FORMAT, format);
+        configure(*plugin, AravisDetectorPlugin::CONFIG_FRAME_RATE, frame_rate);
+
+        configure(*plugin, AravisDetectorPlugin::START_STREAM, true);
+        boost::this_thread::sleep(boost::posix_time::microseconds(static_cast<long>(warmup * 1e6)));
+
+        // frames, cpu and latency cover the measured window, buffer statistics the whole stream
+        plugin->reset_statistics();
+        sink->reset();
+        double cpu_start = process_cpu_seconds();
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+        boost::this_thread::sleep(boost::posix_time::microseconds(static_cast<long>(duration * 1e6)));
+
+        std::vector<uint64_t> latencies_ns;
+        size_t n_frames = sink->collect(latencies_ns);
+        double cpu_seconds = process_cpu_seconds() - cpu_start;
+        double seconds = (boost::posix_time::microsec_clock::universal_time() - start).total_microseconds() / 1e6;
+
+        // stream statistics are refreshed by the status thread, so read them before stopping
+        OdinData::IpcMessage status;
+        plugin->status(status);
+        configure(*plugin, AravisDetectorPlugin::STOP_STREAM, true);
+
+        std::sort(latencies_ns.begin(), latencies_ns.end());
+        std::printf("{\"camera\": \"%s\", \"width\": %d, \"height\": %d, \"pixel_format\": \"%s\", "
+                    "\"requested_fps\": %.1f, \"fps\": %.2f, \"frames\": %zu, \"cpu_us_per_frame\": %.2f, "
+                    "\"latency_p50_us\": %.1f, \"latency_p99_us\": %.1f, \"latency_p999_us\": %.1f, "
+                    "\"underrun_buffers\": %lu, \"failed_buffers\": %lu}\n",
+                    camera.c_str(), width, height, format.c_str(),
+                    frame_rate, n_frames / seconds, n_frames, n_frames ? cpu_seconds * 1e6 / n_frames : 0.0,
+                    percentile_us(latencies_ns, 0.5), percentile_us(latencies_ns, 0.99), percentile_us(latencies_ns, 0.999),
+                    static_cast<unsigned long>(status.get_param<uint64_t>("camera/underrun_buff")),
+                    static_cast<unsigned long>(status.get_param<uint64_t>("camera/failed_buff")));
+        std::fflush(stdout);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,68 @@
+#
+# Tries to find the Blosc compression library headers and libraries.
+#
+# Usage of this module as follows:
+#
+#  find_package(BLOSC)
+#
+# Variables used by this module, they can change the default behaviour and need
+# to be set before calling find_package:
+#
+#  BLOSC_ROOT_DIR  Set this variable to the root installation of
+#                  Blosc if the module has problems finding
+#                  the proper installation path.
+#
+# Variables defined by this module:
+#
+#  BLOSC_FOUND              System has Blosc libs/headers
+#  BLOSC_LIBRARIES          The Blosc libraries
+#  BLOSC_INCLUDE_DIRS       The location of Blosc headers
+
+message ("\nLooking for blosc headers and libraries")
+
+if (BLOSC_ROOT_DIR)
+    message (STATUS "Root dir: ${BLOSC_ROOT_DIR}")
+endif ()
+
+find_package(PkgConfig)
+IF (PkgConfig_FOUND)
+    pkg_check_modules(PC_BLOSC blosc)
+ENDIF(PkgConfig_FOUND)
+
+find_path(BLOSC_INCLUDE_DIR
+    NAMES
+        blosc.h
+    PATHS
+        ${BLOSC_ROOT_DIR}/include
+        ${PC_BLOSC_INCLUDEDIR}
+        ${PC_BLOSC_INCLUDE_DIRS}
+)
+
+find_library(BLOSC_LIBRARY
+    NAMES
+        blosc
+    PATHS
+        ${BLOSC_ROOT_DIR}/lib
+        ${PC_BLOSC_LIBDIR}
+        ${PC_BLOSC_LIBRARY_DIRS}
+)
+
+include(FindPackageHandleStandardArgs)
+
+# handle the QUIETLY and REQUIRED arguments and set BLOSC_FOUND to TRUE
+# if all listed variables are TRUE
+find_package_handle_standard_args(BLOSC
+    DEFAULT_MSG
+    BLOSC_LIBRARY
+    BLOSC_INCLUDE_DIR
+)
+
+mark_as_advanced(BLOSC_INCLUDE_DIR BLOSC_LIBRARY)
+
+if (BLOSC_FOUND)
+    set(BLOSC_INCLUDE_DIRS ${BLOSC_INCLUDE_DIR})
+    set(BLOSC_LIBRARIES ${BLOSC_LIBRARY})
+
+    message (STATUS "Include directories: ${BLOSC_INCLUDE_DIRS}")
+    message (STATUS "Libraries: ${BLOSC_LIBRARIES}")
+endif ()